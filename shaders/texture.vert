@@ -5,8 +5,14 @@ layout(location = 1) in vec2 texCoord;
 
 layout(location = 0) out vec2 texCoord_out;
 
+// matches Camera, pushed with every draw
+layout(push_constant) uniform CameraConstants {
+  vec2 pos;
+  float scale;
+} camera;
+
 void main() {
-  gl_Position = vec4(inPosition, 0.0, 1.0);
+  gl_Position = vec4((inPosition - camera.pos) * camera.scale, 0.0, 1.0);
   texCoord_out = texCoord;
 }
 
@@ -8,6 +8,12 @@ void Application::Run() {
   MainLoop();
 }
 
+void Application::RunRecordBenchmark() {
+  Prepare();
+
+  BenchmarkRecording();
+}
+
 void Application::Prepare() { VulkanApplication::Prepare(); }
 
 void Application::MainLoop() {
@@ -16,6 +22,8 @@ void Application::MainLoop() {
   while (!window->ShouldClose()) {
     Update();
 
+    // recorded by ui pass of the frame
+    RenderUI();
     Draw();
   }
 }
@@ -92,9 +100,101 @@ void Application::RenderUI() {
 
   ImGui::Text("test text");
 
+  RenderShaderErrors();
+  RenderFrameStatistics();
+  RenderMemoryStatistics();
+
   ImGui::End();
 
   ImGui::Render();
 
   first_call = false;
 }
+
+void Application::RenderShaderErrors() {
+  // shown until shader compiles, old pipelines are used meanwhile
+  for (vk::ShaderError &error : GetShaderErrors()) {
+    ImGui::TextColored({1, 0.3f, 0.3f, 1}, "%s:",
+                       error.source.string().c_str());
+    ImGui::TextWrapped("%s", error.message.c_str());
+  }
+}
+
+void Application::RenderFrameStatistics() {
+  if (!ImGui::CollapsingHeader("frames")) {
+    return;
+  }
+
+  const FrameStatistics &statistics = GetFrameStatistics();
+
+  ImGui::Text("frames in flight: %u", GetFramesInFlight());
+  ImGui::Text("shader reloads: %u", GetShaderReloadCount());
+  ImGui::Text("frames: %llu", (unsigned long long)statistics.frame_count);
+  ImGui::Text("gpu wait: %.3f ms, average %.3f ms, max %.3f ms",
+              statistics.last_gpu_wait, statistics.average_gpu_wait,
+              statistics.max_gpu_wait);
+  ImGui::Text("recording: %.3f ms, average %.3f ms on %u threads",
+              statistics.last_record_time, statistics.average_record_time,
+              statistics.record_threads);
+
+  const vk::RenderGraphStatistics &graph_statistics =
+      GetRenderGraphStatistics();
+
+  ImGui::Text("passes: %u, culled %u", graph_statistics.pass_count,
+              graph_statistics.culled_pass_count);
+  ImGui::Text("barriers: %u in %u batches", graph_statistics.barrier_count,
+              graph_statistics.barrier_batch_count);
+  ImGui::Text("transient images: %.2f mb aliased in %.2f mb",
+              graph_statistics.transient_size / (1024.0f * 1024.0f),
+              graph_statistics.aliased_size / (1024.0f * 1024.0f));
+}
+
+void Application::RenderMemoryStatistics() {
+  if (!ImGui::CollapsingHeader("memory")) {
+    return;
+  }
+
+  constexpr float mb = 1024 * 1024;
+
+  vk::MemoryStatistics &statistics = GetMemoryStatistics();
+
+  ImGui::Text("budget source: %s", statistics.IsBudgetSupported()
+                                       ? "VK_EXT_memory_budget"
+                                       : "own bookkeeping");
+
+  const vector<vk::HeapStatistics> &heaps = statistics.GetHeaps();
+  for (uint32_t i = 0; i < heaps.size(); i++) {
+    const vk::HeapStatistics &heap = heaps[i];
+
+    ImGui::Text("heap %u (%s): %.1f / %.1f mb, allocated %.1f mb, peak %.1f mb",
+                i, heap.device_local ? "device" : "host", heap.usage / mb,
+                heap.budget / mb, heap.allocated / mb,
+                heap.peak_allocated / mb);
+    ImGui::ProgressBar(heap.budget ? (float)heap.usage / heap.budget : 0);
+  }
+
+  ImGui::Separator();
+
+  for (uint32_t i = 0; i < vk::memory_category_count; i++) {
+    vk::MemoryCategory category = (vk::MemoryCategory)i;
+    const vk::CategoryStatistics &category_statistics =
+        statistics.GetCategory(category);
+
+    ImGui::Text("%s: %u allocations, %.2f mb, peak %.2f mb",
+                vk::MemoryStatistics::GetCategoryName(category),
+                category_statistics.allocation_count,
+                category_statistics.used / mb,
+                category_statistics.peak_used / mb);
+  }
+
+  ImGui::Separator();
+
+  float histogram[vk::memory_histogram_size];
+  for (uint32_t i = 0; i < vk::memory_histogram_size; i++) {
+    histogram[i] = statistics.GetHistogramCount(i);
+  }
+
+  ImGui::PlotHistogram("allocation sizes", histogram,
+                       vk::memory_histogram_size, 0,
+                       "4 kb .. 512 mb and more", 0, FLT_MAX, {0, 80});
+}
@@ -43,6 +43,9 @@ private:
   void ProcessMouseButtonEvent(MouseButtonEvent event);
 
   void RenderUI();
+  void RenderShaderErrors();
+  void RenderFrameStatistics();
+  void RenderMemoryStatistics();
 
 public:
   Application() = default;
@@ -51,4 +54,7 @@ public:
   ~Application();
 
   void Run();
+  // logs surface layer recording times for 1 to 16 threads and returns,
+  // nothing is submitted to gpu
+  void RunRecordBenchmark();
 };
@@ -23,7 +23,6 @@ ImguiRenderer::~ImguiRenderer() {
   ImGui::DestroyContext();
 
   one_time_command_buffer->Dispose();
-  render_command_buffer->Dispose();
   imgui_command_pool->Dispose();
 
   vkDestroyDescriptorPool(device->GetHandle(), imgui_descriptor_pool, nullptr);
@@ -36,11 +35,10 @@ void ImguiRenderer::Init() {
 }
 
 void ImguiRenderer::InitImgui() {
-  imgui_command_pool = make_unique<vk::CommandPool>(*device, queue, 2);
+  // font upload only, ui is recorded into frame command buffer
+  imgui_command_pool = make_unique<vk::CommandPool>(*device, queue, 1);
   one_time_command_buffer = imgui_command_pool->AllocateCommandBuffer(
       vk::CommandBufferLevel::primary);
-  render_command_buffer = imgui_command_pool->AllocateCommandBuffer(
-      vk::CommandBufferLevel::primary);
 
   ImGui::CreateContext();
   //  ImGui::GetIO().ConfigFlags |= ImGuiConfigFlags;
@@ -58,7 +56,7 @@ void ImguiRenderer::InitImgui() {
   init_info.Device = device->GetHandle();
   init_info.QueueFamily = queue.GetFamily();
   init_info.Queue = queue.GetHandle();
-  init_info.PipelineCache = nullptr;
+  init_info.PipelineCache = device->GetPipelineCache().GetHandle();
   init_info.DescriptorPool = imgui_descriptor_pool;
   init_info.Subpass = 0;
   init_info.MinImageCount = swapchain_min_image_count;
@@ -113,10 +111,18 @@ void ImguiRenderer::CreateImguiDescriptorPool() {
   DEBUG("imgui descriptor pool created");
 }
 
-void ImguiRenderer::CreateCommandBuffer(uint32_t image_index) {
-  render_command_buffer->Begin();
+void ImguiRenderer::SetFramebuffers(vector<VkFramebuffer> &framebuffers,
+                                    VkExtent2D extent) {
+  this->framebuffers = framebuffers;
+  this->extent = extent;
+}
 
-  VkClearValue clear_value = {{{0, 0, 0, 1}}};
+void ImguiRenderer::Record(vk::CommandBuffer &command_buffer,
+                           uint32_t image_index) {
+  ImDrawData *draw_data = ImGui::GetDrawData();
+  if (!draw_data) {
+    return;
+  }
 
   VkRenderPassBeginInfo render_pass_begin_info =
       vk::render_pass_begin_info_template;
@@ -124,41 +130,13 @@ void ImguiRenderer::CreateCommandBuffer(uint32_t image_index) {
   render_pass_begin_info.framebuffer = framebuffers[image_index];
   render_pass_begin_info.renderArea.offset = {0, 0};
   render_pass_begin_info.renderArea.extent = extent;
-  render_pass_begin_info.clearValueCount = 1;
-  render_pass_begin_info.pClearValues = &clear_value;
-
-  vkCmdBeginRenderPass(render_command_buffer->GetHandle(),
-                       &render_pass_begin_info, VK_SUBPASS_CONTENTS_INLINE);
-
-  ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(),
-                                  render_command_buffer->GetHandle());
-
-  vkCmdEndRenderPass(render_command_buffer->GetHandle());
+  render_pass_begin_info.clearValueCount = 0;
+  render_pass_begin_info.pClearValues = nullptr;
 
-  render_command_buffer->End();
-}
-
-void ImguiRenderer::Render(uint32_t image_index,
-                           VkSemaphore image_available_semaphore,
-                           VkSemaphore render_finished_semaphore,
-                           VkFence fence) {
-  CreateCommandBuffer(image_index);
-
-  VkCommandBuffer command_buffer_handle = render_command_buffer->GetHandle();
+  vkCmdBeginRenderPass(command_buffer.GetHandle(), &render_pass_begin_info,
+                       VK_SUBPASS_CONTENTS_INLINE);
 
-  VkPipelineStageFlags wait_dst_stage_mask = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+  ImGui_ImplVulkan_RenderDrawData(draw_data, command_buffer.GetHandle());
 
-  VkSubmitInfo submit_info = vk::submit_info_template;
-  submit_info.commandBufferCount = 1;
-  submit_info.pCommandBuffers = &command_buffer_handle;
-  submit_info.waitSemaphoreCount = 1;
-  submit_info.pWaitSemaphores = &image_available_semaphore;
-  submit_info.pWaitDstStageMask = &wait_dst_stage_mask;
-  submit_info.signalSemaphoreCount = 1;
-  submit_info.pSignalSemaphores = &render_finished_semaphore;
-
-  VkResult result = vkQueueSubmit(queue.GetHandle(), 1, &submit_info, fence);
-  if (result) {
-    throw vk::CriticalException("cant submit to queue");
-  }
+  vkCmdEndRenderPass(command_buffer.GetHandle());
 }
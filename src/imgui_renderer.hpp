@@ -21,6 +21,7 @@ struct ImguiRendererCreateInfo {
   vector<VkFramebuffer> framebuffers;
 
   VkExtent2D extent;
+  // loads surface, so ui is drawn over what earlier passes rendered
   VkRenderPass render_pass;
 };
 
@@ -52,21 +53,22 @@ private:
   VkDescriptorPool imgui_descriptor_pool;
 
   unique_ptr<vk::CommandPool> imgui_command_pool;
-  unique_ptr<vk::CommandBuffer> render_command_buffer;
   unique_ptr<vk::CommandBuffer> one_time_command_buffer;
 
   void Init();
   void InitImgui();
   void CreateImguiDescriptorPool();
-  void CreateCommandBuffer(uint32_t image_index);
-  
+
 public:
   ImguiRenderer(ImguiRendererCreateInfo &create_info);
   ImguiRenderer(ImguiRenderer &) = delete;
   ImguiRenderer operator=(ImguiRenderer &) = delete;
   ~ImguiRenderer();
 
-  
-  void Render(uint32_t image_index, VkSemaphore image_available_semaphore,
-              VkSemaphore render_finished_semaphore, VkFence fence);
+  // after swapchain recreation
+  void SetFramebuffers(vector<VkFramebuffer> &framebuffers, VkExtent2D extent);
+
+  // draws data of last ImGui::Render into frame command buffer, surface
+  // image must be in color attachment layout
+  void Record(vk::CommandBuffer &command_buffer, uint32_t image_index);
 };
@@ -5,12 +5,20 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
-int main() {
+// --record-benchmark measures surface layer recording instead of running
+int main(int argc, char **argv) {
   setup_logs();
 
+  bool record_benchmark =
+      argc > 1 && string(argv[1]) == "--record-benchmark";
+
   try {
     Application application;
-    application.Run();
+    if (record_benchmark) {
+      application.RunRecordBenchmark();
+    } else {
+      application.Run();
+    }
 	INFO("application run finished");
   } catch (IException &e) {
     ERROR("application exit afer unhandled exception: {0}", (string)e);
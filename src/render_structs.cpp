@@ -97,3 +97,13 @@ UniformData::GetAttributeDescriptions(uint32_t binding, uint32_t &location) {
 
   return attribute_descriptions;
 }
+
+vk::SpecializationConstants SimulationConstants::GetSpecialization() const {
+  vk::SpecializationConstants specialization;
+  specialization.Set(map_size_id, map_size)
+      .Set(workgroup_size_id, workgroup_size)
+      .Set(diffusion_radius_id, diffusion_radius)
+      .Set(agent_type_count_id, agent_type_count);
+
+  return specialization;
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include "transform.hpp"
+#include "vk/specialization_constants.hpp"
 #include <glm/glm.hpp>
 #include <vector>
 #include <vulkan/vulkan.h>
@@ -63,3 +64,21 @@ struct UniformData {
   static vector<VkVertexInputAttributeDescription>
   GetAttributeDescriptions(uint32_t binding, uint32_t &location);
 };
+
+// values baked into simulation kernels, each field has constant_id below
+struct SimulationConstants {
+  enum ConstantId : uint32_t {
+    // width and height take two ids
+    map_size_id = 0,
+    workgroup_size_id = 2,
+    diffusion_radius_id = 3,
+    agent_type_count_id = 4,
+  };
+
+  glm::ivec2 map_size;
+  uint32_t workgroup_size;
+  uint32_t diffusion_radius;
+  uint32_t agent_type_count;
+
+  vk::SpecializationConstants GetSpecialization() const;
+};
@@ -2,135 +2,126 @@
 
 TextureRenderer::TextureRenderer(vk::Device *device,
                                  TextureRendererCreateInfo &create_info) {
-  device = create_info.device;
+  this->device = create_info.device;
   queue = create_info.queue;
   framebuffers = create_info.framebuffers;
+  render_pass = create_info.render_pass;
   texture_view = create_info.texture_view;
-  create_info.extent = extent;
+  extent = create_info.extent;
+  blend = create_info.blend;
+  frames_in_flight = create_info.frames_in_flight;
+  frame_index = 0;
+  pipeline_warmup = create_info.pipeline_warmup;
+  pipeline = VK_NULL_HANDLE;
+  // draws texture over whole framebuffer
+  camera.pos = {0, 0};
+  camera.scale = 1;
+
+  Init();
+}
+
+TextureRenderer::~TextureRenderer() {
+  if (command_buffers == nullptr) {
+    return;
+  }
+
+  Destroy();
+}
 
-  Init(create_info.render_pass);
+void TextureRenderer::Destroy() {
+  // pipeline itself is owned by device pipeline cache
+  command_buffers.reset();
+  vertex_buffer.reset();
+
+  vkDestroyPipelineLayout(device->GetHandle(), pipeline_layout, nullptr);
+  vkDestroyDescriptorPool(device->GetHandle(), descriptors_pool, nullptr);
+  vkDestroyDescriptorSetLayout(device->GetHandle(), descriptor_set_layout,
+                               nullptr);
+  vkDestroySampler(device->GetHandle(), texture_sampler, nullptr);
+
+  TRACE("texture renderer destroyed");
 }
 
-void TextureRenderer::Init(VkRenderPass render_pass) {
+void TextureRenderer::Init() {
   CreateVertexBuffer();
-  CreateUniformBuffer();
 
   CreateTextureSampler();
 
   CreateDescriptorSetLayout();
   CreateDescriptorPool();
-  AllocateDescriptorSet();
+  AllocateDescriptorSets();
 
-  UpdateDescriptorSet();
+  stale_descriptor_sets.assign(frames_in_flight, true);
+  for (uint32_t i = 0; i < frames_in_flight; i++) {
+    UpdateDescriptorSet(i);
+  }
 
-  CreatePipeline(render_pass);
+  CreatePipeline();
+
+  CreateCommandBuffers();
 }
 
-VkCommandBuffer TextureRenderer::Render(RenderInfo &render_info) {
-  WriteCommandBuffer(render_info);
+void TextureRenderer::SetFramebuffers(vector<VkFramebuffer> &framebuffers,
+                                      VkExtent2D extent) {
+  this->framebuffers = framebuffers;
+  this->extent = extent;
 
-  return command_buffer->GetHandle();
+  command_buffers->Resize(framebuffers.size() * frames_in_flight);
 }
 
-void TextureRenderer::CreatePipeline(VkRenderPass render_pass) {
-  unique_ptr<vk::ShaderModule> vertex_shader =
-      make_unique<vk::ShaderModule>(*device, "shaders/texture_vert.spv");
-  unique_ptr<vk::ShaderModule> fragment_shader =
-      make_unique<vk::ShaderModule>(*device, "shaders/texture_frag.spv");
-
-  VkPipelineShaderStageCreateInfo vertex_shader_stage_create_info =
-      vk::pipeline_shader_stage_create_info_template;
-  vertex_shader_stage_create_info.stage = VK_SHADER_STAGE_VERTEX_BIT;
-  vertex_shader_stage_create_info.module = vertex_shader->GetHandle();
-  vertex_shader_stage_create_info.pName = "main";
-
-  VkPipelineShaderStageCreateInfo fragment_shader_stage_create_info =
-      vk::pipeline_shader_stage_create_info_template;
-  fragment_shader_stage_create_info.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-  fragment_shader_stage_create_info.module = fragment_shader->GetHandle();
-  fragment_shader_stage_create_info.pName = "main";
-
-  VkPipelineShaderStageCreateInfo shader_stages[2] = {
-      vertex_shader_stage_create_info, fragment_shader_stage_create_info};
-
-  vector<VkVertexInputBindingDescription> binding_description;
-
-  VkVertexInputBindingDescription vertex_input_description;
-  vertex_input_description.binding = 0;
-  vertex_input_description.stride = sizeof(Vertex);
-  vertex_input_description.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-
-  VkVertexInputAttributeDescription attribute_descriptions[2];
-
-  attribute_descriptions[0].binding = 0;
-  attribute_descriptions[0].location = 0;
-  attribute_descriptions[0].format = VK_FORMAT_R32G32_SFLOAT;
-  attribute_descriptions[0].offset = offsetof(Vertex, pos);
-
-  attribute_descriptions[0].binding = 0;
-  attribute_descriptions[0].location = 1;
-  attribute_descriptions[0].format = VK_FORMAT_R32G32_SFLOAT;
-  attribute_descriptions[0].offset = offsetof(Vertex, tex);
-
-  VkPipelineVertexInputStateCreateInfo vertex_input =
-      vk::vertex_input_create_info_template;
-  vertex_input.pVertexBindingDescriptions = &vertex_input_description;
-  vertex_input.vertexBindingDescriptionCount = 1;
-  vertex_input.pVertexAttributeDescriptions = attribute_descriptions;
-  vertex_input.vertexAttributeDescriptionCount = 2;
-
-  VkPipelineInputAssemblyStateCreateInfo input_assembly_create_info =
-      vk::pipeline_input_assembly_create_info_template;
-  input_assembly_create_info.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+void TextureRenderer::SetTexture(vk::ImageView *texture_view) {
+  // descriptor set can not change while command buffers using it execute,
+  // so each one is written when its frame is begun
+  this->texture_view = texture_view;
+  stale_descriptor_sets.assign(frames_in_flight, true);
+}
 
-  VkViewport viewport;
-  viewport.x = 0;
-  viewport.y = 0;
-  viewport.width = extent.width;
-  viewport.height = extent.height;
-  viewport.minDepth = 0;
-  viewport.maxDepth = 1;
+void TextureRenderer::BeginFrame(uint32_t frame_index) {
+  this->frame_index = frame_index;
 
-  VkRect2D scissor;
-  scissor.offset = {0, 0};
-  scissor.extent = extent;
+  if (!stale_descriptor_sets[frame_index]) {
+    return;
+  }
+
+  UpdateDescriptorSet(frame_index);
+
+  // buffers binding rewritten set are invalid, their frame is finished
+  for (uint32_t i = 0; i < framebuffers.size(); i++) {
+    command_buffers->Invalidate(i * frames_in_flight + frame_index);
+  }
+}
 
-  VkPipelineViewportStateCreateInfo viewport_state_create_info =
-      vk::pipeline_viewport_state_create_info_template;
-  viewport_state_create_info.pViewports = &viewport;
-  viewport_state_create_info.pScissors = &scissor;
-
-  VkPipelineRasterizationStateCreateInfo rasterization_state_create_info =
-      vk::pipeline_rasterization_state_create_info_template;
-  rasterization_state_create_info.polygonMode = VK_POLYGON_MODE_FILL;
-
-  VkPipelineMultisampleStateCreateInfo multisample_create_info =
-      vk::pipeline_multisample_state_create_info_template;
-
-  VkPipelineColorBlendAttachmentState color_blend_attachment;
-  color_blend_attachment.colorWriteMask =
-      VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
-      VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-  color_blend_attachment.blendEnable = VK_FALSE;
-  color_blend_attachment.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
-  color_blend_attachment.dstColorBlendFactor = VK_BLEND_FACTOR_ZERO;
-  color_blend_attachment.colorBlendOp = VK_BLEND_OP_ADD;
-  color_blend_attachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
-  color_blend_attachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
-  color_blend_attachment.alphaBlendOp = VK_BLEND_OP_ADD;
-
-  VkPipelineColorBlendStateCreateInfo color_blend_state_create_info =
-      vk::pipeline_color_blend_state_create_info_template;
-  color_blend_state_create_info.logicOpEnable = VK_FALSE;
-  color_blend_state_create_info.attachmentCount = 1;
-  color_blend_state_create_info.pAttachments = &color_blend_attachment;
+void TextureRenderer::SetCamera(const Camera &camera) {
+  this->camera = camera;
+
+  // buffers executing with old camera stay valid, each one is recorded
+  // again after gpu finished it
+  command_buffers->Invalidate();
+}
+
+VkCommandBuffer TextureRenderer::Render(uint32_t framebuffer_index) {
+  // shader was reloaded, each command buffer is recorded again once gpu is
+  // done with it, old pipeline stays valid until then
+  if (pipeline != VK_NULL_HANDLE &&
+      pipeline_warmup->Get(pipeline_ticket) != pipeline) {
+    pipeline = VK_NULL_HANDLE;
+    command_buffers->Invalidate();
+  }
+
+  return command_buffers->Get(framebuffer_index * frames_in_flight +
+                              frame_index);
+}
+
+void TextureRenderer::CreatePipeline() {
+  VkPushConstantRange camera_range =
+      CameraConstants::GetRange(VK_SHADER_STAGE_VERTEX_BIT);
 
   VkPipelineLayoutCreateInfo pipeline_layout_create_info =
       vk::pipeline_layout_create_info_template;
   pipeline_layout_create_info.setLayoutCount = 1;
   pipeline_layout_create_info.pSetLayouts = &descriptor_set_layout;
-  pipeline_layout_create_info.pushConstantRangeCount = 0;
-  pipeline_layout_create_info.pPushConstantRanges = nullptr;
+  pipeline_layout_create_info.pushConstantRangeCount = 1;
+  pipeline_layout_create_info.pPushConstantRanges = &camera_range;
 
   VkResult result =
       vkCreatePipelineLayout(device->GetHandle(), &pipeline_layout_create_info,
@@ -141,125 +132,103 @@ void TextureRenderer::CreatePipeline(VkRenderPass render_pass) {
 
   TRACE("texture renderer pipeline layout created");
 
-  VkPipelineDynamicStateCreateInfo dynamic_state =
-      vk::pipeline_dynamic_state_create_info_template;
-  dynamic_state.dynamicStateCount = 0;
-  dynamic_state.pDynamicStates = nullptr;
-
-  VkGraphicsPipelineCreateInfo pipeline_create_info =
-      vk::graphics_pipeline_create_info_template;
-  pipeline_create_info.stageCount = 2;
-  pipeline_create_info.pStages = shader_stages;
-  pipeline_create_info.pVertexInputState = &vertex_input;
-  pipeline_create_info.pInputAssemblyState = &input_assembly_create_info;
-  pipeline_create_info.pViewportState = &viewport_state_create_info;
-  pipeline_create_info.pRasterizationState = &rasterization_state_create_info;
-  pipeline_create_info.pMultisampleState = &multisample_create_info;
-  pipeline_create_info.pDepthStencilState = nullptr;
-  pipeline_create_info.pColorBlendState = &color_blend_state_create_info;
-  pipeline_create_info.pDynamicState = &dynamic_state;
-  pipeline_create_info.layout = pipeline_layout;
-  pipeline_create_info.renderPass = render_pass;
-  pipeline_create_info.subpass = 0;
-  pipeline_create_info.basePipelineHandle = VK_NULL_HANDLE;
-  pipeline_create_info.basePipelineIndex = -1;
-
-  result = vkCreateGraphicsPipelines(device->GetHandle(), VK_NULL_HANDLE, 1,
-                                     &pipeline_create_info, nullptr, &pipeline);
-  if (result) {
-    throw vk::CriticalException("cant create pipeline");
-  }
-
-  DEBUG("texture renderer graphics pipeline created");
+  // viewport is dynamic, so resize needs only new command buffers
+  vk::GraphicsPipelineBuilder builder;
+  builder.AddShader(VK_SHADER_STAGE_VERTEX_BIT, "shaders/texture_vert.spv")
+      .AddShader(VK_SHADER_STAGE_FRAGMENT_BIT, "shaders/texture_frag.spv")
+      .AddVertexBinding(0, sizeof(Vertex))
+      .AddVertexAttribute(0, 0, VK_FORMAT_R32G32_SFLOAT,
+                          offsetof(Vertex, pos))
+      .AddVertexAttribute(1, 0, VK_FORMAT_R32G32_SFLOAT,
+                          offsetof(Vertex, tex))
+      .SetTopology(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_FAN)
+      .AddColorAttachment(blend)
+      .SetLayout(pipeline_layout)
+      .SetRenderPass(render_pass);
+
+  pipeline_ticket = pipeline_warmup->Add(builder);
+
+  TRACE("texture renderer graphics pipeline added to warmup");
 }
 
 void TextureRenderer::CreateCommandBuffers() {
-  command_pool = make_unique<vk::CommandPool>(*device, queue, 1);
+  vk::CommandBufferCacheCreateInfo create_info;
+  create_info.queue = queue;
+  create_info.count = framebuffers.size() * frames_in_flight;
+  create_info.level = vk::CommandBufferLevel::secondary;
+  create_info.inheritance = [this](uint32_t index) {
+    vk::SecondaryRecordInfo info;
+    info.render_pass = render_pass;
+    info.framebuffer = framebuffers[index / frames_in_flight];
+    return info;
+  };
+  create_info.record = [this](vk::CommandBuffer &command_buffer,
+                              uint32_t index) {
+    WriteCommandBuffer(command_buffer, index % frames_in_flight);
+  };
+
+  command_buffers =
+      make_unique<vk::CommandBufferCache>(*device, create_info);
+}
+
+void TextureRenderer::WriteCommandBuffer(vk::CommandBuffer &command_buffer,
+                                         uint32_t frame_index) {
+  // render pass and its clear are begun by caller
+  if (pipeline == VK_NULL_HANDLE) {
+    pipeline = pipeline_warmup->Get(pipeline_ticket);
+  }
 
-  command_buffer =
-      command_pool->AllocateCommandBuffer(vk::CommandBufferLevel::primary);
+  RecordDraw(command_buffer, pipeline, descriptor_sets[frame_index]);
 }
 
-void TextureRenderer::WriteCommandBuffer(RenderInfo &render_info) {
-  command_buffer->Reset();
-
-  command_buffer->Begin();
-
-  VkClearValue clear_value = {{{0, 0, 0, 1}}};
-
-  VkRenderPassBeginInfo render_pass_begin_info =
-      vk::render_pass_begin_info_template;
-  render_pass_begin_info.renderPass = render_info.render_pass;
-  render_pass_begin_info.framebuffer = render_info.framebuffer;
-  render_pass_begin_info.renderArea.offset = {0, 0};
-  render_pass_begin_info.renderArea.extent = extent;
-  render_pass_begin_info.clearValueCount = 1;
-  render_pass_begin_info.pClearValues = &clear_value;
-
-  VkSemaphoreWaitInfo wait_info;
-  wait_info.sType
-  wait_info.flags = 0;
-  wait_info.pNext = 0;
-  wait_info.pSemaphores = &render_info.wait_semaphore;
-  wait_info.semaphoreCount = 1;
-  
-  vkWaitSemaphores(device->GetHandle(), 
-  
-  vkCmdBeginRenderPass(command_buffer->GetHandle(), &render_pass_begin_info,
-                       VK_SUBPASS_CONTENTS_INLINE);
-
-  vkCmdBindPipeline(command_buffer->GetHandle(),
+void TextureRenderer::Record(vk::CommandBuffer &command_buffer) {
+  // recorded every frame, so reloaded pipeline is picked up at once
+  RecordDraw(command_buffer, pipeline_warmup->Get(pipeline_ticket),
+             descriptor_sets[frame_index]);
+}
+
+void TextureRenderer::RecordDraw(vk::CommandBuffer &command_buffer,
+                                 VkPipeline pipeline,
+                                 VkDescriptorSet descriptor_set) {
+  vkCmdBindPipeline(command_buffer.GetHandle(),
                     VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
 
+  VkViewport viewport;
+  viewport.x = 0;
+  viewport.y = 0;
+  viewport.width = extent.width;
+  viewport.height = extent.height;
+  viewport.minDepth = 0;
+  viewport.maxDepth = 1;
+
+  VkRect2D scissor;
+  scissor.offset = {0, 0};
+  scissor.extent = extent;
+
+  vkCmdSetViewport(command_buffer.GetHandle(), 0, 1, &viewport);
+  vkCmdSetScissor(command_buffer.GetHandle(), 0, 1, &scissor);
+
   VkBuffer vertex_buffers[] = {vertex_buffer->GetHandle()};
   VkDeviceSize offsets[] = {0, 0};
 
-  vkCmdBindVertexBuffers(command_buffer->GetHandle(), 0, 1, vertex_buffers,
+  vkCmdBindVertexBuffers(command_buffer.GetHandle(), 0, 1, vertex_buffers,
                          offsets);
 
-  vkCmdBindDescriptorSets(command_buffer->GetHandle(),
+  vkCmdBindDescriptorSets(command_buffer.GetHandle(),
                           VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layout, 0,
                           1, &descriptor_set, 0, nullptr);
 
-  vkCmdDraw(command_buffer->GetHandle(), 4, 1, 0, 0);
+  CameraConstants::Push(command_buffer, pipeline_layout,
+                        VK_SHADER_STAGE_VERTEX_BIT, camera);
 
-  vkCmdEndRenderPass(command_buffer->GetHandle());
-
-  command_buffer->End();
-}
-
-void TextureRenderer::CreateUniformBuffer() {
-  vk::BufferCreateInfo create_info;
-  create_info.queue = queue;
-  create_info.size = sizeof(UniformData);
-  create_info.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
-
-  uniform_buffer = make_unique<vk::Buffer>(*device, create_info);
-
-  vector<vk::MemoryObject *> buffers = {uniform_buffer.get()};
-
-  uint32_t memory_size = vk::DeviceMemory::CalculateMemorySize(buffers);
-
-  vk::ChooseMemoryTypeInfo choose_info;
-  choose_info.memory_types = uniform_buffer->GetMemoryTypes();
-  choose_info.heap_properties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
-  choose_info.properties =
-      uniform_buffer->GetMemoryRequirements().memoryTypeBits;
-
-  uint32_t choosed_memory =
-      device->GetPhysicalDevice().ChooseMemoryType(choose_info);
-
-  uniform_buffer_memory =
-      make_unique<vk::DeviceMemory>(*device, memory_size, choosed_memory);
-
-  uniform_buffer_memory->BindBuffer(*uniform_buffer);
+  vkCmdDraw(command_buffer.GetHandle(), 4, 1, 0, 0);
 }
 
 void TextureRenderer::CreateDescriptorSetLayout() {
   vector<VkDescriptorSetLayoutBinding> bindings;
 
   VkDescriptorSetLayoutBinding sampler_layout_binding;
-  sampler_layout_binding.binding = 0;
+  sampler_layout_binding.binding = 1;
   sampler_layout_binding.descriptorCount = 1;
   sampler_layout_binding.descriptorType =
       VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
@@ -286,7 +255,7 @@ void TextureRenderer::CreateDescriptorPool() {
   vector<VkDescriptorPoolSize> pool_sizes;
 
   VkDescriptorPoolSize sampler_pool_size;
-  sampler_pool_size.descriptorCount = 1;
+  sampler_pool_size.descriptorCount = frames_in_flight;
   sampler_pool_size.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
 
   pool_sizes.push_back(sampler_pool_size);
@@ -295,7 +264,7 @@ void TextureRenderer::CreateDescriptorPool() {
       vk::descriptor_pool_create_info_template;
   create_info.poolSizeCount = pool_sizes.size();
   create_info.pPoolSizes = pool_sizes.data();
-  create_info.maxSets = 1;
+  create_info.maxSets = frames_in_flight;
 
   VkResult result = vkCreateDescriptorPool(device->GetHandle(), &create_info,
                                            nullptr, &descriptors_pool);
@@ -306,47 +275,36 @@ void TextureRenderer::CreateDescriptorPool() {
   TRACE("texture renderer descriptor pool created");
 }
 
-void TextureRenderer::AllocateDescriptorSet() {
+void TextureRenderer::AllocateDescriptorSets() {
+  vector<VkDescriptorSetLayout> layouts(frames_in_flight,
+                                        descriptor_set_layout);
+  descriptor_sets.resize(frames_in_flight);
+
   VkDescriptorSetAllocateInfo allocate_info =
       vk::descriptor_set_allocate_info_template;
   allocate_info.descriptorPool = descriptors_pool;
-  allocate_info.descriptorSetCount = 1;
-  allocate_info.pSetLayouts = &descriptor_set_layout;
+  allocate_info.descriptorSetCount = layouts.size();
+  allocate_info.pSetLayouts = layouts.data();
 
-  VkResult result = vkAllocateDescriptorSets(device->GetHandle(),
-                                             &allocate_info, &descriptor_set);
+  VkResult result = vkAllocateDescriptorSets(
+      device->GetHandle(), &allocate_info, descriptor_sets.data());
   if (result) {
-    throw vk::CriticalException("cant allocate descriptor set");
+    throw vk::CriticalException("cant allocate descriptor sets");
   }
 
-  TRACE("texture renderer descriptor set allocated");
+  TRACE("texture renderer {0} descriptor sets allocated", frames_in_flight);
 }
 
-void TextureRenderer::UpdateDescriptorSet() {
+void TextureRenderer::UpdateDescriptorSet(uint32_t frame_index) {
   vector<VkWriteDescriptorSet> write_sets;
 
-  VkDescriptorBufferInfo buffer_info;
-  buffer_info.buffer = uniform_buffer->GetHandle();
-  buffer_info.offset = 0;
-  buffer_info.range = VK_WHOLE_SIZE;
-
-  VkWriteDescriptorSet ubo_write_set = vk::write_descriptor_set_template;
-  ubo_write_set.dstSet = descriptor_set;
-  ubo_write_set.dstBinding = 0;
-  ubo_write_set.dstArrayElement = 0;
-  ubo_write_set.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-  ubo_write_set.descriptorCount = 1;
-  ubo_write_set.pBufferInfo = &buffer_info;
-
-  write_sets.push_back(ubo_write_set);
-
   VkDescriptorImageInfo image_info;
   image_info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
   image_info.imageView = texture_view->GetHandle();
   image_info.sampler = texture_sampler;
 
   VkWriteDescriptorSet texture_write_set = vk::write_descriptor_set_template;
-  texture_write_set.dstSet = descriptor_set;
+  texture_write_set.dstSet = descriptor_sets[frame_index];
   texture_write_set.dstBinding = 1;
   texture_write_set.dstArrayElement = 0;
   texture_write_set.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
@@ -357,8 +315,9 @@ void TextureRenderer::UpdateDescriptorSet() {
 
   vkUpdateDescriptorSets(device->GetHandle(), write_sets.size(),
                          write_sets.data(), 0, nullptr);
+  stale_descriptor_sets[frame_index] = false;
 
-  TRACE("texture renderer descriptors set updated");
+  TRACE("texture renderer descriptor set of frame {0} updated", frame_index);
 }
 
 void TextureRenderer::CreateTextureSampler() {
@@ -369,6 +328,11 @@ void TextureRenderer::CreateTextureSampler() {
   create_info.addressModeV = address_mode;
   create_info.addressModeW = address_mode;
 
+  // zoomed out sprites read smaller levels instead of aliasing level 0,
+  // view limits levels, so texture set later can have more of them
+  create_info.minLod = 0.0f;
+  create_info.maxLod = VK_LOD_CLAMP_NONE;
+
   VkResult result = vkCreateSampler(device->GetHandle(), &create_info, nullptr,
                                     &texture_sampler);
   if (result) {
@@ -377,40 +341,24 @@ void TextureRenderer::CreateTextureSampler() {
 }
 
 void TextureRenderer::CreateVertexBuffer() {
+  // fan of two triangles covering whole framebuffer
   SpriteVertex vertices[] = {
-      {{-1, -1}, {}}, {{-1, 1}, {}}, {{1, 1}, {}}, {{1, -1}, {}}};
+      {{-1, -1}, {0, 0}}, {{-1, 1}, {0, 1}}, {{1, 1}, {1, 1}},
+      {{1, -1}, {1, 0}}};
 
   vk::BufferCreateInfo create_info;
   create_info.queue = queue;
   create_info.size = sizeof(vertices);
   create_info.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+  create_info.memory_usage = vk::MemoryUsage::dynamic_per_frame;
 
   vertex_buffer = make_unique<vk::Buffer>(*device, create_info);
 
-  vk::PhysicalDevice &physical_device = device->GetPhysicalDevice();
-
-  vk::ChooseMemoryTypeInfo choose_info;
-  choose_info.memory_types = vertex_buffer->GetMemoryTypes();
-  choose_info.heap_properties = 0;
-  choose_info.properties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
-
-  uint32_t memory_type = physical_device.ChooseMemoryType(choose_info);
-
-  vector<vk::MemoryObject *> buffers = {vertex_buffer.get()};
-
-  VkDeviceSize memory_size = vk::DeviceMemory::CalculateMemorySize(buffers);
-
-  vertex_buffer_memory =
-      make_unique<vk::DeviceMemory>(*device, memory_size, memory_type);
-
-  vertex_buffer_memory->BindBuffer(*vertex_buffer);
-
   void *mapped_data = vertex_buffer->Map();
 
   memcpy(mapped_data, vertices, sizeof(vertices));
 
   vertex_buffer->Flush();
-  vertex_buffer->Unmap();
 
   TRACE("texture renderer vertex buffer created");
 }
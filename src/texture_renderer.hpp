@@ -1,4 +1,5 @@
 #pragma once
+#include "camera.hpp"
 #include "render_structs.hpp"
 #include "vk/vulkan.hpp"
 
@@ -13,6 +14,13 @@ struct TextureRendererCreateInfo {
   VkRenderPass render_pass;
 
   vk::ImageView *texture_view;
+  // each frame in flight binds its own descriptor set
+  uint32_t frames_in_flight = 1;
+  // straight alpha over what was drawn before, like sprites
+  bool blend = false;
+
+  // pipeline is compiled there with pipelines of other renderers
+  vk::PipelineWarmup *pipeline_warmup;
 };
 
 class TextureRenderer {
@@ -21,59 +29,89 @@ private:
     glm::fvec2 pos, tex;
   };
 
-  struct UniformData {
-    int dump;
-  };
-
-public:
-  struct RenderInfo {
-    VkSemaphore wait_semaphore, signal_semaphore;
-    VkFramebuffer framebuffer;
-    VkRenderPass render_pass;
-  };
+  // pushed to vertex shader with every draw
+  typedef vk::PushConstants<Camera> CameraConstants;
 
-private:
   vk::Device *device;
   vk::Queue queue;
 
   vector<VkFramebuffer> framebuffers;
+  VkRenderPass render_pass;
 
   vk::ImageView *texture_view;
   VkSampler texture_sampler;
 
   VkExtent2D extent;
+  bool blend;
+
+  uint32_t frames_in_flight;
+  // frame in flight being recorded, set by BeginFrame
+  uint32_t frame_index;
 
+  vk::PipelineWarmup *pipeline_warmup;
+  vk::PipelineTicket pipeline_ticket;
+  // taken from warmup when command buffer is recorded, changes after
+  // shader reload
   VkPipeline pipeline;
 
-  unique_ptr<vk::DeviceMemory> vertex_buffer_memory, uniform_buffer_memory;
-  unique_ptr<vk::Buffer> vertex_buffer, uniform_buffer;
+  Camera camera;
 
-  unique_ptr<vk::CommandPool> command_pool;
-  unique_ptr<vk::CommandBuffer> command_buffer;
+  unique_ptr<vk::Buffer> vertex_buffer;
+
+  // one recorded secondary command buffer per framebuffer and frame in
+  // flight, since each binds descriptor set of its frame
+  unique_ptr<vk::CommandBufferCache> command_buffers;
 
   VkDescriptorSetLayout descriptor_set_layout;
   VkDescriptorPool descriptors_pool;
-  VkDescriptorSet descriptor_set;
+  vector<VkDescriptorSet> descriptor_sets;
+  // set is written again when its frame is begun after texture changed
+  vector<bool> stale_descriptor_sets;
   VkPipelineLayout pipeline_layout;
 
   void CreateVertexBuffer();
-  void CreateUniformBuffer();
   void CreateTextureSampler();
-  void CreatePipeline(VkRenderPass render_pass);
+  void CreatePipeline();
 
   void CreateDescriptorSetLayout();
   void CreateDescriptorPool();
-  void AllocateDescriptorSet();
+  void AllocateDescriptorSets();
 
-  void UpdateDescriptorSet();
+  void UpdateDescriptorSet(uint32_t frame_index);
 
   void CreateCommandBuffers();
-  void WriteCommandBuffer(RenderInfo &render_info);
+  void WriteCommandBuffer(vk::CommandBuffer &command_buffer,
+                          uint32_t frame_index);
+  void RecordDraw(vk::CommandBuffer &command_buffer, VkPipeline pipeline,
+                  VkDescriptorSet descriptor_set);
 
-  void Init(VkRenderPass render_pass);
+  void Init();
 
 public:
   TextureRenderer(vk::Device *device, TextureRendererCreateInfo &create_info);
-
-  VkCommandBuffer Render(RenderInfo &render_info);
+  TextureRenderer(TextureRenderer &) = delete;
+  TextureRenderer &operator=(TextureRenderer &) = delete;
+  ~TextureRenderer();
+
+  void Destroy();
+
+  // after swapchain recreation, command buffers are recorded again
+  void SetFramebuffers(vector<VkFramebuffer> &framebuffers, VkExtent2D extent);
+  // frames in flight keep reading previous view, so it must live until
+  // they are finished, set of each frame is written in its BeginFrame
+  void SetTexture(vk::ImageView *texture_view);
+  // command buffers are recorded again with new push constants
+  void SetCamera(const Camera &camera);
+
+  // must be called on main thread after previous submit of frame_index
+  // finished, before Render or Record of that frame
+  void BeginFrame(uint32_t frame_index);
+
+  // returned secondary command buffer is executed by caller inside render
+  // pass of framebuffer begun with secondary contents, it is recorded only
+  // when inputs changed since last call
+  VkCommandBuffer Render(uint32_t framebuffer_index);
+  // draws into command buffer continuing surface render pass, like layer
+  // recorded every frame on job system thread
+  void Record(vk::CommandBuffer &command_buffer);
 };
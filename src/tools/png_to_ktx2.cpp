@@ -0,0 +1,396 @@
+// packs png images into ktx2 files with a full mip chain, one
+// output.<format>.ktx2 variant per format, loader picks the best one, usage:
+// png_to_ktx2 <input.png> <output.ktx2> [bc1|bc3|bc4|rgba8]...
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#include "../vk/ktx2_format.hpp"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+using namespace std;
+namespace fs = filesystem;
+
+struct Level {
+  int width, height;
+  vector<uint8_t> pixels;
+};
+
+struct OutputFormat {
+  string name;
+  VkFormat format;
+  // 0 for uncompressed formats
+  uint32_t block_size;
+};
+
+// bc1 and bc4 variants are not searched by loader, they are for opaque and
+// single channel textures loaded by their full path
+static const OutputFormat output_formats[] = {
+    {"bc1", VK_FORMAT_BC1_RGB_SRGB_BLOCK, 8},
+    {"bc3", VK_FORMAT_BC3_SRGB_BLOCK, 16},
+    {"bc4", VK_FORMAT_BC4_UNORM_BLOCK, 8},
+    {"rgba8", VK_FORMAT_R8G8B8A8_SRGB, 0},
+};
+
+// 2x2 box filter in stored space, good enough for sprites
+static Level Downsample(Level &level) {
+  Level result;
+  result.width = max(level.width / 2, 1);
+  result.height = max(level.height / 2, 1);
+  result.pixels.resize(result.width * result.height * 4);
+
+  for (int y = 0; y < result.height; y++) {
+    for (int x = 0; x < result.width; x++) {
+      for (int c = 0; c < 4; c++) {
+        int sum = 0;
+        for (int i = 0; i < 4; i++) {
+          int src_x = min(x * 2 + i % 2, level.width - 1);
+          int src_y = min(y * 2 + i / 2, level.height - 1);
+          sum += level.pixels[(src_y * level.width + src_x) * 4 + c];
+        }
+
+        result.pixels[(y * result.width + x) * 4 + c] = (sum + 2) / 4;
+      }
+    }
+  }
+
+  return result;
+}
+
+static uint16_t To565(const uint8_t *color) {
+  return (color[0] >> 3) << 11 | (color[1] >> 2) << 5 | color[2] >> 3;
+}
+
+static void From565(uint16_t color, int result[3]) {
+  int r = color >> 11 & 31;
+  int g = color >> 5 & 63;
+  int b = color & 31;
+
+  result[0] = r << 3 | r >> 2;
+  result[1] = g << 2 | g >> 4;
+  result[2] = b << 3 | b >> 2;
+}
+
+// endpoints are bounding box corners of block colors, always in four color
+// mode so the block is valid inside bc3 too
+static void EncodeColorBlock(uint8_t texels[16][4], uint8_t *block) {
+  uint8_t low[3] = {255, 255, 255};
+  uint8_t high[3] = {0, 0, 0};
+
+  for (int i = 0; i < 16; i++) {
+    for (int c = 0; c < 3; c++) {
+      low[c] = min(low[c], texels[i][c]);
+      high[c] = max(high[c], texels[i][c]);
+    }
+  }
+
+  uint16_t endpoints[2] = {To565(high), To565(low)};
+  if (endpoints[0] < endpoints[1]) {
+    swap(endpoints[0], endpoints[1]);
+  }
+
+  int palette[4][3];
+  From565(endpoints[0], palette[0]);
+  From565(endpoints[1], palette[1]);
+  for (int c = 0; c < 3; c++) {
+    palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+    palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+  }
+
+  uint32_t indices = 0;
+
+  // equal endpoints would switch decoder to three color mode
+  if (endpoints[0] != endpoints[1]) {
+    for (int i = 0; i < 16; i++) {
+      int best_index = 0;
+      int best_distance = INT32_MAX;
+
+      for (int p = 0; p < 4; p++) {
+        int distance = 0;
+        for (int c = 0; c < 3; c++) {
+          int delta = texels[i][c] - palette[p][c];
+          distance += delta * delta;
+        }
+
+        if (distance < best_distance) {
+          best_distance = distance;
+          best_index = p;
+        }
+      }
+
+      indices |= best_index << (2 * i);
+    }
+  }
+
+  block[0] = endpoints[0] & 255;
+  block[1] = endpoints[0] >> 8;
+  block[2] = endpoints[1] & 255;
+  block[3] = endpoints[1] >> 8;
+  for (int i = 0; i < 4; i++) {
+    block[4 + i] = indices >> (8 * i) & 255;
+  }
+}
+
+static void EncodeChannelBlock(uint8_t texels[16], uint8_t *block) {
+  uint8_t low = *min_element(texels, texels + 16);
+  uint8_t high = *max_element(texels, texels + 16);
+
+  int values[8] = {high, low};
+  for (int i = 1; i <= 6; i++) {
+    values[i + 1] = ((7 - i) * high + i * low) / 7;
+  }
+
+  uint64_t indices = 0;
+
+  if (high != low) {
+    for (int i = 0; i < 16; i++) {
+      int best_index = 0;
+      for (int v = 1; v < 8; v++) {
+        if (abs(texels[i] - values[v]) < abs(texels[i] - values[best_index])) {
+          best_index = v;
+        }
+      }
+
+      indices |= (uint64_t)best_index << (3 * i);
+    }
+  }
+
+  block[0] = high;
+  block[1] = low;
+  for (int i = 0; i < 6; i++) {
+    block[2 + i] = indices >> (8 * i) & 255;
+  }
+}
+
+static vector<uint8_t> Encode(Level &level, const OutputFormat &format) {
+  if (format.block_size == 0) {
+    return level.pixels;
+  }
+
+  int blocks_x = (level.width + 3) / 4;
+  int blocks_y = (level.height + 3) / 4;
+
+  vector<uint8_t> result(blocks_x * blocks_y * format.block_size);
+  uint8_t *block = result.data();
+
+  for (int block_y = 0; block_y < blocks_y; block_y++) {
+    for (int block_x = 0; block_x < blocks_x; block_x++) {
+      uint8_t colors[16][4];
+      uint8_t channel[16];
+
+      // texels out of small levels repeat the edge
+      for (int i = 0; i < 16; i++) {
+        int x = min(block_x * 4 + i % 4, level.width - 1);
+        int y = min(block_y * 4 + i / 4, level.height - 1);
+
+        memcpy(colors[i], &level.pixels[(y * level.width + x) * 4], 4);
+        channel[i] = format.format == VK_FORMAT_BC4_UNORM_BLOCK
+                         ? colors[i][0]
+                         : colors[i][3];
+      }
+
+      if (format.format == VK_FORMAT_BC1_RGB_SRGB_BLOCK) {
+        EncodeColorBlock(colors, block);
+      } else if (format.format == VK_FORMAT_BC3_SRGB_BLOCK) {
+        EncodeChannelBlock(channel, block);
+        EncodeColorBlock(colors, block + 8);
+      } else {
+        EncodeChannelBlock(channel, block);
+      }
+
+      block += format.block_size;
+    }
+  }
+
+  return result;
+}
+
+// basic data format descriptor from khronos data format specification
+static vector<uint32_t> CreateDataFormatDescriptor(const OutputFormat &format) {
+  struct Sample {
+    uint32_t bit_offset;
+    uint32_t bit_length;
+    uint32_t channel;
+    uint32_t upper;
+  };
+
+  constexpr uint32_t channel_linear = 0x10;
+
+  uint32_t color_model;
+  bool srgb = format.format != VK_FORMAT_BC4_UNORM_BLOCK;
+  vector<Sample> samples;
+
+  switch (format.format) {
+  case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+    color_model = 128;
+    samples = {{0, 64, 0, UINT32_MAX}};
+    break;
+  case VK_FORMAT_BC3_SRGB_BLOCK:
+    color_model = 130;
+    samples = {{0, 64, 15 | channel_linear, UINT32_MAX},
+               {64, 64, 0, UINT32_MAX}};
+    break;
+  case VK_FORMAT_BC4_UNORM_BLOCK:
+    color_model = 131;
+    samples = {{0, 64, 0, UINT32_MAX}};
+    break;
+  default:
+    color_model = 1;
+    samples = {{0, 8, 0, 255},
+               {8, 8, 1, 255},
+               {16, 8, 2, 255},
+               {24, 8, 15 | channel_linear, 255}};
+    break;
+  }
+
+  uint32_t block_dimension = format.block_size ? 3 : 0;
+  uint32_t block_bytes = format.block_size ? format.block_size : 4;
+  uint32_t block_size = 24 + 16 * samples.size();
+
+  vector<uint32_t> descriptor;
+  descriptor.push_back(4 + block_size);
+  descriptor.push_back(0);
+  descriptor.push_back(2 | block_size << 16);
+  // bt709 primaries, srgb or linear transfer, straight alpha
+  descriptor.push_back(color_model | 1 << 8 | (srgb ? 2 : 1) << 16);
+  descriptor.push_back(block_dimension | block_dimension << 8);
+  descriptor.push_back(block_bytes);
+  descriptor.push_back(0);
+
+  for (Sample &sample : samples) {
+    descriptor.push_back(sample.bit_offset | (sample.bit_length - 1) << 16 |
+                         sample.channel << 24);
+    descriptor.push_back(0);
+    descriptor.push_back(0);
+    descriptor.push_back(sample.upper);
+  }
+
+  return descriptor;
+}
+
+static void WriteKtx2(string path, const OutputFormat &format,
+                      vector<Level> &levels) {
+  vector<vector<uint8_t>> encoded_levels;
+  for (Level &level : levels) {
+    encoded_levels.push_back(Encode(level, format));
+  }
+
+  vector<uint32_t> descriptor = CreateDataFormatDescriptor(format);
+
+  vk::Ktx2Header header{};
+  memcpy(header.identifier, vk::ktx2_identifier, sizeof(header.identifier));
+  header.vk_format = format.format;
+  header.type_size = 1;
+  header.pixel_width = levels[0].width;
+  header.pixel_height = levels[0].height;
+  header.face_count = 1;
+  header.level_count = levels.size();
+  header.dfd_byte_offset =
+      sizeof(vk::Ktx2Header) + levels.size() * sizeof(vk::Ktx2LevelIndex);
+  header.dfd_byte_length = descriptor.size() * sizeof(uint32_t);
+
+  // levels are stored from the smallest one, each aligned to its block
+  uint64_t alignment = format.block_size ? format.block_size : 4;
+  uint64_t offset = header.dfd_byte_offset + header.dfd_byte_length;
+
+  vector<vk::Ktx2LevelIndex> level_indices(levels.size());
+  for (size_t i = levels.size(); i-- > 0;) {
+    offset = (offset + alignment - 1) / alignment * alignment;
+
+    level_indices[i].byte_offset = offset;
+    level_indices[i].byte_length = encoded_levels[i].size();
+    level_indices[i].uncompressed_byte_length = encoded_levels[i].size();
+
+    offset += encoded_levels[i].size();
+  }
+
+  vector<char> file_data(offset, 0);
+  memcpy(file_data.data(), &header, sizeof(header));
+  memcpy(file_data.data() + sizeof(header), level_indices.data(),
+         level_indices.size() * sizeof(vk::Ktx2LevelIndex));
+  memcpy(file_data.data() + header.dfd_byte_offset, descriptor.data(),
+         header.dfd_byte_length);
+
+  for (size_t i = 0; i < levels.size(); i++) {
+    memcpy(file_data.data() + level_indices[i].byte_offset,
+           encoded_levels[i].data(), encoded_levels[i].size());
+  }
+
+  ofstream file(path, ios::binary);
+  if (!file) {
+    throw runtime_error("cant open \"" + path + "\" for writing");
+  }
+
+  file.write(file_data.data(), file_data.size());
+}
+
+int main(int argc, char **argv) {
+  if (argc < 3) {
+    cerr << "usage: png_to_ktx2 <input.png> <output.ktx2> "
+            "[bc1|bc3|bc4|rgba8]..."
+         << endl;
+    return 1;
+  }
+
+  // bc3 where block compression is sampled, rgba8 everywhere else
+  vector<string> format_names = {"bc3", "rgba8"};
+  if (argc > 3) {
+    format_names.assign(argv + 3, argv + argc);
+  }
+
+  vector<const OutputFormat *> formats;
+  for (string &format_name : format_names) {
+    const OutputFormat *format = nullptr;
+    for (const OutputFormat &output_format : output_formats) {
+      if (output_format.name == format_name) {
+        format = &output_format;
+      }
+    }
+
+    if (!format) {
+      cerr << "unknown format " << format_name << endl;
+      return 1;
+    }
+
+    formats.push_back(format);
+  }
+
+  Level level;
+  int channels;
+  uint8_t *pixels =
+      stbi_load(argv[1], &level.width, &level.height, &channels, 4);
+  if (!pixels) {
+    cerr << "cant decode " << argv[1] << ": " << stbi_failure_reason() << endl;
+    return 1;
+  }
+
+  level.pixels.assign(pixels, pixels + level.width * level.height * 4);
+  stbi_image_free(pixels);
+
+  vector<Level> levels = {level};
+  while (levels.back().width > 1 || levels.back().height > 1) {
+    levels.push_back(Downsample(levels.back()));
+  }
+
+  for (const OutputFormat *format : formats) {
+    fs::path path = argv[2];
+    path.replace_extension(format->name + ".ktx2");
+
+    try {
+      WriteKtx2(path.string(), *format, levels);
+    } catch (exception &e) {
+      cerr << e.what() << endl;
+      return 1;
+    }
+
+    cout << path.string() << ": " << level.width << "x" << level.height
+         << ", " << levels.size() << " levels, " << format->name << endl;
+  }
+}
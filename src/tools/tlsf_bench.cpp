@@ -0,0 +1,166 @@
+// times TlsfAllocator against the segment scan DeviceMemory used before it,
+// with 10k and 100k live allocations, usage: tlsf_bench [iterations]
+
+#include "../vk/tlsf_allocator.hpp"
+#include "../vk/tools.hpp"
+#include <chrono>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// copy of former DeviceMemory placement, every bind and free scans and
+// inserts into one vector of segments
+class SegmentScanAllocator {
+private:
+  struct Segment {
+    bool empty;
+    VkDeviceSize offset;
+    VkDeviceSize size;
+    uint32_t id;
+  };
+
+  vector<Segment> segments;
+
+  void Merge(uint32_t first, uint32_t second) {
+    segments[first].size += segments[second].size;
+    segments.erase(segments.begin() + second);
+  }
+
+public:
+  SegmentScanAllocator(VkDeviceSize size) {
+    segments.push_back({true, 0, size, 0});
+  }
+
+  bool Allocate(VkDeviceSize size, VkDeviceSize alignment, uint32_t id) {
+    int64_t optimal = -1;
+    VkDeviceSize optimal_space = numeric_limits<VkDeviceSize>::max();
+
+    for (uint32_t i = 0; i < segments.size(); i++) {
+      Segment &segment = segments[i];
+      if (!segment.empty) {
+        continue;
+      }
+
+      VkDeviceSize aligned = tools::align_up(segment.offset, alignment);
+      if (aligned + size > segment.offset + segment.size) {
+        continue;
+      }
+
+      if (segment.size - size < optimal_space) {
+        optimal = i;
+        optimal_space = segment.size - size;
+      }
+    }
+
+    if (optimal == -1) {
+      return false;
+    }
+
+    Segment initial = segments[optimal];
+    VkDeviceSize used =
+        tools::align_up(initial.offset, alignment) - initial.offset + size;
+
+    segments[optimal] = {false, initial.offset, used, id};
+    if (initial.size > used) {
+      segments.insert(segments.begin() + optimal + 1,
+                      {true, initial.offset + used, initial.size - used, 0});
+    }
+
+    return true;
+  }
+
+  void Free(uint32_t id) {
+    uint32_t index = 0;
+    while (segments[index].empty || segments[index].id != id) {
+      index++;
+    }
+
+    segments[index].empty = true;
+
+    if (index + 1 < segments.size() && segments[index + 1].empty) {
+      Merge(index, index + 1);
+    }
+
+    if (index > 0 && segments[index - 1].empty) {
+      Merge(index - 1, index);
+    }
+  }
+};
+
+static constexpr VkDeviceSize alignment = 256;
+static constexpr VkDeviceSize min_size = 256;
+static constexpr VkDeviceSize max_size = 4096;
+
+// fills allocator with live allocations, then frees a random one and
+// allocates a new one per iteration, returns microseconds per pair
+template <typename Allocate, typename Free>
+static double Run(uint32_t live_count, uint32_t iterations, Allocate allocate,
+                  Free free) {
+  mt19937 random(live_count);
+  uniform_int_distribution<VkDeviceSize> size_distribution(min_size, max_size);
+  uniform_int_distribution<uint32_t> live_distribution(0, live_count - 1);
+
+  vector<uint32_t> live(live_count);
+  for (uint32_t i = 0; i < live_count; i++) {
+    live[i] = allocate(size_distribution(random));
+  }
+
+  chrono::high_resolution_clock::time_point start =
+      chrono::high_resolution_clock::now();
+
+  for (uint32_t i = 0; i < iterations; i++) {
+    uint32_t slot = live_distribution(random);
+    free(live[slot]);
+    live[slot] = allocate(size_distribution(random));
+  }
+
+  return chrono::duration<double, micro>(chrono::high_resolution_clock::now() -
+                                         start)
+             .count() /
+         iterations;
+}
+
+int main(int argc, char **argv) {
+  uint32_t iterations = argc > 1 ? stoul(argv[1]) : 10000;
+
+  for (uint32_t live_count : {10000u, 100000u}) {
+    // room for every allocation at its largest, so none of them fails
+    VkDeviceSize size = (VkDeviceSize)live_count * max_size * 2;
+
+    vk::TlsfAllocator tlsf(size, 1);
+    double tlsf_time = Run(
+        live_count, iterations,
+        [&](VkDeviceSize block_size) {
+          uint32_t block = tlsf.Allocate(block_size, alignment, true);
+          if (block == vk::TlsfAllocator::null_block) {
+            throw runtime_error("tlsf allocator is full");
+          }
+          return block;
+        },
+        [&](uint32_t block) { tlsf.Free(block); });
+
+    SegmentScanAllocator scan(size);
+    uint32_t next_id = 1;
+    double scan_time = Run(
+        live_count, iterations,
+        [&](VkDeviceSize block_size) {
+          uint32_t id = next_id++;
+          if (!scan.Allocate(block_size, alignment, id)) {
+            throw runtime_error("segment scan allocator is full");
+          }
+          return id;
+        },
+        [&](uint32_t id) { scan.Free(id); });
+
+    cout << live_count << " live: tlsf " << tlsf_time
+         << " us, segment scan " << scan_time << " us per free and allocate"
+         << endl;
+  }
+
+  return 0;
+}
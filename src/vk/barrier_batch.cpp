@@ -0,0 +1,198 @@
+#include "barrier_batch.hpp"
+#include "../logs.hpp"
+
+namespace vk {
+
+BarrierBatch::BarrierBatch(Device &device) { this->device = &device; }
+
+void BarrierBatch::Add(ImageBarrier &barrier) {
+  VkImageMemoryBarrier native = barrier.ToNative();
+  Add(barrier.src.stage, barrier.dst.stage, native);
+}
+
+void BarrierBatch::Add(BufferBarrier &barrier) {
+  VkBufferMemoryBarrier native = barrier.ToNative();
+  Add(barrier.src.stage, barrier.dst.stage, native);
+}
+
+void BarrierBatch::Add(MemoryBarrier &barrier) {
+  VkMemoryBarrier native = barrier.ToNative();
+  Add(barrier.src.stage, barrier.dst.stage, native);
+}
+
+void BarrierBatch::Add(VkPipelineStageFlags src_stage,
+                       VkPipelineStageFlags dst_stage,
+                       VkImageMemoryBarrier &barrier) {
+  VkImageMemoryBarrier2KHR barrier2 = image_memory_barrier2_template;
+  barrier2.srcStageMask = src_stage;
+  barrier2.srcAccessMask = barrier.srcAccessMask;
+  barrier2.dstStageMask = dst_stage;
+  barrier2.dstAccessMask = barrier.dstAccessMask;
+  barrier2.oldLayout = barrier.oldLayout;
+  barrier2.newLayout = barrier.newLayout;
+  barrier2.srcQueueFamilyIndex = barrier.srcQueueFamilyIndex;
+  barrier2.dstQueueFamilyIndex = barrier.dstQueueFamilyIndex;
+  barrier2.image = barrier.image;
+  barrier2.subresourceRange = barrier.subresourceRange;
+
+  image_barriers.push_back(barrier2);
+}
+
+void BarrierBatch::Add(VkPipelineStageFlags src_stage,
+                       VkPipelineStageFlags dst_stage,
+                       VkBufferMemoryBarrier &barrier) {
+  VkBufferMemoryBarrier2KHR barrier2 = buffer_barrier2_template;
+  barrier2.srcStageMask = src_stage;
+  barrier2.srcAccessMask = barrier.srcAccessMask;
+  barrier2.dstStageMask = dst_stage;
+  barrier2.dstAccessMask = barrier.dstAccessMask;
+  barrier2.srcQueueFamilyIndex = barrier.srcQueueFamilyIndex;
+  barrier2.dstQueueFamilyIndex = barrier.dstQueueFamilyIndex;
+  barrier2.buffer = barrier.buffer;
+  barrier2.offset = barrier.offset;
+  barrier2.size = barrier.size;
+
+  buffer_barriers.push_back(barrier2);
+}
+
+void BarrierBatch::Add(VkPipelineStageFlags src_stage,
+                       VkPipelineStageFlags dst_stage,
+                       VkMemoryBarrier &barrier) {
+  VkMemoryBarrier2KHR barrier2 = memory_barrier2_template;
+  barrier2.srcStageMask = src_stage;
+  barrier2.srcAccessMask = barrier.srcAccessMask;
+  barrier2.dstStageMask = dst_stage;
+  barrier2.dstAccessMask = barrier.dstAccessMask;
+
+  memory_barriers.push_back(barrier2);
+}
+
+void BarrierBatch::Append(BarrierBatch &batch) {
+  memory_barriers.insert(memory_barriers.end(), batch.memory_barriers.begin(),
+                         batch.memory_barriers.end());
+  buffer_barriers.insert(buffer_barriers.end(), batch.buffer_barriers.begin(),
+                         batch.buffer_barriers.end());
+  image_barriers.insert(image_barriers.end(), batch.image_barriers.begin(),
+                        batch.image_barriers.end());
+
+  batch.Clear();
+}
+
+void BarrierBatch::Flush(CommandBuffer &command_buffer) {
+  if (IsEmpty()) {
+    return;
+  }
+
+  if (device->IsSynchronization2Enabled()) {
+    FlushSynchronization2(command_buffer.GetHandle());
+  } else {
+    FlushMerged(command_buffer.GetHandle());
+  }
+
+  TRACE("{0} memory, {1} buffer and {2} image barriers flushed",
+        memory_barriers.size(), buffer_barriers.size(),
+        image_barriers.size());
+
+  Clear();
+}
+
+void BarrierBatch::FlushSynchronization2(VkCommandBuffer command_buffer) {
+  VkDependencyInfoKHR dependency_info = dependency_info_template;
+  dependency_info.memoryBarrierCount = memory_barriers.size();
+  dependency_info.pMemoryBarriers = memory_barriers.data();
+  dependency_info.bufferMemoryBarrierCount = buffer_barriers.size();
+  dependency_info.pBufferMemoryBarriers = buffer_barriers.data();
+  dependency_info.imageMemoryBarrierCount = image_barriers.size();
+  dependency_info.pImageMemoryBarriers = image_barriers.data();
+
+  device->CmdPipelineBarrier2(command_buffer, dependency_info);
+}
+
+// legacy flags are the lower bits of synchronization2 ones, so masks of
+// barriers added through this class fit back into 32 bits
+void BarrierBatch::FlushMerged(VkCommandBuffer command_buffer) {
+  VkPipelineStageFlags src_stages = 0;
+  VkPipelineStageFlags dst_stages = 0;
+
+  vector<VkMemoryBarrier> vk_memory_barriers;
+  for (VkMemoryBarrier2KHR &barrier2 : memory_barriers) {
+    VkMemoryBarrier barrier = memory_barrier_template;
+    barrier.srcAccessMask = barrier2.srcAccessMask;
+    barrier.dstAccessMask = barrier2.dstAccessMask;
+    vk_memory_barriers.push_back(barrier);
+
+    src_stages |= barrier2.srcStageMask;
+    dst_stages |= barrier2.dstStageMask;
+  }
+
+  vector<VkBufferMemoryBarrier> vk_buffer_barriers;
+  for (VkBufferMemoryBarrier2KHR &barrier2 : buffer_barriers) {
+    VkBufferMemoryBarrier barrier = buffer_barrier_template;
+    barrier.srcAccessMask = barrier2.srcAccessMask;
+    barrier.dstAccessMask = barrier2.dstAccessMask;
+    barrier.srcQueueFamilyIndex = barrier2.srcQueueFamilyIndex;
+    barrier.dstQueueFamilyIndex = barrier2.dstQueueFamilyIndex;
+    barrier.buffer = barrier2.buffer;
+    barrier.offset = barrier2.offset;
+    barrier.size = barrier2.size;
+    vk_buffer_barriers.push_back(barrier);
+
+    src_stages |= barrier2.srcStageMask;
+    dst_stages |= barrier2.dstStageMask;
+  }
+
+  vector<VkImageMemoryBarrier> vk_image_barriers;
+  for (VkImageMemoryBarrier2KHR &barrier2 : image_barriers) {
+    VkImageMemoryBarrier barrier = image_memory_barrier_template;
+    barrier.srcAccessMask = barrier2.srcAccessMask;
+    barrier.dstAccessMask = barrier2.dstAccessMask;
+    barrier.oldLayout = barrier2.oldLayout;
+    barrier.newLayout = barrier2.newLayout;
+    barrier.srcQueueFamilyIndex = barrier2.srcQueueFamilyIndex;
+    barrier.dstQueueFamilyIndex = barrier2.dstQueueFamilyIndex;
+    barrier.image = barrier2.image;
+    barrier.subresourceRange = barrier2.subresourceRange;
+    vk_image_barriers.push_back(barrier);
+
+    src_stages |= barrier2.srcStageMask;
+    dst_stages |= barrier2.dstStageMask;
+  }
+
+  // zero masks are valid only in synchronization2
+  if (!src_stages) {
+    src_stages = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+  }
+  if (!dst_stages) {
+    dst_stages = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+  }
+
+  vkCmdPipelineBarrier(command_buffer, src_stages, dst_stages, 0,
+                       vk_memory_barriers.size(), vk_memory_barriers.data(),
+                       vk_buffer_barriers.size(), vk_buffer_barriers.data(),
+                       vk_image_barriers.size(), vk_image_barriers.data());
+}
+
+void BarrierBatch::Clear() {
+  memory_barriers.clear();
+  buffer_barriers.clear();
+  image_barriers.clear();
+}
+
+bool BarrierBatch::Contains(VkImage image) {
+  for (VkImageMemoryBarrier2KHR &barrier : image_barriers) {
+    if (barrier.image == image) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool BarrierBatch::IsEmpty() { return GetSize() == 0; }
+
+uint32_t BarrierBatch::GetSize() {
+  return memory_barriers.size() + buffer_barriers.size() +
+         image_barriers.size();
+}
+
+} // namespace vk
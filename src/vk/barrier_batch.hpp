@@ -0,0 +1,54 @@
+#pragma once
+#include "barrier.hpp"
+#include "command_buffer.hpp"
+#include "device.hpp"
+#include "templates.hpp"
+#include <vector>
+#include <vulkan/vulkan.h>
+
+using namespace std;
+
+namespace vk {
+
+// collects image, buffer and global barriers and records them in one call,
+// with synchronization2 every barrier keeps its own stages, otherwise stages
+// of all barriers are merged into one vkCmdPipelineBarrier
+class BarrierBatch {
+private:
+  Device *device;
+
+  vector<VkMemoryBarrier2KHR> memory_barriers;
+  vector<VkBufferMemoryBarrier2KHR> buffer_barriers;
+  vector<VkImageMemoryBarrier2KHR> image_barriers;
+
+  void FlushMerged(VkCommandBuffer command_buffer);
+  void FlushSynchronization2(VkCommandBuffer command_buffer);
+
+public:
+  BarrierBatch(Device &device);
+
+  void Add(ImageBarrier &barrier);
+  void Add(BufferBarrier &barrier);
+  void Add(MemoryBarrier &barrier);
+
+  void Add(VkPipelineStageFlags src_stage, VkPipelineStageFlags dst_stage,
+           VkImageMemoryBarrier &barrier);
+  void Add(VkPipelineStageFlags src_stage, VkPipelineStageFlags dst_stage,
+           VkBufferMemoryBarrier &barrier);
+  void Add(VkPipelineStageFlags src_stage, VkPipelineStageFlags dst_stage,
+           VkMemoryBarrier &barrier);
+  // moves barriers of other batch to this one
+  void Append(BarrierBatch &batch);
+
+  // records collected barriers, nothing when batch is empty
+  void Flush(CommandBuffer &command_buffer);
+  void Clear();
+
+  bool IsEmpty();
+  uint32_t GetSize();
+  // barriers in one call are not ordered, so a barrier of image already in
+  // batch needs flush first
+  bool Contains(VkImage image);
+};
+
+} // namespace vk
@@ -0,0 +1,160 @@
+#include "block_decoder.hpp"
+#include "exception.hpp"
+
+namespace vk {
+
+bool BlockDecoder::IsSupported(VkFormat format) {
+  return GetDecodedFormat(format) != VK_FORMAT_UNDEFINED;
+}
+
+VkFormat BlockDecoder::GetDecodedFormat(VkFormat format) {
+  switch (format) {
+  case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+  case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+  case VK_FORMAT_BC3_UNORM_BLOCK:
+    return VK_FORMAT_R8G8B8A8_UNORM;
+  case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+  case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+  case VK_FORMAT_BC3_SRGB_BLOCK:
+    return VK_FORMAT_R8G8B8A8_SRGB;
+  case VK_FORMAT_BC4_UNORM_BLOCK:
+    return VK_FORMAT_R8_UNORM;
+  default:
+    return VK_FORMAT_UNDEFINED;
+  }
+}
+
+vector<char> BlockDecoder::Decode(VkFormat format, span<const char> data,
+                                  glm::ivec2 size) {
+  bool has_color = format != VK_FORMAT_BC4_UNORM_BLOCK;
+  bool has_alpha_block =
+      format == VK_FORMAT_BC3_UNORM_BLOCK || format == VK_FORMAT_BC3_SRGB_BLOCK;
+  bool opaque = format == VK_FORMAT_BC1_RGB_UNORM_BLOCK ||
+                format == VK_FORMAT_BC1_RGB_SRGB_BLOCK;
+
+  uint32_t block_size = has_alpha_block ? 16 : 8;
+  uint32_t texel_size = has_color ? 4 : 1;
+
+  glm::ivec2 blocks = (size + 3) / 4;
+  if (data.size_bytes() < (size_t)blocks.x * blocks.y * block_size) {
+    throw CriticalException("block compressed level is too small");
+  }
+
+  vector<char> result((size_t)size.x * size.y * texel_size);
+  const uint8_t *block = (const uint8_t *)data.data();
+
+  uint8_t colors[16][4];
+  uint8_t channel[16];
+
+  for (int block_y = 0; block_y < blocks.y; block_y++) {
+    for (int block_x = 0; block_x < blocks.x; block_x++) {
+      if (has_color) {
+        // bc3 color block is always read in four color mode
+        DecodeColorBlock(block + (has_alpha_block ? 8 : 0), has_alpha_block,
+                         colors);
+      }
+
+      if (has_alpha_block || !has_color) {
+        DecodeChannelBlock(block, channel);
+      }
+
+      for (int i = 0; i < 16; i++) {
+        int x = block_x * 4 + i % 4;
+        int y = block_y * 4 + i / 4;
+        if (x >= size.x || y >= size.y) {
+          continue;
+        }
+
+        char *texel = result.data() + ((size_t)y * size.x + x) * texel_size;
+
+        if (!has_color) {
+          texel[0] = channel[i];
+          continue;
+        }
+
+        texel[0] = colors[i][0];
+        texel[1] = colors[i][1];
+        texel[2] = colors[i][2];
+        texel[3] = has_alpha_block ? channel[i] : opaque ? 255 : colors[i][3];
+      }
+
+      block += block_size;
+    }
+  }
+
+  return result;
+}
+
+void BlockDecoder::DecodeColorBlock(const uint8_t *block, bool four_color_only,
+                                    uint8_t texels[16][4]) {
+  uint16_t endpoints[2] = {(uint16_t)(block[0] | block[1] << 8),
+                           (uint16_t)(block[2] | block[3] << 8)};
+
+  uint8_t palette[4][4];
+
+  // 565 endpoints are expanded by repeating their high bits
+  for (int i = 0; i < 2; i++) {
+    uint8_t r = endpoints[i] >> 11 & 31;
+    uint8_t g = endpoints[i] >> 5 & 63;
+    uint8_t b = endpoints[i] & 31;
+
+    palette[i][0] = r << 3 | r >> 2;
+    palette[i][1] = g << 2 | g >> 4;
+    palette[i][2] = b << 3 | b >> 2;
+    palette[i][3] = 255;
+  }
+
+  bool four_colors = four_color_only || endpoints[0] > endpoints[1];
+
+  for (int c = 0; c < 3; c++) {
+    if (four_colors) {
+      palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+      palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+    } else {
+      palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+      palette[3][c] = 0;
+    }
+  }
+  palette[2][3] = 255;
+  palette[3][3] = four_colors ? 255 : 0;
+
+  uint32_t indices =
+      block[4] | block[5] << 8 | block[6] << 16 | (uint32_t)block[7] << 24;
+
+  for (int i = 0; i < 16; i++) {
+    uint8_t *color = palette[indices >> (2 * i) & 3];
+    for (int c = 0; c < 4; c++) {
+      texels[i][c] = color[c];
+    }
+  }
+}
+
+void BlockDecoder::DecodeChannelBlock(const uint8_t *block,
+                                      uint8_t texels[16]) {
+  uint8_t values[8];
+  values[0] = block[0];
+  values[1] = block[1];
+
+  if (values[0] > values[1]) {
+    for (int i = 1; i <= 6; i++) {
+      values[i + 1] = ((7 - i) * values[0] + i * values[1]) / 7;
+    }
+  } else {
+    for (int i = 1; i <= 4; i++) {
+      values[i + 1] = ((5 - i) * values[0] + i * values[1]) / 5;
+    }
+    values[6] = 0;
+    values[7] = 255;
+  }
+
+  uint64_t indices = 0;
+  for (int i = 0; i < 6; i++) {
+    indices |= (uint64_t)block[2 + i] << (8 * i);
+  }
+
+  for (int i = 0; i < 16; i++) {
+    texels[i] = values[indices >> (3 * i) & 7];
+  }
+}
+
+} // namespace vk
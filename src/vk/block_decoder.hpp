@@ -0,0 +1,26 @@
+#pragma once
+#include "glm/glm.hpp"
+#include <span>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+using namespace std;
+
+namespace vk {
+
+// cpu fallback for block compressed formats device can not sample, only
+// formats our packer writes are handled
+class BlockDecoder {
+private:
+  static void DecodeColorBlock(const uint8_t *block, bool four_color_only,
+                               uint8_t texels[16][4]);
+  static void DecodeChannelBlock(const uint8_t *block, uint8_t texels[16]);
+
+public:
+  static bool IsSupported(VkFormat format);
+  static VkFormat GetDecodedFormat(VkFormat format);
+  static vector<char> Decode(VkFormat format, span<const char> data,
+                             glm::ivec2 size);
+};
+
+} // namespace vk
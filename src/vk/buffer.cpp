@@ -1,29 +1,63 @@
 #include "buffer.hpp"
-#include "device_memory.hpp"
+#include "memory_manager.hpp"
 
 namespace vk {
 
 Buffer::Buffer(Device &device, BufferCreateInfo &create_info) {
   this->device = &device;
+  memory = nullptr;
   is_binded = false;
   size = create_info.size;
-  
-  VkBufferCreateInfo vk_create_info = buffer_create_info_template;
+  usage = create_info.usage;
+  queue_family = create_info.queue.GetFamily();
+  movable = create_info.movable;
+  category = create_info.memory_category;
+
+  // defragmenter moves content with transfer commands
+  if (movable) {
+    usage |= VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+  }
+
+  CreateHandle();
+  QueryMemoryRequirements();
 
-  uint32_t queue_family = create_info.queue.GetFamily();
+  device.GetMemoryManager().BindBuffer(*this, create_info.memory_usage);
+}
 
-  vk_create_info.size = create_info.size;
-  vk_create_info.usage = create_info.usage;
+void Buffer::CreateHandle() {
+  VkBufferCreateInfo vk_create_info = buffer_create_info_template;
+  vk_create_info.size = size;
+  vk_create_info.usage = usage;
   vk_create_info.queueFamilyIndexCount = 1;
   vk_create_info.pQueueFamilyIndices = &queue_family;
 
   VkResult result =
-      vkCreateBuffer(device.GetHandle(), &vk_create_info, nullptr, &handle);
+      vkCreateBuffer(device->GetHandle(), &vk_create_info, nullptr, &handle);
   if (result) {
     throw CriticalException("cant create buffer");
   }
+}
+
+void Buffer::QueryMemoryRequirements() {
+  VkBufferMemoryRequirementsInfo2 requirements_info{};
+  requirements_info.sType =
+      VK_STRUCTURE_TYPE_BUFFER_MEMORY_REQUIREMENTS_INFO_2;
+  requirements_info.buffer = handle;
 
-  vkGetBufferMemoryRequirements(device.GetHandle(), handle, &requirements);
+  VkMemoryDedicatedRequirements dedicated_requirements{};
+  dedicated_requirements.sType =
+      VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS;
+
+  VkMemoryRequirements2 requirements2{};
+  requirements2.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+  requirements2.pNext = &dedicated_requirements;
+
+  vkGetBufferMemoryRequirements2(device->GetHandle(), &requirements_info,
+                                 &requirements2);
+
+  requirements = requirements2.memoryRequirements;
+  prefers_dedicated = dedicated_requirements.prefersDedicatedAllocation ||
+                      dedicated_requirements.requiresDedicatedAllocation;
 }
 
 Buffer::~Buffer() {
@@ -33,18 +67,27 @@ Buffer::~Buffer() {
 }
 
 void Buffer::Destroy() {
-  memory->FreeBuffer(this);
+  device->GetMemoryManager().FreeBuffer(*this);
 
-  is_binded = false;
   vkDestroyBuffer(device->GetHandle(), handle, nullptr);
   handle = 0;
 }
 
-void *Buffer::Map() { return memory->MapMemory(this); }
+void *Buffer::Map() { return memory->GetMappedData(this); }
 
-void Buffer::Flush() { memory->Flush(); }
+void Buffer::Flush(VkDeviceSize offset, VkDeviceSize size) {
+  if (memory->IsHostCoherent()) {
+    return;
+  }
+
+  VkMappedMemoryRange mapped_range =
+      memory->CreateMappedRange(this, offset, size);
+  memory->Flush(mapped_range);
+}
 
-void Buffer::Unmap() { memory->Unmap(); }
+void Buffer::QueueFlush(VkDeviceSize offset, VkDeviceSize size) {
+  device->GetMemoryManager().QueueFlush(*this, offset, size);
+}
 
 VkBuffer Buffer::GetHandle() { return handle; }
 
@@ -15,7 +15,10 @@ class DeviceMemory;
 struct BufferCreateInfo {
   VkDeviceSize size;
   VkBufferUsageFlags usage;
+  MemoryUsage memory_usage = MemoryUsage::gpu_only;
+  MemoryCategory memory_category = MemoryCategory::other;
   Queue queue;
+  bool movable = false;
 };
 
 class Buffer : public MemoryObject {
@@ -26,6 +29,11 @@ private:
   bool is_binded;
 
   VkDeviceSize size;
+  VkBufferUsageFlags usage;
+  uint32_t queue_family;
+
+  void CreateHandle();
+  void QueryMemoryRequirements();
 
 public:
   Buffer(Device &device, BufferCreateInfo &create_info);
@@ -34,13 +42,15 @@ public:
   ~Buffer();
 
   void *Map();
-  void Flush();
-  void Unmap();
+  void Flush(VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE);
+  void QueueFlush(VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE);
   VkBuffer GetHandle();
   void Destroy();
   VkDeviceSize GetSize();
 
   friend DeviceMemory;
+  friend class MemoryManager;
+  friend class Defragmenter;
 };
 
 } // namespace vk
@@ -6,6 +6,8 @@ using namespace std;
 
 namespace vk {
 
+class BarrierBatch;
+
 struct SrcBufferBarrier {
   VkPipelineStageFlags stage;
   VkAccessFlags access;
@@ -31,6 +33,8 @@ public:
   BufferBarrier(Buffer *buffer, SrcBufferBarrier src, DstBufferBarrier dst);
 
   void Set(CommandBuffer *command_buffer);
+
+  friend BarrierBatch;
 };
 
 } // namespace vk
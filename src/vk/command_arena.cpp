@@ -0,0 +1,134 @@
+#include "command_arena.hpp"
+
+namespace vk {
+
+CommandArena::CommandArena(Device &device,
+                           CommandArenaCreateInfo &create_info) {
+  this->device = &device;
+  queue = create_info.queue;
+  timeline = &device.GetTimeline(queue);
+  job_system = create_info.job_system;
+  max_command_buffers = create_info.max_command_buffers;
+  current_frame = 0;
+
+  uint32_t thread_count = job_system->GetThreadCount();
+
+  frames.resize(create_info.frames_in_flight);
+  for (FramePools &frame : frames) {
+    frame.timeline_value = 0;
+    frame.threads.resize(thread_count);
+
+    for (ThreadPool &thread_pool : frame.threads) {
+      // primary and secondary buffers share pool capacity
+      thread_pool.command_pool = make_unique<CommandPool>(
+          device, queue, max_command_buffers * 2, true);
+      thread_pool.used_primary = 0;
+      thread_pool.used_secondary = 0;
+    }
+  }
+
+  TRACE("command arena with {0} threads and {1} frames created",
+        thread_count, frames.size());
+}
+
+CommandArena::~CommandArena() {
+  if (!frames.empty()) {
+    Destroy();
+  }
+}
+
+void CommandArena::Destroy() {
+  for (FramePools &frame : frames) {
+    timeline->Wait(frame.timeline_value);
+
+    for (ThreadPool &thread_pool : frame.threads) {
+      thread_pool.primary_buffers.clear();
+      thread_pool.secondary_buffers.clear();
+      thread_pool.command_pool.reset();
+    }
+  }
+  frames.clear();
+
+  TRACE("command arena destroyed");
+}
+
+void CommandArena::BeginFrame(uint32_t frame_index) {
+  current_frame = frame_index;
+  FramePools &frame = frames[current_frame];
+
+  // usually frame loop already waited for this value, so it does not block
+  timeline->Wait(frame.timeline_value);
+
+  for (ThreadPool &thread_pool : frame.threads) {
+    if (thread_pool.used_primary == 0 && thread_pool.used_secondary == 0) {
+      continue;
+    }
+
+    thread_pool.command_pool->Reset();
+    thread_pool.used_primary = 0;
+    thread_pool.used_secondary = 0;
+  }
+}
+
+void CommandArena::EndFrame(uint64_t timeline_value) {
+  frames[current_frame].timeline_value = timeline_value;
+}
+
+CommandBuffer &
+CommandArena::Take(vector<unique_ptr<CommandBuffer>> &command_buffers,
+                   uint32_t &used, CommandPool &command_pool,
+                   CommandBufferLevel level) {
+  if (used == command_buffers.size()) {
+    if (used == max_command_buffers) {
+      throw CriticalException("command arena thread has no free command "
+                              "buffers");
+    }
+
+    command_buffers.push_back(command_pool.AllocateCommandBuffer(level));
+  }
+
+  return *command_buffers[used++];
+}
+
+CommandBuffer &CommandArena::Allocate(uint32_t thread_index,
+                                      CommandBufferLevel level) {
+  ThreadPool &thread_pool = frames[current_frame].threads[thread_index];
+
+  if (level == CommandBufferLevel::primary) {
+    return Take(thread_pool.primary_buffers, thread_pool.used_primary,
+                *thread_pool.command_pool, level);
+  }
+
+  return Take(thread_pool.secondary_buffers, thread_pool.used_secondary,
+              *thread_pool.command_pool, level);
+}
+
+void CommandArena::RecordSecondary(
+    CommandBuffer &primary, SecondaryRecordInfo &info,
+    vector<function<void(CommandBuffer &)>> &jobs) {
+  if (jobs.empty()) {
+    return;
+  }
+
+  vector<VkCommandBuffer> secondary_buffers(jobs.size());
+
+  job_system->ParallelFor(
+      jobs.size(), [&](uint32_t index, uint32_t thread_index) {
+        CommandBuffer &command_buffer =
+            Allocate(thread_index, CommandBufferLevel::secondary);
+
+        command_buffer.BeginSecondary(info.render_pass, info.subpass,
+                                      info.framebuffer);
+        jobs[index](command_buffer);
+        command_buffer.End();
+
+        secondary_buffers[index] = command_buffer.GetHandle();
+      });
+
+  vkCmdExecuteCommands(primary.GetHandle(), secondary_buffers.size(),
+                       secondary_buffers.data());
+}
+
+uint32_t CommandArena::GetThreadCount() { return frames[0].threads.size(); }
+
+} // namespace vk
@@ -0,0 +1,84 @@
+#pragma once
+#include "command_buffer.hpp"
+#include "command_pool.hpp"
+#include "device.hpp"
+#include "gpu_timeline.hpp"
+#include "job_system.hpp"
+#include "queue.hpp"
+#include <functional>
+#include <memory>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+using namespace std;
+
+namespace vk {
+
+struct CommandArenaCreateInfo {
+  // command buffers are submitted to this queue, pools are recycled by its
+  // timeline
+  Queue queue;
+  uint32_t frames_in_flight;
+  // threads recording secondary command buffers, one pool each
+  JobSystem *job_system;
+  // limit of command buffers of one level per thread and frame
+  uint32_t max_command_buffers = 64;
+};
+
+// transient command pool per thread and frame in flight, pools of a frame
+// are reset at once when it begins, command buffers are allocated once and
+// reused in following frames
+class CommandArena {
+private:
+  struct ThreadPool {
+    unique_ptr<CommandPool> command_pool;
+    vector<unique_ptr<CommandBuffer>> primary_buffers;
+    vector<unique_ptr<CommandBuffer>> secondary_buffers;
+    uint32_t used_primary;
+    uint32_t used_secondary;
+  };
+
+  struct FramePools {
+    vector<ThreadPool> threads;
+    uint64_t timeline_value;
+  };
+
+  Device *device;
+  Queue queue;
+  GpuTimeline *timeline;
+  JobSystem *job_system;
+  uint32_t max_command_buffers;
+
+  vector<FramePools> frames;
+  uint32_t current_frame;
+
+  CommandBuffer &Take(vector<unique_ptr<CommandBuffer>> &command_buffers,
+                      uint32_t &used, CommandPool &command_pool,
+                      CommandBufferLevel level);
+
+public:
+  CommandArena(Device &device, CommandArenaCreateInfo &create_info);
+  CommandArena(CommandArena &) = delete;
+  CommandArena &operator=(CommandArena &) = delete;
+  ~CommandArena();
+
+  void Destroy();
+
+  // waits for previous use of frame pools and resets them
+  void BeginFrame(uint32_t frame_index);
+  // timeline_value is value signaled by submit of the frame
+  void EndFrame(uint64_t timeline_value);
+
+  // pool of thread_index may be used only by one thread during frame
+  CommandBuffer &Allocate(uint32_t thread_index, CommandBufferLevel level);
+
+  // every job records its own secondary command buffer on job system
+  // threads, primary executes them in job order, render pass must be
+  // begun with secondary command buffers contents
+  void RecordSecondary(CommandBuffer &primary, SecondaryRecordInfo &info,
+                       vector<function<void(CommandBuffer &)>> &jobs);
+
+  uint32_t GetThreadCount();
+};
+
+} // namespace vk
@@ -34,23 +34,9 @@ CommandBuffer::~CommandBuffer() {
 VkCommandBuffer CommandBuffer::GetHandle() { return handle; }
 
 void CommandBuffer::SoloExecute() {
-  VkPipelineStageFlags wait_dst_stage_mask = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+  GpuTimeline &timeline = pool->device->GetTimeline(queue);
+  timeline.Wait(timeline.Submit(handle));
 
-  VkSubmitInfo submit_info = vk::submit_info_template;
-  submit_info.commandBufferCount = 1;
-  submit_info.pCommandBuffers = &handle;
-
-  VkResult result =
-      vkQueueSubmit(queue.GetHandle(), 1, &submit_info, pool->solo_execute_fence);
-  if (result) {
-    throw vk::CriticalException("cant submit to queue");
-  }
-
-  vkWaitForFences(pool->device->GetHandle(), 1, &pool->solo_execute_fence, VK_TRUE,
-                  UINT64_MAX);
-
-  vkResetFences(pool->device->GetHandle(), 1, &pool->solo_execute_fence);
-  
   TRACE("command pool solo executed");
 }
 
@@ -67,6 +53,29 @@ void CommandBuffer::Begin() {
   TRACE("command buffer begun");
 }
 
+void CommandBuffer::BeginSecondary(VkRenderPass render_pass,
+                                   uint32_t subpass,
+                                   VkFramebuffer framebuffer,
+                                   bool one_time_submit) {
+  VkCommandBufferInheritanceInfo inheritance_info =
+      command_buffer_inheritance_info_template;
+  inheritance_info.renderPass = render_pass;
+  inheritance_info.subpass = subpass;
+  inheritance_info.framebuffer = framebuffer;
+
+  VkCommandBufferBeginInfo begin_info = vk::command_buffer_begin_info_template;
+  begin_info.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+  if (one_time_submit) {
+    begin_info.flags |= VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+  }
+  begin_info.pInheritanceInfo = &inheritance_info;
+
+  VkResult result = vkBeginCommandBuffer(handle, &begin_info);
+  if (result) {
+    throw CriticalException("cant begin secondary command buffer");
+  }
+}
+
 void CommandBuffer::End() {
   VkResult result = vkEndCommandBuffer(handle);
   if (result) {
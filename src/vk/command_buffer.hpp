@@ -15,6 +15,13 @@ enum class CommandBufferLevel {
   secondary = VK_COMMAND_BUFFER_LEVEL_SECONDARY
 };
 
+// render pass subpass which secondary command buffers continue
+struct SecondaryRecordInfo {
+  VkRenderPass render_pass;
+  uint32_t subpass = 0;
+  VkFramebuffer framebuffer;
+};
+
 struct CommandBufferCreateInfo {
   CommandPool *pool;
   CommandBufferLevel level;
@@ -38,6 +45,10 @@ public:
 
   void Reset();
   void Begin();
+  // secondary command buffer continues subpass of render pass begun by
+  // primary one with secondary contents, cached ones are submitted again
+  void BeginSecondary(VkRenderPass render_pass, uint32_t subpass,
+                      VkFramebuffer framebuffer, bool one_time_submit = true);
   void End();
 
   void SoloExecute();
@@ -0,0 +1,117 @@
+#include "command_buffer_cache.hpp"
+
+namespace vk {
+
+CommandBufferCache::CommandBufferCache(
+    Device &device, CommandBufferCacheCreateInfo &create_info) {
+  this->device = &device;
+  queue = create_info.queue;
+  timeline = &device.GetTimeline(queue);
+  record = create_info.record;
+  level = create_info.level;
+  inheritance = create_info.inheritance;
+  record_count = 0;
+
+  CreateEntries(create_info.count);
+
+  TRACE("command buffer cache with {0} variants created", entries.size());
+}
+
+CommandBufferCache::~CommandBufferCache() {
+  if (command_pool) {
+    Destroy();
+  }
+}
+
+void CommandBufferCache::Destroy() {
+  WaitIdle();
+
+  entries.clear();
+  command_pool.reset();
+
+  TRACE("command buffer cache destroyed");
+}
+
+void CommandBufferCache::CreateEntries(uint32_t count) {
+  command_pool = make_unique<CommandPool>(*device, queue, count);
+
+  entries.resize(count);
+  for (Entry &entry : entries) {
+    entry.command_buffer =
+        command_pool->AllocateCommandBuffer(level);
+    entry.dirty = true;
+    entry.timeline_value = 0;
+  }
+}
+
+void CommandBufferCache::WaitEntry(Entry &entry) {
+  // value of a Get which was never submitted can not be waited for
+  timeline->Wait(min(entry.timeline_value, timeline->GetSubmittedValue()));
+}
+
+void CommandBufferCache::Invalidate() {
+  for (Entry &entry : entries) {
+    entry.dirty = true;
+  }
+}
+
+void CommandBufferCache::Invalidate(uint32_t index) {
+  entries[index].dirty = true;
+}
+
+void CommandBufferCache::Resize(uint32_t count) {
+  WaitIdle();
+
+  entries.clear();
+  command_pool.reset();
+
+  CreateEntries(count);
+
+  TRACE("command buffer cache resized to {0} variants", count);
+}
+
+void CommandBufferCache::WaitIdle() {
+  for (Entry &entry : entries) {
+    WaitEntry(entry);
+  }
+}
+
+VkCommandBuffer CommandBufferCache::Get(uint32_t index) {
+  if (index >= entries.size()) {
+    throw CriticalException("command buffer cache has no variant " +
+                            to_string(index));
+  }
+
+  Entry &entry = entries[index];
+
+  if (entry.dirty) {
+    // pending command buffer can not be reset
+    WaitEntry(entry);
+
+    entry.command_buffer->Reset();
+    if (level == CommandBufferLevel::secondary) {
+      SecondaryRecordInfo info = inheritance(index);
+      entry.command_buffer->BeginSecondary(info.render_pass, info.subpass,
+                                           info.framebuffer, false);
+    } else {
+      entry.command_buffer->Begin();
+    }
+    record(*entry.command_buffer, index);
+    entry.command_buffer->End();
+
+    entry.dirty = false;
+    record_count++;
+
+    TRACE("command buffer cache variant {0} recorded", index);
+  }
+
+  entry.timeline_value = timeline->GetNextValue();
+
+  return entry.command_buffer->GetHandle();
+}
+
+uint32_t CommandBufferCache::GetCount() { return entries.size(); }
+
+uint32_t CommandBufferCache::GetRecordCount() { return record_count; }
+
+} // namespace vk
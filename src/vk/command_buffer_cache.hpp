@@ -0,0 +1,80 @@
+#pragma once
+#include "command_buffer.hpp"
+#include "command_pool.hpp"
+#include "device.hpp"
+#include "gpu_timeline.hpp"
+#include "queue.hpp"
+#include <functional>
+#include <memory>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+using namespace std;
+
+namespace vk {
+
+struct CommandBufferCacheCreateInfo {
+  // returned command buffers are submitted to this queue
+  Queue queue;
+  // variants, like one per swapchain framebuffer
+  uint32_t count;
+  // writes commands of variant between Begin and End
+  function<void(CommandBuffer &, uint32_t)> record;
+  CommandBufferLevel level = CommandBufferLevel::primary;
+  // render pass subpass which secondary variant continues
+  function<SecondaryRecordInfo(uint32_t)> inheritance;
+};
+
+// keeps one recorded command buffer per variant of a static pass and
+// records it again only after its inputs were marked changed, so passes
+// whose commands do not change cost no recording per frame
+class CommandBufferCache {
+private:
+  struct Entry {
+    unique_ptr<CommandBuffer> command_buffer;
+    bool dirty;
+    // value of submit which may still execute the command buffer
+    uint64_t timeline_value;
+  };
+
+  Device *device;
+  Queue queue;
+  GpuTimeline *timeline;
+  function<void(CommandBuffer &, uint32_t)> record;
+  CommandBufferLevel level;
+  function<SecondaryRecordInfo(uint32_t)> inheritance;
+
+  unique_ptr<CommandPool> command_pool;
+  vector<Entry> entries;
+  uint32_t record_count;
+
+  void CreateEntries(uint32_t count);
+  void WaitEntry(Entry &entry);
+
+public:
+  CommandBufferCache(Device &device, CommandBufferCacheCreateInfo &create_info);
+  CommandBufferCache(CommandBufferCache &) = delete;
+  CommandBufferCache &operator=(CommandBufferCache &) = delete;
+  ~CommandBufferCache();
+
+  void Destroy();
+
+  // recorded variants stay valid until their inputs change
+  void Invalidate();
+  void Invalidate(uint32_t index);
+  // after swapchain recreation, every variant is recorded again
+  void Resize(uint32_t count);
+  // waits until no recorded command buffer is executed, resources they use
+  // can be changed after it
+  void WaitIdle();
+
+  // command buffer must be submitted to queue of the cache before next Get
+  // of the same variant, secondary one executed by primary submitted there
+  VkCommandBuffer Get(uint32_t index);
+
+  uint32_t GetCount();
+  // recordings since creation, stays still while nothing changes
+  uint32_t GetRecordCount();
+};
+
+} // namespace vk
@@ -2,7 +2,8 @@
 
 namespace vk {
 
-CommandPool::CommandPool(Device &device, Queue &queue, uint32_t capacity) {
+CommandPool::CommandPool(Device &device, Queue &queue, uint32_t capacity,
+                         bool transient) {
   this->device = &device;
   this->capacity = capacity;
   this->queue = queue;
@@ -12,7 +13,9 @@ CommandPool::CommandPool(Device &device, Queue &queue, uint32_t capacity) {
   int count = 3;
 
   VkCommandPoolCreateInfo create_info = command_pool_create_info_template;
-  create_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+  create_info.flags = transient
+                         ? VK_COMMAND_POOL_CREATE_TRANSIENT_BIT
+                         : VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
   create_info.queueFamilyIndex = queue.GetFamily();
 
   VkResult result =
@@ -21,8 +24,6 @@ CommandPool::CommandPool(Device &device, Queue &queue, uint32_t capacity) {
     throw CriticalException("cant create command buffer pool");
   }
 
-  CreateSoloExecuteFence();
-
   TRACE("command pool with {0} elements capacity created", capacity);
 }
 
@@ -38,18 +39,13 @@ void CommandPool::Dispose() {
   vkDestroyCommandPool(device->GetHandle(), handle, nullptr);
   handle = VK_NULL_HANDLE;
 
-  vkDestroyFence(device->GetHandle(), solo_execute_fence, nullptr);
-  
   TRACE("command pool destroyed");
 }
 
-void CommandPool::CreateSoloExecuteFence() {
-  VkFenceCreateInfo create_info = fence_create_info_template;
-
-  VkResult result = vkCreateFence(device->GetHandle(), &create_info, nullptr,
-                                  &solo_execute_fence);
+void CommandPool::Reset() {
+  VkResult result = vkResetCommandPool(device->GetHandle(), handle, 0);
   if (result) {
-    throw CriticalException("cant create solo execute fence");
+    throw CriticalException("cant reset command pool");
   }
 }
 
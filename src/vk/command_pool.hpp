@@ -17,21 +17,23 @@ private:
   Device *device;
   Queue queue;
 
-  VkFence solo_execute_fence;
-  
   uint32_t capacity;
   uint32_t size;
 
   void DisposeCommandBufferCallback();
-  void CreateSoloExecuteFence();
-  
+
 public:
-  CommandPool(Device &device, Queue& queue, uint32_t capacity);
+  // buffers of transient pool are short lived and reset only all at once
+  // by Reset, which is cheaper than resetting them one by one
+  CommandPool(Device &device, Queue &queue, uint32_t capacity,
+              bool transient = false);
   CommandPool(CommandPool &) = delete;
   CommandPool &operator=(CommandPool &) = delete;
   ~CommandPool();
 
   void Dispose();
+  // resets every command buffer allocated from pool, none may be pending
+  void Reset();
   unique_ptr<CommandBuffer> AllocateCommandBuffer(CommandBufferLevel level);
   VkCommandPool GetHandle();
 
@@ -0,0 +1,124 @@
+#include "compute_pipeline_builder.hpp"
+
+namespace vk {
+
+ComputePipelineBuilder::ComputePipelineBuilder() {
+  module = VK_NULL_HANDLE;
+  entry = "main";
+  layout = VK_NULL_HANDLE;
+}
+
+ComputePipelineBuilder &ComputePipelineBuilder::SetShader(ShaderModule &module,
+                                                          string entry) {
+  this->module = module.GetHandle();
+  this->entry = entry;
+  filepath.clear();
+  code = module.GetCode();
+  return *this;
+}
+
+ComputePipelineBuilder &ComputePipelineBuilder::SetShader(fs::path filepath,
+                                                          string entry) {
+  module = VK_NULL_HANDLE;
+  this->filepath = filepath;
+  this->entry = entry;
+  code.clear();
+  return *this;
+}
+
+ComputePipelineBuilder &ComputePipelineBuilder::SetSpecialization(
+    SpecializationConstants &specialization) {
+  this->specialization = specialization;
+  return *this;
+}
+
+ComputePipelineBuilder &
+ComputePipelineBuilder::SetLayout(VkPipelineLayout layout) {
+  this->layout = layout;
+  return *this;
+}
+
+void ComputePipelineBuilder::LoadShader() {
+  if (module != VK_NULL_HANDLE || !code.empty()) {
+    return;
+  }
+
+  code = ShaderModule::ReadFile(filepath);
+}
+
+bool ComputePipelineBuilder::UnloadShader(const fs::path &filepath) {
+  if (module != VK_NULL_HANDLE ||
+      fs::weakly_canonical(this->filepath) != fs::weakly_canonical(filepath)) {
+    return false;
+  }
+
+  code.clear();
+  return true;
+}
+
+string ComputePipelineBuilder::GetKey() {
+  LoadShader();
+
+  // graphics pipelines share the cache
+  string key = "compute";
+
+  size_t code_size = code.size();
+  key.append((const char *)&code_size, sizeof(code_size));
+  key.append(code.data(), code.size());
+  key.append(entry);
+  key.push_back('\0');
+  specialization.AppendKey(key);
+  key.append((const char *)&layout, sizeof(layout));
+
+  return key;
+}
+
+size_t ComputePipelineBuilder::Hash() { return hash<string>()(GetKey()); }
+
+VkPipeline ComputePipelineBuilder::Build(Device &device) {
+  if (layout == VK_NULL_HANDLE) {
+    throw CriticalException("compute pipeline has no layout");
+  }
+
+  return device.GetPipelineCache().GetPipeline(
+      GetKey(), [&]() { return Create(device); });
+}
+
+VkPipeline ComputePipelineBuilder::Create(Device &device) {
+  VkShaderModule stage_module = module;
+  if (stage_module == VK_NULL_HANDLE) {
+    stage_module = device.GetPipelineCache().CreateShaderModule(code);
+  }
+
+  VkPipelineShaderStageCreateInfo stage_create_info =
+      pipeline_shader_stage_create_info_template;
+  stage_create_info.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+  stage_create_info.module = stage_module;
+  stage_create_info.pName = entry.c_str();
+  stage_create_info.pSpecializationInfo = specialization.GetInfo();
+
+  VkComputePipelineCreateInfo create_info =
+      compute_pipeline_create_info_template;
+  create_info.stage = stage_create_info;
+  create_info.layout = layout;
+  create_info.basePipelineHandle = VK_NULL_HANDLE;
+  create_info.basePipelineIndex = -1;
+
+  VkPipeline pipeline;
+  VkResult result = vkCreateComputePipelines(
+      device.GetHandle(), device.GetPipelineCache().GetHandle(), 1,
+      &create_info, nullptr, &pipeline);
+
+  // module made from loaded code is not needed after creation
+  if (stage_module != module) {
+    vkDestroyShaderModule(device.GetHandle(), stage_module, nullptr);
+  }
+
+  if (result) {
+    throw CriticalException("cant create compute pipeline");
+  }
+
+  return pipeline;
+}
+
+} // namespace vk
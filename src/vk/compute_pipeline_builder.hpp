@@ -0,0 +1,53 @@
+#pragma once
+#include "device.hpp"
+#include "shader_module.hpp"
+#include "specialization_constants.hpp"
+#include "templates.hpp"
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+using namespace std;
+
+namespace vk {
+
+// compute counterpart of graphics pipeline builder, kernels get map size,
+// workgroup size and similar values as specialization constants, every set
+// of them is one pipeline in device pipeline cache
+class ComputePipelineBuilder {
+private:
+  // null when module is made from code while pipeline is created
+  VkShaderModule module;
+  fs::path filepath;
+  vector<char> code;
+  string entry;
+  SpecializationConstants specialization;
+  VkPipelineLayout layout;
+
+  void LoadShader();
+  VkPipeline Create(Device &device);
+
+public:
+  ComputePipelineBuilder();
+
+  ComputePipelineBuilder &SetShader(ShaderModule &module,
+                                    string entry = "main");
+  // file is read only when pipeline is compiled
+  ComputePipelineBuilder &SetShader(fs::path filepath, string entry = "main");
+  ComputePipelineBuilder &
+  SetSpecialization(SpecializationConstants &specialization);
+  ComputePipelineBuilder &SetLayout(VkPipelineLayout layout);
+
+  // shader file is read again by next Build, returns false when description
+  // does not use it
+  bool UnloadShader(const fs::path &filepath);
+
+  // shader by its code, layout by handle, so it must outlive the cache
+  string GetKey();
+  size_t Hash();
+
+  // returns cached pipeline of identical description or creates one
+  VkPipeline Build(Device &device);
+};
+
+} // namespace vk
@@ -0,0 +1,369 @@
+#include "defragmenter.hpp"
+#include <algorithm>
+
+namespace vk {
+
+Defragmenter::Defragmenter(Device &device,
+                           DefragmenterCreateInfo &create_info) {
+  this->device = &device;
+  frames_in_flight = create_info.frames_in_flight;
+  max_bytes_per_frame = create_info.max_bytes_per_frame;
+  min_fragmentation = create_info.min_fragmentation;
+  current_frame = 0;
+
+  TRACE("defragmenter created");
+}
+
+Defragmenter::~Defragmenter() {
+  if (!retired_allocations.empty() || !retired_views.empty()) {
+    Destroy();
+  }
+}
+
+void Defragmenter::Destroy() {
+  ReleaseRetired(true);
+
+  TRACE("defragmenter destroyed");
+}
+
+void Defragmenter::Step(CommandBuffer &command_buffer) {
+  current_frame++;
+  ReleaseRetired(false);
+
+  VkDeviceSize budget = max_bytes_per_frame;
+
+  MemoryManager &memory_manager = device->GetMemoryManager();
+  for (auto &pool : memory_manager.pools) {
+    if (budget == 0) {
+      break;
+    }
+
+    // mapped pointers are held by users, so host visible memory stays
+    if (pool.blocks.empty() || pool.blocks.front()->IsHostVisible()) {
+      continue;
+    }
+
+    if (IsFragmented(pool)) {
+      PlanMoves(pool, budget);
+    }
+  }
+
+  if (moves.empty()) {
+    return;
+  }
+
+  RecordMoves(command_buffer);
+
+  DEBUG("defragmenter moved {0} allocations, {1} bytes", moves.size(),
+        max_bytes_per_frame - budget);
+
+  for (Move &move : moves) {
+    move.memory_object->NotifyMoved();
+  }
+
+  moves.clear();
+  moved_objects.clear();
+}
+
+void Defragmenter::RetireImageView(VkImageView view) {
+  retired_views.push_back({current_frame, view});
+}
+
+bool Defragmenter::IsFragmented(MemoryManager::MemoryPool &pool) {
+  VkDeviceSize free_size = 0;
+  VkDeviceSize largest_free_size = 0;
+
+  // spare empty block is not a hole, moving objects there does not help
+  for (auto &block : pool.blocks) {
+    if (block->IsEmpty()) {
+      continue;
+    }
+
+    free_size += block->GetFreeSize();
+    largest_free_size = max(largest_free_size, block->GetLargestFreeSize());
+  }
+
+  if (free_size == 0) {
+    return false;
+  }
+
+  float fragmentation = 1.0f - (float)largest_free_size / free_size;
+  return fragmentation >= min_fragmentation;
+}
+
+void Defragmenter::PlanMoves(MemoryManager::MemoryPool &pool,
+                             VkDeviceSize &budget) {
+  // objects from the back of the pool are moved to the front, so last
+  // blocks become empty and holes in the first ones are filled
+  for (uint32_t i = pool.blocks.size(); i-- > 0;) {
+    DeviceMemory &memory = *pool.blocks[i];
+
+    vector<pair<VkDeviceSize, MemoryObject *>> objects;
+    for (auto &[memory_object, block_index] : memory.occupied_blocks) {
+      if (memory_object->IsMovable() && !moved_objects.count(memory_object)) {
+        objects.push_back({memory.GetBlockOffset(block_index), memory_object});
+      }
+    }
+
+    sort(objects.rbegin(), objects.rend());
+
+    for (auto &[offset, memory_object] : objects) {
+      VkDeviceSize object_size = memory_object->GetMemoryRequirements().size;
+      if (object_size > budget) {
+        continue;
+      }
+
+      Move move;
+      move.memory_object = memory_object;
+      move.src_memory = &memory;
+      move.src_block = memory.FindBlock(memory_object);
+      // buffers are the only linear objects binded to device memory
+      move.linear = memory.allocator.GetBlock(move.src_block).linear;
+
+      if (!FindDestination(pool, i, move)) {
+        continue;
+      }
+
+      moves.push_back(move);
+      moved_objects.insert(memory_object);
+
+      budget -= object_size;
+      if (budget == 0) {
+        return;
+      }
+    }
+  }
+}
+
+bool Defragmenter::FindDestination(MemoryManager::MemoryPool &pool,
+                                   uint32_t src_index, Move &move) {
+  VkMemoryRequirements requirements =
+      move.memory_object->GetMemoryRequirements();
+  VkDeviceSize src_offset = move.src_memory->GetBlockOffset(move.src_block);
+
+  for (uint32_t i = 0; i <= src_index; i++) {
+    DeviceMemory &memory = *pool.blocks[i];
+
+    uint32_t block_index = memory.AllocateBlock(requirements, move.linear);
+    if (block_index == TlsfAllocator::null_block) {
+      continue;
+    }
+
+    // inside the same block object only moves down
+    if (i == src_index && memory.GetBlockOffset(block_index) >= src_offset) {
+      memory.ReleaseBlock(block_index);
+      return false;
+    }
+
+    move.dst_memory = &memory;
+    move.dst_block = block_index;
+    return true;
+  }
+
+  return false;
+}
+
+void Defragmenter::RecordMoves(CommandBuffer &command_buffer) {
+  struct BufferCopy {
+    VkBuffer src;
+    VkBuffer dst;
+    VkBufferCopy region;
+  };
+
+  struct ImageCopy {
+    VkImage src;
+    VkImage dst;
+    vector<VkImageCopy> regions;
+  };
+
+  vector<BufferCopy> buffer_copies;
+  vector<ImageCopy> image_copies;
+  BarrierBatch pre_barriers(*device);
+  BarrierBatch post_barriers(*device);
+
+  for (Move &move : moves) {
+    RetiredAllocation retired{};
+    retired.frame = current_frame;
+    retired.memory = move.src_memory;
+    retired.block_index = move.src_block;
+
+    if (move.linear) {
+      Buffer &buffer = *(Buffer *)move.memory_object;
+      retired.buffer = MoveBuffer(move);
+      retired_allocations.push_back(retired);
+
+      BufferCopy copy;
+      copy.src = retired.buffer;
+      copy.dst = buffer.GetHandle();
+      copy.region.srcOffset = 0;
+      copy.region.dstOffset = 0;
+      copy.region.size = buffer.GetSize();
+      buffer_copies.push_back(copy);
+    } else {
+      Image &image = *(Image *)move.memory_object;
+      retired.image = MoveImage(move);
+      retired_allocations.push_back(retired);
+
+      // image without content is just rebinded
+      if (image.GetLayout() == VK_IMAGE_LAYOUT_UNDEFINED) {
+        continue;
+      }
+
+      VkImageMemoryBarrier barrier = image_memory_barrier_template;
+      barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+      barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+      barrier.subresourceRange = image.GetSubresourceRange();
+
+      barrier.image = retired.image;
+      barrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+      barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+      barrier.oldLayout = image.GetLayout();
+      barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+      pre_barriers.Add(VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT, barrier);
+
+      barrier.image = image.GetHandle();
+      barrier.srcAccessMask = 0;
+      barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+      barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+      barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+      pre_barriers.Add(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT, barrier);
+
+      barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+      barrier.dstAccessMask =
+          VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+      barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+      barrier.newLayout = image.GetLayout();
+      post_barriers.Add(VK_PIPELINE_STAGE_TRANSFER_BIT,
+                        VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, barrier);
+
+      ImageCopy copy;
+      copy.src = retired.image;
+      copy.dst = image.GetHandle();
+
+      VkExtent3D extent = image.GetExtent();
+      for (uint32_t level = 0; level < image.GetMipLevels(); level++) {
+        VkImageCopy region{};
+        region.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1};
+        region.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1};
+        region.extent = extent;
+        copy.regions.push_back(region);
+
+        extent.width = max(extent.width / 2, 1u);
+        extent.height = max(extent.height / 2, 1u);
+      }
+
+      image_copies.push_back(std::move(copy));
+    }
+  }
+
+  VkMemoryBarrier memory_barrier = memory_barrier_template;
+  memory_barrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+  memory_barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+  pre_barriers.Add(VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                   VK_PIPELINE_STAGE_TRANSFER_BIT, memory_barrier);
+  pre_barriers.Flush(command_buffer);
+
+  for (BufferCopy &copy : buffer_copies) {
+    vkCmdCopyBuffer(command_buffer.GetHandle(), copy.src, copy.dst, 1,
+                    &copy.region);
+  }
+
+  for (ImageCopy &copy : image_copies) {
+    vkCmdCopyImage(command_buffer.GetHandle(), copy.src,
+                   VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, copy.dst,
+                   VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, copy.regions.size(),
+                   copy.regions.data());
+  }
+
+  memory_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  memory_barrier.dstAccessMask =
+      VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+
+  post_barriers.Add(VK_PIPELINE_STAGE_TRANSFER_BIT,
+                    VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, memory_barrier);
+  post_barriers.Flush(command_buffer);
+
+  TRACE("{0} buffer and {1} image copies wrote to command buffer",
+        buffer_copies.size(), image_copies.size());
+}
+
+VkBuffer Defragmenter::MoveBuffer(Move &move) {
+  Buffer &buffer = *(Buffer *)move.memory_object;
+  VkBuffer old_handle = buffer.handle;
+
+  move.src_memory->DetachBlock(&buffer);
+
+  buffer.CreateHandle();
+  move.dst_memory->AttachBlock(&buffer, move.dst_block);
+  move.dst_memory->BindBuffer(buffer, move.dst_block);
+
+  return old_handle;
+}
+
+VkImage Defragmenter::MoveImage(Move &move) {
+  Image &image = *(Image *)move.memory_object;
+  VkImage old_handle = image.handle;
+
+  move.src_memory->DetachBlock(&image);
+
+  image.CreateHandle(VK_IMAGE_LAYOUT_UNDEFINED);
+  move.dst_memory->AttachBlock(&image, move.dst_block);
+  move.dst_memory->BindImage(image, move.dst_block);
+
+  return old_handle;
+}
+
+void Defragmenter::ReleaseRetired(bool all) {
+  MemoryManager &memory_manager = device->GetMemoryManager();
+
+  // frame slot is reused only after its fence signaled, so allocations
+  // retired frames_in_flight steps ago are no longer used by gpu
+  auto released_views = partition(
+      retired_views.begin(), retired_views.end(), [&](RetiredView &retired) {
+        return !all && retired.frame + frames_in_flight > current_frame;
+      });
+
+  // views are destroyed before images they point at
+  for (auto it = released_views; it != retired_views.end(); it++) {
+    vkDestroyImageView(device->GetHandle(), it->view, nullptr);
+  }
+
+  retired_views.erase(released_views, retired_views.end());
+
+  auto released = partition(
+      retired_allocations.begin(), retired_allocations.end(),
+      [&](RetiredAllocation &retired) {
+        return !all && retired.frame + frames_in_flight > current_frame;
+      });
+
+  for (auto it = released; it != retired_allocations.end(); it++) {
+    if (it->buffer) {
+      vkDestroyBuffer(device->GetHandle(), it->buffer, nullptr);
+    }
+
+    if (it->image) {
+      vkDestroyImage(device->GetHandle(), it->image, nullptr);
+    }
+
+    it->memory->ReleaseBlock(it->block_index);
+    memory_manager.ReleaseEmptyBlocks(it->memory);
+  }
+
+  retired_allocations.erase(released, retired_allocations.end());
+}
+
+void Defragmenter::PrintFragmentation() {
+  for (auto &fragmentation :
+       device->GetMemoryManager().GetFragmentation()) {
+    DEBUG("memory type {0}: {1} blocks, {2} of {3} bytes free, largest free "
+          "block {4} bytes",
+          fragmentation.memory_type, fragmentation.block_count,
+          fragmentation.free_size, fragmentation.total_size,
+          fragmentation.largest_free_size);
+  }
+}
+
+} // namespace vk
@@ -0,0 +1,93 @@
+#pragma once
+#include "barrier_batch.hpp"
+#include "buffer.hpp"
+#include "command_buffer.hpp"
+#include "device.hpp"
+#include "device_memory.hpp"
+#include "image.hpp"
+#include "memory_manager.hpp"
+#include <unordered_set>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+using namespace std;
+
+namespace vk {
+
+struct DefragmenterCreateInfo {
+  uint32_t frames_in_flight;
+  VkDeviceSize max_bytes_per_frame;
+  // pools with lower 1 - largest free / total free are left alone
+  float min_fragmentation = 0.25f;
+};
+
+// moves movable buffers and images to lower blocks and offsets a few per
+// frame, content is copied on gpu and old allocations are released when
+// frames that could still use them are finished
+class Defragmenter {
+private:
+  struct Move {
+    MemoryObject *memory_object;
+    bool linear;
+    DeviceMemory *src_memory;
+    uint32_t src_block;
+    DeviceMemory *dst_memory;
+    uint32_t dst_block;
+  };
+
+  struct RetiredAllocation {
+    uint64_t frame;
+    DeviceMemory *memory;
+    uint32_t block_index;
+    VkBuffer buffer;
+    VkImage image;
+  };
+
+  struct RetiredView {
+    uint64_t frame;
+    VkImageView view;
+  };
+
+  Device *device;
+  uint32_t frames_in_flight;
+  VkDeviceSize max_bytes_per_frame;
+  float min_fragmentation;
+
+  uint64_t current_frame;
+  vector<Move> moves;
+  unordered_set<MemoryObject *> moved_objects;
+  vector<RetiredAllocation> retired_allocations;
+  vector<RetiredView> retired_views;
+
+  bool IsFragmented(MemoryManager::MemoryPool &pool);
+  void PlanMoves(MemoryManager::MemoryPool &pool, VkDeviceSize &budget);
+  bool FindDestination(MemoryManager::MemoryPool &pool, uint32_t src_index,
+                       Move &move);
+
+  void RecordMoves(CommandBuffer &command_buffer);
+  VkBuffer MoveBuffer(Move &move);
+  VkImage MoveImage(Move &move);
+
+  void ReleaseRetired(bool all);
+
+public:
+  Defragmenter(Device &device, DefragmenterCreateInfo &create_info);
+  Defragmenter(Defragmenter &) = delete;
+  Defragmenter &operator=(Defragmenter &) = delete;
+  ~Defragmenter();
+
+  // all frames which used moved objects must be finished
+  void Destroy();
+
+  // must be called once per frame, outside of a render pass and before
+  // commands which use movable objects
+  void Step(CommandBuffer &command_buffer);
+
+  // view of moved image, which frames in flight can still sample, is
+  // destroyed together with old image, called from move callbacks
+  void RetireImageView(VkImageView view);
+
+  void PrintFragmentation();
+};
+
+} // namespace vk
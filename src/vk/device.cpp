@@ -1,8 +1,9 @@
 #include "device.hpp"
 #include "../logs.hpp"
-#include "device_memory.hpp"
+#include "memory_manager.hpp"
 #include "templates.hpp"
 #include <algorithm>
+#include <map>
 #include <vulkan/vulkan_core.h>
 
 namespace vk {
@@ -11,18 +12,38 @@ Device::Device(shared_ptr<PhysicalDevice> physical_device,
                DeviceCreateInfo &create_info) {
   this->physical_device = physical_device;
 
+  CheckFeatures();
+
   vector<uint32_t> queue_family_indices;
+  vector<uint32_t> queue_indices;
   vector<VkDeviceQueueCreateInfo> queue_create_infos = GenerateQueueCreateInfos(
-      create_info.queue_requests, queue_family_indices);
+      create_info.queue_requests, queue_family_indices, queue_indices);
 
   // device create info
   VkDeviceCreateInfo vk_create_info = device_create_info_template;
   vk_create_info.queueCreateInfoCount = queue_create_infos.size();
   vk_create_info.pQueueCreateInfos = queue_create_infos.data();
 
-  const char *extensions = VK_KHR_SWAPCHAIN_EXTENSION_NAME;
-  vk_create_info.enabledExtensionCount = 1;
-  vk_create_info.ppEnabledExtensionNames = &extensions;
+  VkPhysicalDeviceVulkan12Features vulkan12_features{};
+  vulkan12_features.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+  vulkan12_features.timelineSemaphore = VK_TRUE;
+  vk_create_info.pNext = &vulkan12_features;
+
+  ChooseExtensions(create_info);
+
+  VkPhysicalDeviceSynchronization2FeaturesKHR synchronization2_features{};
+  synchronization2_features.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR;
+  synchronization2_features.synchronization2 = VK_TRUE;
+  if (IsExtensionEnabled(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME)) {
+    vulkan12_features.pNext = &synchronization2_features;
+  }
+
+  vector<const char *> extensions =
+      tools::string_vector_to_c_array(enabled_extensions);
+  vk_create_info.enabledExtensionCount = extensions.size();
+  vk_create_info.ppEnabledExtensionNames = extensions.data();
 
   TRACE("device create info generated");
 
@@ -34,14 +55,28 @@ Device::Device(shared_ptr<PhysicalDevice> physical_device,
 
   DEBUG("device created");
 
+  cmd_pipeline_barrier2 = nullptr;
+  if (IsExtensionEnabled(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME)) {
+    cmd_pipeline_barrier2 = (PFN_vkCmdPipelineBarrier2KHR)vkGetDeviceProcAddr(
+        handle, "vkCmdPipelineBarrier2KHR");
+  }
+
   for (int i = 0; i < create_info.queue_requests.size(); i++) {
     uint32_t family = queue_family_indices[i];
     VkQueue queue;
-    vkGetDeviceQueue(handle, family, 0, &queue);
+    vkGetDeviceQueue(handle, family, queue_indices[i], &queue);
     *create_info.queue_requests[i].queue = Queue(queue, family);
+
+    if (!timelines.contains(queue)) {
+      timelines[queue] = make_unique<GpuTimeline>(*this, Queue(queue, family));
+    }
   }
 
   TRACE("device queues returned");
+
+  memory_manager = make_unique<MemoryManager>(*this);
+  pipeline_cache =
+      make_unique<PipelineCache>(*this, create_info.pipeline_cache_path);
 }
 
 Device::~Device() {
@@ -53,6 +88,11 @@ Device::~Device() {
 }
 
 void Device::Dispose() {
+  // written back to its file
+  pipeline_cache.reset();
+  memory_manager.reset();
+  timelines.clear();
+
   vkDestroyDevice(handle, nullptr);
   handle = VK_NULL_HANDLE;
   
@@ -61,28 +101,39 @@ void Device::Dispose() {
 
 vector<VkDeviceQueueCreateInfo> Device::GenerateQueueCreateInfos(
     vector<DeviceCreateInfo::QueueRequest> &request,
-    vector<uint32_t> &queues_family_indices) {
-  vector<uint32_t> queue_families;
-
-  queue_families.clear();
+    vector<uint32_t> &queues_family_indices, vector<uint32_t> &queue_indices) {
+  map<uint32_t, uint32_t> family_queue_counts;
 
   for (int i = 0; i < request.size(); i++) {
-    uint32_t family = physical_device->ChooseQueueFamily(request[i].flags);
+    uint32_t family = physical_device->ChooseQueueFamily(
+        request[i].flags, request[i].avoided_flags);
+    uint32_t available_count =
+        physical_device->GetQueueFamilyProperties(family).queueCount;
+
+    // requests sharing a family get own queues while the family has them
+    uint32_t &count = family_queue_counts[family];
+    queue_indices.push_back(min(count, available_count - 1));
+    count = min(count + 1, available_count);
 
-    queue_families.push_back(family);
     queues_family_indices.push_back(family);
-  }
 
-  auto end = unique(queue_families.begin(), queue_families.end());
-  queue_families.resize(distance(queue_families.begin(), end));
+    DEBUG("queue {0} of family {1} chosen for flags {2}",
+          queue_indices.back(), family, request[i].flags);
+  }
 
   vector<VkDeviceQueueCreateInfo> create_infos;
 
-  for (int i = 0; i < queue_families.size(); i++) {
+  for (auto &[family, count] : family_queue_counts) {
+    if (queue_priorities.size() < count) {
+      queue_priorities.resize(count, queue_priority);
+    }
+  }
+
+  for (auto &[family, count] : family_queue_counts) {
     VkDeviceQueueCreateInfo create_info = vk::queue_create_info_template;
-    create_info.queueFamilyIndex = queue_families[i];
-    create_info.queueCount = 1;
-    create_info.pQueuePriorities = &queue_priority;
+    create_info.queueFamilyIndex = family;
+    create_info.queueCount = count;
+    create_info.pQueuePriorities = queue_priorities.data();
 
     create_infos.push_back(create_info);
   }
@@ -90,8 +141,61 @@ vector<VkDeviceQueueCreateInfo> Device::GenerateQueueCreateInfos(
   return create_infos;
 }
 
+void Device::CheckFeatures() {
+  if (physical_device->GetApiVersion() < VK_API_VERSION_1_2 ||
+      !physical_device->GetVulkan12Features().timelineSemaphore) {
+    throw CriticalException("device does not support timeline semaphores");
+  }
+}
+
+void Device::ChooseExtensions(DeviceCreateInfo &create_info) {
+  enabled_extensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+
+  for (string &extension : create_info.optional_extensions) {
+    // extension is useless without its feature
+    if (extension == VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME &&
+        !physical_device->IsSynchronization2Supported()) {
+      DEBUG("synchronization2 feature is not supported");
+      continue;
+    }
+
+    if (physical_device->IsExtensionSupported(extension.c_str())) {
+      enabled_extensions.push_back(extension);
+    } else {
+      DEBUG("optional device extension {0} is not supported", extension);
+    }
+  }
+}
+
 PhysicalDevice &Device::GetPhysicalDevice() { return *physical_device; }
 
+MemoryManager &Device::GetMemoryManager() { return *memory_manager; }
+
+PipelineCache &Device::GetPipelineCache() { return *pipeline_cache; }
+
+GpuTimeline &Device::GetTimeline(Queue queue) {
+  auto timeline = timelines.find(queue.GetHandle());
+  if (timeline == timelines.end()) {
+    throw CriticalException("queue has no timeline");
+  }
+
+  return *timeline->second;
+}
+
 VkDevice Device::GetHandle() { return handle; }
 
+bool Device::IsExtensionEnabled(const char *extension_name) {
+  return find(enabled_extensions.begin(), enabled_extensions.end(),
+              extension_name) != enabled_extensions.end();
+}
+
+bool Device::IsSynchronization2Enabled() {
+  return cmd_pipeline_barrier2 != nullptr;
+}
+
+void Device::CmdPipelineBarrier2(VkCommandBuffer command_buffer,
+                                 VkDependencyInfoKHR &dependency_info) {
+  cmd_pipeline_barrier2(command_buffer, &dependency_info);
+}
+
 } // namespace vk
@@ -1,36 +1,59 @@
 #pragma once
 #include "exception.hpp"
+#include "gpu_timeline.hpp"
+#include "pipeline_cache.hpp"
 #include "physical_device.hpp"
 #include "queue.hpp"
 #include "tools.hpp"
 #include <algorithm>
+#include <map>
+#include <memory>
 #include <vulkan/vulkan_core.h>
 
 using namespace std;
 
 namespace vk {
 
-class DeviceMemory;
+class MemoryManager;
 
 struct DeviceCreateInfo {
   struct QueueRequest {
     VkQueueFlags flags;
+    // families with these flags are used only when no other family fits,
+    // like graphics for dedicated transfer or async compute queues
+    VkQueueFlags avoided_flags = 0;
     Queue *queue;
   };
 
   vector<QueueRequest> queue_requests;
+  // enabled only when physical device supports them
+  vector<string> optional_extensions;
+  // pipeline cache is kept between runs in this file, empty keeps it in
+  // memory only
+  fs::path pipeline_cache_path;
 };
 
 class Device {
 private:
   VkDevice handle;
   shared_ptr<PhysicalDevice> physical_device;
+  unique_ptr<MemoryManager> memory_manager;
+  vector<string> enabled_extensions;
+  // one per queue, requests sharing a queue share its timeline
+  map<VkQueue, unique_ptr<GpuTimeline>> timelines;
+  unique_ptr<PipelineCache> pipeline_cache;
+  // loaded only when VK_KHR_synchronization2 is enabled
+  PFN_vkCmdPipelineBarrier2KHR cmd_pipeline_barrier2;
 
   static constexpr float queue_priority = 1;
+  vector<float> queue_priorities;
 
   vector<VkDeviceQueueCreateInfo>
   GenerateQueueCreateInfos(vector<DeviceCreateInfo::QueueRequest> &request,
-                           vector<uint32_t> &queues_family_indices);
+                           vector<uint32_t> &queues_family_indices,
+                           vector<uint32_t> &queue_indices);
+  void ChooseExtensions(DeviceCreateInfo &create_info);
+  void CheckFeatures();
 
 public:
   Device(shared_ptr<PhysicalDevice> physical_device,
@@ -41,7 +64,14 @@ public:
 
   void Dispose();
   PhysicalDevice &GetPhysicalDevice();
+  MemoryManager &GetMemoryManager();
+  GpuTimeline &GetTimeline(Queue queue);
+  PipelineCache &GetPipelineCache();
   VkDevice GetHandle();
+  bool IsExtensionEnabled(const char *extension_name);
+  bool IsSynchronization2Enabled();
+  void CmdPipelineBarrier2(VkCommandBuffer command_buffer,
+                           VkDependencyInfoKHR &dependency_info);
 };
 
 } // namespace vk
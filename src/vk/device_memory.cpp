@@ -2,16 +2,27 @@
 
 namespace vk {
 
-DeviceMemory::DeviceMemory(Device &device, VkDeviceSize size, uint32_t type) {
+DeviceMemory::DeviceMemory(Device &device, VkDeviceSize size, uint32_t type,
+                           VkMemoryDedicatedAllocateInfo *dedicated_info)
+    : allocator(size,
+                device.GetPhysicalDevice().GetLimits().bufferImageGranularity) {
   this->device = device.GetHandle();
   this->size = size;
+  this->type = type;
 
   VkPhysicalDeviceLimits device_limits = device.GetPhysicalDevice().GetLimits();
   non_coherent_atom_size = device_limits.nonCoherentAtomSize;
 
+  VkMemoryPropertyFlags properties =
+      device.GetPhysicalDevice().GetMemoryTypeProperties(type);
+  host_visible = properties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+  host_coherent = properties & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+  mapped_data = nullptr;
+  dedicated = dedicated_info != nullptr;
+
   VkMemoryAllocateInfo vk_allocate_info;
   vk_allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-  vk_allocate_info.pNext = nullptr;
+  vk_allocate_info.pNext = dedicated_info;
   vk_allocate_info.allocationSize = size;
   vk_allocate_info.memoryTypeIndex = type;
 
@@ -21,12 +32,9 @@ DeviceMemory::DeviceMemory(Device &device, VkDeviceSize size, uint32_t type) {
     throw CriticalException("cant allocate memory");
   }
 
-  MemorySegment segment;
-  segment.empty = true;
-  segment.offset = 0;
-  segment.size = size;
-
-  memory_segments.push_back(segment);
+  if (host_visible) {
+    Map();
+  }
 }
 
 DeviceMemory::~DeviceMemory() {
@@ -50,106 +58,170 @@ DeviceMemory::CalculateMemorySize(vector<MemoryObject *> &buffers) {
   return size;
 }
 
-void *DeviceMemory::MapMemory(MemoryObject *memory_object) {
-  uint32_t segment_index = FindSegment(memory_object);
-  MemorySegment &buffer_segment = memory_segments[segment_index];
-
-  mapped_segment = CreateAlignedMemorySegment(buffer_segment);
-
-  void *mapped_ptr;
-  VkResult result = vkMapMemory(device, handle, mapped_segment.offset,
-                                mapped_segment.size, 0, &mapped_ptr);
+void DeviceMemory::Map() {
+  VkResult result = vkMapMemory(device, handle, 0, VK_WHOLE_SIZE, 0,
+                                &mapped_data);
   if (result) {
     throw CriticalException("cant map memory");
   }
 
-  return (char *)mapped_ptr - mapped_segment.offset +
-         buffer_segment.buffer_offset;
+  TRACE("device memory persistently mapped");
 }
 
-DeviceMemory::MemorySegment
-DeviceMemory::CreateAlignedMemorySegment(MemorySegment &buffer_segment) {
-  MemorySegment aligned_segment;
-
-  // align pos
-  aligned_segment.offset =
-      tools::align_down(buffer_segment.offset, non_coherent_atom_size);
-  aligned_segment.offset = max(aligned_segment.offset, (VkDeviceSize)0);
+void DeviceMemory::Unmap() {
+  vkUnmapMemory(device, handle);
+  mapped_data = nullptr;
+};
 
-  VkDeviceSize aligned_size =
-      buffer_segment.size + (buffer_segment.offset - aligned_segment.offset);
+void *DeviceMemory::GetMappedData(MemoryObject *memory_object) {
+  if (!mapped_data) {
+    throw CriticalException("device memory is not host visible");
+  }
 
-  // align size
-  aligned_segment.size = tools::align_up(aligned_size, non_coherent_atom_size);
-  aligned_segment.size =
-      min(aligned_segment.size, size - aligned_segment.offset);
+  uint32_t block_index = FindBlock(memory_object);
+  const TlsfAllocator::Block &block = allocator.GetBlock(block_index);
 
-  return aligned_segment;
+  return (char *)mapped_data + block.offset;
 }
 
-void DeviceMemory::Flush() {
+VkMappedMemoryRange DeviceMemory::CreateMappedRange(MemoryObject *memory_object,
+                                                    VkDeviceSize offset,
+                                                    VkDeviceSize range_size) {
+  uint32_t block_index = FindBlock(memory_object);
+  const TlsfAllocator::Block &block = allocator.GetBlock(block_index);
+
+  if (range_size == VK_WHOLE_SIZE) {
+    range_size = block.size - offset;
+  }
+
+  VkDeviceSize range_offset = block.offset + offset;
+
   VkMappedMemoryRange mapped_range;
   mapped_range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
   mapped_range.pNext = nullptr;
   mapped_range.memory = handle;
-  mapped_range.offset = mapped_segment.offset;
-  mapped_range.size = mapped_segment.size;
 
+  // align pos
+  mapped_range.offset = tools::align_down(range_offset, non_coherent_atom_size);
+
+  // align size
+  VkDeviceSize aligned_size = range_size + (range_offset - mapped_range.offset);
+  mapped_range.size = tools::align_up(aligned_size, non_coherent_atom_size);
+  if (mapped_range.offset + mapped_range.size > size) {
+    mapped_range.size = VK_WHOLE_SIZE;
+  }
+
+  return mapped_range;
+}
+
+void DeviceMemory::Flush(VkMappedMemoryRange &mapped_range) {
   VkResult result = vkFlushMappedMemoryRanges(device, 1, &mapped_range);
   if (result) {
     throw CriticalException("cant flush mapped memory");
   }
 }
 
-void DeviceMemory::Unmap() { vkUnmapMemory(device, handle); };
-
 void DeviceMemory::Free() {
+  if (mapped_data) {
+    Unmap();
+  }
+
   vkFreeMemory(device, handle, nullptr);
   handle = VK_NULL_HANDLE;
 
   TRACE("device memory freed");
 }
 
+uint32_t DeviceMemory::GetType() { return type; }
+
+bool DeviceMemory::IsEmpty() { return allocator.IsEmpty(); }
+
+bool DeviceMemory::IsDedicated() { return dedicated; }
+
+bool DeviceMemory::IsHostVisible() { return host_visible; }
+
+bool DeviceMemory::IsHostCoherent() { return host_coherent; }
+
+VkDeviceSize DeviceMemory::GetSize() { return size; }
+
+VkDeviceSize DeviceMemory::GetFreeSize() { return allocator.GetFreeSize(); }
+
+VkDeviceSize DeviceMemory::GetLargestFreeSize() {
+  return allocator.GetLargestFreeSize();
+}
+
+VkDeviceMemory DeviceMemory::GetHandle() { return handle; }
+
 void DeviceMemory::PrintSegments() {
-  for (auto &s : memory_segments) {
+  for (uint32_t i = allocator.GetFirstBlock(); i != TlsfAllocator::null_block;
+       i = allocator.GetBlock(i).next_physical) {
+    const TlsfAllocator::Block &s = allocator.GetBlock(i);
     cout << s.offset << " " << s.size << " " << (s.empty ? "empty" : "occupied")
          << endl;
   };
 }
 
 void DeviceMemory::BindImage(Image &buffer) {
-  VkMemoryRequirements requirements = buffer.GetMemoryRequirements();
-  uint32_t segment_index = FindSuitableSegment(requirements);
+  uint32_t block_index = OccupieBlock(buffer.GetMemoryRequirements(), false,
+                                      &buffer);
+  if (block_index == TlsfAllocator::null_block) {
+    throw CriticalException("cant find empty memory range");
+  }
+
+  BindImage(buffer, block_index);
+}
 
-  MemorySegment &segment = memory_segments[segment_index];
-  VkDeviceSize aligned_pos, aligned_size;
-  segment.GetAlignedSegment(requirements.alignment, &aligned_pos,
-                            &aligned_size);
-  OccupieSegment(segment_index, requirements.size, aligned_pos, &buffer);
+bool DeviceMemory::TryBindImage(Image &image) {
+  uint32_t block_index =
+      OccupieBlock(image.GetMemoryRequirements(), false, &image);
+  if (block_index == TlsfAllocator::null_block) {
+    return false;
+  }
+
+  BindImage(image, block_index);
+  return true;
+}
+
+void DeviceMemory::BindImage(Image &image, uint32_t block_index) {
+  VkDeviceSize offset = allocator.GetBlock(block_index).offset;
 
   VkResult result =
-      vkBindImageMemory(device, buffer.GetHandle(), handle, aligned_pos);
+      vkBindImageMemory(device, image.GetHandle(), handle, offset);
   if (result) {
-    throw CriticalException("cant bind buffer to memory");
+    throw CriticalException("cant bind image to memory");
   }
 
-  buffer.memory = this;
+  image.memory = this;
 
   TRACE("image binded");
 }
 
 void DeviceMemory::BindBuffer(Buffer &buffer) {
-  VkMemoryRequirements requirements = buffer.GetMemoryRequirements();
-  uint32_t segment_index = FindSuitableSegment(requirements);
+  uint32_t block_index =
+      OccupieBlock(buffer.GetMemoryRequirements(), true, &buffer);
+  if (block_index == TlsfAllocator::null_block) {
+    throw CriticalException("cant find empty memory range");
+  }
 
-  MemorySegment &segment = memory_segments[segment_index];
-  VkDeviceSize aligned_pos, aligned_size;
-  segment.GetAlignedSegment(requirements.alignment, &aligned_pos,
-                            &aligned_size);
-  OccupieSegment(segment_index, requirements.size, aligned_pos, &buffer);
+  BindBuffer(buffer, block_index);
+}
+
+bool DeviceMemory::TryBindBuffer(Buffer &buffer) {
+  uint32_t block_index =
+      OccupieBlock(buffer.GetMemoryRequirements(), true, &buffer);
+  if (block_index == TlsfAllocator::null_block) {
+    return false;
+  }
+
+  BindBuffer(buffer, block_index);
+  return true;
+}
+
+void DeviceMemory::BindBuffer(Buffer &buffer, uint32_t block_index) {
+  VkDeviceSize offset = allocator.GetBlock(block_index).offset;
 
   VkResult result =
-      vkBindBufferMemory(device, buffer.GetHandle(), handle, aligned_pos);
+      vkBindBufferMemory(device, buffer.GetHandle(), handle, offset);
   if (result) {
     throw CriticalException("cant bind buffer to memory");
   }
@@ -160,135 +232,54 @@ void DeviceMemory::BindBuffer(Buffer &buffer) {
   TRACE("buffer binded");
 }
 
-void DeviceMemory::FreeBuffer(Buffer *buffer) {
-  uint32_t segment_index = FindSegment(buffer);
-  FreeSegment(segment_index);
-};
-
-void DeviceMemory::FreeSegment(uint32_t segment_index) {
-  MemorySegment &segment = memory_segments[segment_index];
-  segment.empty = true;
+void DeviceMemory::FreeBlock(MemoryObject *memory_object) {
+  ReleaseBlock(DetachBlock(memory_object));
+}
 
-  // merge left segment
-  if (segment_index > 0) {
-    if (memory_segments[segment_index - 1].empty) {
-      MergeSegment(segment_index - 1, segment_index);
-      segment_index--;
-    }
+uint32_t DeviceMemory::FindBlock(MemoryObject *memory_object) {
+  auto block = occupied_blocks.find(memory_object);
+  if (block == occupied_blocks.end()) {
+    throw CriticalException("no suck buffer binded to device memory");
   }
 
-  // merge right segment
-  if (segment_index < memory_segments.size() - 1) {
-    if (memory_segments[segment_index + 1].empty) {
-      MergeSegment(segment_index, segment_index + 1);
-    }
-  }
+  return block->second;
 }
 
-void DeviceMemory::MergeSegment(uint32_t segment1_index,
-                                uint32_t segment2_index) {
-  MemorySegment &segment1 = memory_segments[segment1_index];
-  MemorySegment &segment2 = memory_segments[segment2_index];
+uint32_t DeviceMemory::OccupieBlock(VkMemoryRequirements requirements,
+                                    bool linear, MemoryObject *memory_object) {
+  uint32_t block_index = AllocateBlock(requirements, linear);
+  if (block_index == TlsfAllocator::null_block) {
+    return block_index;
+  }
 
-  MemorySegment merged_segment;
-  merged_segment.empty = true;
-  merged_segment.offset = min(segment1.offset, segment2.offset);
-  merged_segment.size = segment1.size + segment2.size;
+  AttachBlock(memory_object, block_index);
 
-  memory_segments[segment1_index] = merged_segment;
-  memory_segments.erase(memory_segments.begin() + segment2_index);
+  return block_index;
 }
 
-uint32_t DeviceMemory::FindSegment(MemoryObject *memory_object) {
-  for (int i = 0; i < memory_segments.size(); i++) {
-    MemorySegment &segment = memory_segments[i];
-
-    if (segment.memory_object == memory_object) {
-      return i;
-    }
-  }
-
-  throw CriticalException("no suck buffer binded to device memory");
+uint32_t DeviceMemory::AllocateBlock(VkMemoryRequirements requirements,
+                                     bool linear) {
+  return allocator.Allocate(requirements.size, requirements.alignment, linear);
 }
 
-void DeviceMemory::OccupieSegment(uint32_t segment_index, VkDeviceSize size,
-                                  VkDeviceSize buffer_offset,
-                                  MemoryObject *memory_object) {
-  MemorySegment initial_segment = memory_segments[segment_index];
-
-  MemorySegment occupied_segment;
-  occupied_segment.empty = false;
-  occupied_segment.offset = initial_segment.offset;
-  occupied_segment.buffer_offset = buffer_offset;
-  occupied_segment.size = size;
-  occupied_segment.memory_object = memory_object;
-
-  memory_segments[segment_index] = occupied_segment;
-
-  MemorySegment empty_segment;
-  empty_segment.empty = true;
-  empty_segment.offset = initial_segment.offset + size;
-  empty_segment.size = initial_segment.size - size;
-
-  if (empty_segment.size) {
-    memory_segments.insert(memory_segments.begin() + segment_index + 1,
-                           empty_segment);
-  }
+void DeviceMemory::ReleaseBlock(uint32_t block_index) {
+  allocator.Free(block_index);
 }
 
-uint32_t DeviceMemory::FindSuitableSegment(VkMemoryRequirements requirements) {
-  int optimal_segment = -1;
-  VkDeviceSize optimal_segment_empty_space =
-      numeric_limits<VkDeviceSize>::max();
-
-  for (int i = 0; i < memory_segments.size(); i++) {
-    MemorySegment &segment = memory_segments[i];
-    if (!segment.empty) {
-      continue;
-    }
-
-    VkDeviceSize empty_space;
-    bool is_suitable = segment.IsSuitable(requirements, empty_space);
-    if (!is_suitable) {
-      break;
-    }
-
-    if (empty_space < optimal_segment_empty_space) {
-      optimal_segment = i;
-      optimal_segment_empty_space = empty_space;
-    }
-  }
-
-  if (optimal_segment == -1) {
-    throw CriticalException("cant find empty memory range");
-  }
-
-  return optimal_segment;
+void DeviceMemory::AttachBlock(MemoryObject *memory_object,
+                               uint32_t block_index) {
+  occupied_blocks[memory_object] = block_index;
 }
 
-bool DeviceMemory::MemorySegment::IsSuitable(VkMemoryRequirements requirements,
-                                             VkDeviceSize &empty_space) {
-  VkDeviceSize aligned_size;
-  GetAlignedSegment(requirements.alignment, nullptr, &aligned_size);
+uint32_t DeviceMemory::DetachBlock(MemoryObject *memory_object) {
+  uint32_t block_index = FindBlock(memory_object);
+  occupied_blocks.erase(memory_object);
 
-  empty_space = size - requirements.size;
-
-  return aligned_size >= requirements.size;
+  return block_index;
 }
 
-void DeviceMemory::MemorySegment::GetAlignedSegment(
-    VkDeviceSize alignment, VkDeviceSize *aligned_pos_output,
-    VkDeviceSize *aligned_size) {
-
-  VkDeviceSize aligned_pos = tools::align_up(offset, alignment);
-
-  if (aligned_pos_output) {
-    *aligned_pos_output = aligned_pos;
-  }
-
-  if (aligned_size) {
-    *aligned_size = size - aligned_pos + offset;
-  }
+VkDeviceSize DeviceMemory::GetBlockOffset(uint32_t block_index) {
+  return allocator.GetBlock(block_index).offset;
 }
 
 } // namespace vk
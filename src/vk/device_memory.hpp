@@ -2,7 +2,9 @@
 #include "buffer.hpp"
 #include "device.hpp"
 #include "image.hpp"
+#include "tlsf_allocator.hpp"
 #include <limits>
+#include <unordered_map>
 
 using namespace std;
 
@@ -10,42 +12,43 @@ namespace vk {
 
 class DeviceMemory {
 private:
-  struct MemorySegment {
-    bool empty;
-    VkDeviceSize offset;
-    VkDeviceSize buffer_offset;
-    VkDeviceSize size;
-    MemoryObject *memory_object;
-
-    bool IsSuitable(VkMemoryRequirements requirements,
-                    VkDeviceSize &empty_space);
-    void GetAlignedSegment(VkDeviceSize alignment, VkDeviceSize *aligned_pos,
-                           VkDeviceSize *aligned_size);
-  };
-
   VkDevice device;
   VkDeviceMemory handle;
   VkDeviceSize size;
+  uint32_t type;
   VkDeviceSize non_coherent_atom_size;
-  vector<MemorySegment> memory_segments;
 
-  MemorySegment mapped_segment;
+  bool host_visible;
+  bool host_coherent;
+  bool dedicated;
+  void *mapped_data;
+
+  TlsfAllocator allocator;
+  unordered_map<MemoryObject *, uint32_t> occupied_blocks;
 
-  void FreeBuffer(Buffer *buffer);
-  uint32_t FindSegment(MemoryObject *memory_object);
-  void FreeSegment(uint32_t segment_index);
-  void MergeSegment(uint32_t segment1_index, uint32_t segment2_index);
+  uint32_t FindBlock(MemoryObject *memory_object);
+  void FreeBlock(MemoryObject *memory_object);
 
-  void OccupieSegment(uint32_t segment_index, VkDeviceSize size,
-                      VkDeviceSize buffer_offset, MemoryObject *buffer);
-  uint32_t FindSuitableSegment(VkMemoryRequirements requirements);
-  void *MapMemory(MemoryObject *memory_object);
-  void Flush();
+  uint32_t OccupieBlock(VkMemoryRequirements requirements, bool linear,
+                        MemoryObject *memory_object);
+  uint32_t AllocateBlock(VkMemoryRequirements requirements, bool linear);
+  void ReleaseBlock(uint32_t block_index);
+  void AttachBlock(MemoryObject *memory_object, uint32_t block_index);
+  uint32_t DetachBlock(MemoryObject *memory_object);
+  VkDeviceSize GetBlockOffset(uint32_t block_index);
+  void BindImage(Image &image, uint32_t block_index);
+  void BindBuffer(Buffer &buffer, uint32_t block_index);
+  void Map();
   void Unmap();
-  MemorySegment CreateAlignedMemorySegment(MemorySegment &buffer_segment);
+  void *GetMappedData(MemoryObject *memory_object);
+  VkMappedMemoryRange CreateMappedRange(MemoryObject *memory_object,
+                                        VkDeviceSize offset,
+                                        VkDeviceSize range_size);
+  void Flush(VkMappedMemoryRange &mapped_range);
 
 public:
-  DeviceMemory(Device &device, VkDeviceSize size, uint32_t type);
+  DeviceMemory(Device &device, VkDeviceSize size, uint32_t type,
+               VkMemoryDedicatedAllocateInfo *dedicated_info = nullptr);
   DeviceMemory(DeviceMemory &) = delete;
   DeviceMemory &operator=(DeviceMemory &) = delete;
   ~DeviceMemory();
@@ -54,9 +57,23 @@ public:
   void PrintSegments();
   void BindBuffer(Buffer &buffer);
   void BindImage(Image &buffer);
+  bool TryBindBuffer(Buffer &buffer);
+  bool TryBindImage(Image &image);
   void Free();
 
+  VkDeviceMemory GetHandle();
+  uint32_t GetType();
+  bool IsEmpty();
+  bool IsDedicated();
+  bool IsHostVisible();
+  bool IsHostCoherent();
+  VkDeviceSize GetSize();
+  VkDeviceSize GetFreeSize();
+  VkDeviceSize GetLargestFreeSize();
+
   friend Buffer;
+  friend class MemoryManager;
+  friend class Defragmenter;
 };
 
 } // namespace vk
@@ -20,6 +20,15 @@ public:
   MemoryTypeNotFoundException() : ::IException(){};
 };
 
+class OutOfMemoryBudgetException : public IException {
+private:
+protected:
+  string Message() { return "allocation does not fit memory budget"; };
+
+public:
+  OutOfMemoryBudgetException() : ::IException(){};
+};
+
 class AcquireNextImageFailedException : public IException {
 private:
 protected:
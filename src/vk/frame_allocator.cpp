@@ -0,0 +1,124 @@
+#include "frame_allocator.hpp"
+#include "memory_manager.hpp"
+
+namespace vk {
+
+FrameAllocator::FrameAllocator(Device &device,
+                               FrameAllocatorCreateInfo &create_info) {
+  this->device = &device;
+  timeline = &device.GetTimeline(create_info.queue);
+  current_frame = 0;
+
+  CalculateAlignments(create_info.usage);
+  CreateBuffer(create_info);
+
+  VkDeviceSize frame_size =
+      tools::align_up(create_info.frame_size, partition_alignment);
+
+  partitions.resize(create_info.frames_in_flight);
+  for (uint32_t i = 0; i < partitions.size(); i++) {
+    FramePartition &partition = partitions[i];
+    partition.begin = frame_size * i;
+    partition.end = partition.begin + frame_size;
+    partition.head = partition.begin;
+    partition.timeline_value = 0;
+  }
+
+  TRACE("frame allocator with {0} partitions of {1} bytes created",
+        partitions.size(), frame_size);
+}
+
+FrameAllocator::~FrameAllocator() {
+  if (buffer) {
+    Destroy();
+  }
+}
+
+void FrameAllocator::Destroy() {
+  buffer->Destroy();
+  buffer.reset();
+
+  TRACE("frame allocator destroyed");
+}
+
+void FrameAllocator::CalculateAlignments(VkBufferUsageFlags usage) {
+  VkPhysicalDeviceLimits limits = device->GetPhysicalDevice().GetLimits();
+
+  binding_alignment = 16;
+
+  if (usage & VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT) {
+    binding_alignment =
+        max(binding_alignment, limits.minUniformBufferOffsetAlignment);
+  }
+
+  if (usage & VK_BUFFER_USAGE_STORAGE_BUFFER_BIT) {
+    binding_alignment =
+        max(binding_alignment, limits.minStorageBufferOffsetAlignment);
+  }
+
+  // partitions are flushed separately on non coherent memory, ranges inside
+  // them are aligned to atoms by flush itself
+  partition_alignment = max<VkDeviceSize>(16, limits.nonCoherentAtomSize);
+}
+
+void FrameAllocator::CreateBuffer(FrameAllocatorCreateInfo &create_info) {
+  VkDeviceSize frame_size =
+      tools::align_up(create_info.frame_size, partition_alignment);
+
+  BufferCreateInfo buffer_create_info;
+  buffer_create_info.queue = create_info.queue;
+  buffer_create_info.size = frame_size * create_info.frames_in_flight;
+  buffer_create_info.usage = create_info.usage;
+  buffer_create_info.memory_usage = MemoryUsage::dynamic_per_frame;
+  buffer_create_info.memory_category = MemoryCategory::uniforms;
+
+  buffer = make_unique<Buffer>(*device, buffer_create_info);
+  mapped_data = (char *)buffer->Map();
+}
+
+void FrameAllocator::BeginFrame(uint32_t frame_index) {
+  current_frame = frame_index;
+  FramePartition &partition = partitions[current_frame];
+
+  // usually frame loop already waited for this value, so it does not block
+  timeline->Wait(partition.timeline_value);
+
+  partition.head = partition.begin;
+}
+
+void FrameAllocator::EndFrame(uint64_t timeline_value) {
+  FramePartition &partition = partitions[current_frame];
+  partition.timeline_value = timeline_value;
+
+  if (partition.head == partition.begin) {
+    return;
+  }
+
+  buffer->QueueFlush(partition.begin, partition.head - partition.begin);
+  device->GetMemoryManager().FlushQueuedRanges();
+}
+
+FrameAllocation FrameAllocator::Allocate(VkDeviceSize size,
+                                         VkDeviceSize alignment) {
+  FramePartition &partition = partitions[current_frame];
+
+  VkDeviceSize offset = tools::align_up(partition.head, alignment);
+  if (offset + size > partition.end) {
+    throw CriticalException("frame allocator partition is full");
+  }
+
+  partition.head = offset + size;
+
+  FrameAllocation allocation;
+  allocation.buffer = buffer->GetHandle();
+  allocation.offset = offset;
+  allocation.data = mapped_data + offset;
+
+  return allocation;
+}
+
+FrameAllocation FrameAllocator::AllocateBinding(VkDeviceSize size) {
+  return Allocate(size, binding_alignment);
+}
+
+} // namespace vk
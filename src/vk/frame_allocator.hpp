@@ -0,0 +1,88 @@
+#pragma once
+#include "buffer.hpp"
+#include "device.hpp"
+#include "queue.hpp"
+#include <memory>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+using namespace std;
+
+namespace vk {
+
+struct FrameAllocatorCreateInfo {
+  uint32_t frames_in_flight;
+  VkDeviceSize frame_size;
+  VkBufferUsageFlags usage;
+  // frames are submitted to this queue, partitions are recycled by its
+  // timeline
+  Queue queue;
+};
+
+struct FrameAllocation {
+  VkBuffer buffer;
+  VkDeviceSize offset;
+  void *data;
+};
+
+// bump allocator over one persistently mapped buffer, split in a partition
+// per frame in flight, partition is reused after its frame timeline value
+// is reached
+class FrameAllocator {
+private:
+  struct FramePartition {
+    VkDeviceSize begin;
+    VkDeviceSize end;
+    VkDeviceSize head;
+    uint64_t timeline_value;
+  };
+
+  Device *device;
+  GpuTimeline *timeline;
+  unique_ptr<Buffer> buffer;
+  char *mapped_data;
+
+  // partition start, so partitions are flushed without overlapping atoms
+  VkDeviceSize partition_alignment;
+  // offsets bound as uniform or storage buffer descriptors
+  VkDeviceSize binding_alignment;
+
+  vector<FramePartition> partitions;
+  uint32_t current_frame;
+
+  void CalculateAlignments(VkBufferUsageFlags usage);
+  void CreateBuffer(FrameAllocatorCreateInfo &create_info);
+
+public:
+  FrameAllocator(Device &device, FrameAllocatorCreateInfo &create_info);
+  FrameAllocator(FrameAllocator &) = delete;
+  FrameAllocator &operator=(FrameAllocator &) = delete;
+  ~FrameAllocator();
+
+  void Destroy();
+
+  void BeginFrame(uint32_t frame_index);
+  // timeline_value is value signaled by submit of the frame
+  void EndFrame(uint64_t timeline_value);
+
+  // packed tightly, like per agent vertex or instance data
+  FrameAllocation Allocate(VkDeviceSize size, VkDeviceSize alignment = 1);
+  // offset can be bound as uniform or storage buffer descriptor
+  FrameAllocation AllocateBinding(VkDeviceSize size);
+
+  template <typename T> FrameAllocation Push(const T &data) {
+    FrameAllocation allocation = Allocate(sizeof(T), alignof(T));
+    *(T *)allocation.data = data;
+
+    return allocation;
+  }
+
+  template <typename T> FrameAllocation PushBinding(const T &data) {
+    FrameAllocation allocation = AllocateBinding(sizeof(T));
+    *(T *)allocation.data = data;
+
+    return allocation;
+  }
+};
+
+} // namespace vk
@@ -0,0 +1,155 @@
+#include "gpu_timeline.hpp"
+#include "device.hpp"
+
+namespace vk {
+
+GpuTimeline::GpuTimeline(Device &device, Queue queue) {
+  this->device = &device;
+  this->queue = queue;
+  submitted_value = 0;
+  completed_value = 0;
+
+  VkSemaphoreTypeCreateInfo type_create_info =
+      semaphore_type_create_info_template;
+
+  VkSemaphoreCreateInfo create_info = semaphore_create_info_template;
+  create_info.pNext = &type_create_info;
+
+  VkResult result =
+      vkCreateSemaphore(device.GetHandle(), &create_info, nullptr, &handle);
+  if (result) {
+    throw CriticalException("cant create timeline semaphore");
+  }
+
+  TRACE("timeline of queue family {0} created", queue.GetFamily());
+}
+
+GpuTimeline::~GpuTimeline() {
+  if (handle == VK_NULL_HANDLE) {
+    return;
+  }
+
+  Destroy();
+}
+
+void GpuTimeline::Destroy() {
+  vkDestroySemaphore(device->GetHandle(), handle, nullptr);
+  handle = VK_NULL_HANDLE;
+
+  TRACE("timeline destroyed");
+}
+
+uint64_t GpuTimeline::Submit(TimelineSubmitInfo &submit_info) {
+  vector<VkSemaphore> wait_semaphores = submit_info.binary_waits;
+  vector<VkPipelineStageFlags> wait_stages = submit_info.binary_wait_stages;
+  // values of binary semaphores are ignored
+  vector<uint64_t> wait_values(wait_semaphores.size(), 0);
+
+  for (TimelineWait &wait : submit_info.waits) {
+    if (wait.value == 0) {
+      continue;
+    }
+
+    wait_semaphores.push_back(wait.timeline->GetHandle());
+    wait_stages.push_back(wait.stage);
+    wait_values.push_back(wait.value);
+  }
+
+  uint64_t value = submitted_value + 1;
+
+  vector<VkSemaphore> signal_semaphores = submit_info.binary_signals;
+  vector<uint64_t> signal_values(signal_semaphores.size(), 0);
+  signal_semaphores.push_back(handle);
+  signal_values.push_back(value);
+
+  VkTimelineSemaphoreSubmitInfo timeline_submit_info =
+      timeline_semaphore_submit_info_template;
+  timeline_submit_info.waitSemaphoreValueCount = wait_values.size();
+  timeline_submit_info.pWaitSemaphoreValues = wait_values.data();
+  timeline_submit_info.signalSemaphoreValueCount = signal_values.size();
+  timeline_submit_info.pSignalSemaphoreValues = signal_values.data();
+
+  VkSubmitInfo vk_submit_info = submit_info_template;
+  vk_submit_info.pNext = &timeline_submit_info;
+  vk_submit_info.waitSemaphoreCount = wait_semaphores.size();
+  vk_submit_info.pWaitSemaphores = wait_semaphores.data();
+  vk_submit_info.pWaitDstStageMask = wait_stages.data();
+  vk_submit_info.commandBufferCount = submit_info.command_buffers.size();
+  vk_submit_info.pCommandBuffers = submit_info.command_buffers.data();
+  vk_submit_info.signalSemaphoreCount = signal_semaphores.size();
+  vk_submit_info.pSignalSemaphores = signal_semaphores.data();
+
+  VkResult result =
+      vkQueueSubmit(queue.GetHandle(), 1, &vk_submit_info, VK_NULL_HANDLE);
+  if (result) {
+    throw CriticalException("cant submit to queue");
+  }
+
+  submitted_value = value;
+
+  return value;
+}
+
+uint64_t GpuTimeline::Submit(VkCommandBuffer command_buffer) {
+  TimelineSubmitInfo submit_info;
+  submit_info.command_buffers.push_back(command_buffer);
+
+  return Submit(submit_info);
+}
+
+uint64_t GpuTimeline::Poll() {
+  uint64_t value;
+  VkResult result =
+      vkGetSemaphoreCounterValue(device->GetHandle(), handle, &value);
+  if (result) {
+    throw CriticalException("cant get timeline value");
+  }
+
+  completed_value = max(completed_value, value);
+
+  return completed_value;
+}
+
+bool GpuTimeline::IsComplete(uint64_t value) {
+  // cached value saves a driver call for already retired work
+  if (value <= completed_value) {
+    return true;
+  }
+
+  return Poll() >= value;
+}
+
+void GpuTimeline::Wait(uint64_t value) {
+  if (value <= completed_value) {
+    return;
+  }
+
+  if (value > submitted_value) {
+    throw CriticalException("timeline value " + to_string(value) +
+                            " is not submitted");
+  }
+
+  VkSemaphoreWaitInfo wait_info = semaphore_wait_info_template;
+  wait_info.semaphoreCount = 1;
+  wait_info.pSemaphores = &handle;
+  wait_info.pValues = &value;
+
+  VkResult result = vkWaitSemaphores(device->GetHandle(), &wait_info, UINT64_MAX);
+  if (result) {
+    throw CriticalException("cant wait for timeline");
+  }
+
+  completed_value = value;
+}
+
+void GpuTimeline::WaitIdle() { Wait(submitted_value); }
+
+uint64_t GpuTimeline::GetNextValue() { return submitted_value + 1; }
+
+uint64_t GpuTimeline::GetSubmittedValue() { return submitted_value; }
+
+VkSemaphore GpuTimeline::GetHandle() { return handle; }
+
+Queue GpuTimeline::GetQueue() { return queue; }
+
+} // namespace vk
@@ -0,0 +1,69 @@
+#pragma once
+#include "exception.hpp"
+#include "queue.hpp"
+#include "templates.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+using namespace std;
+
+namespace vk {
+
+class Device;
+class GpuTimeline;
+
+// gpu waits at stage until timeline reaches value, value 0 is never waited
+struct TimelineWait {
+  GpuTimeline *timeline;
+  uint64_t value;
+  VkPipelineStageFlags stage;
+};
+
+struct TimelineSubmitInfo {
+  vector<VkCommandBuffer> command_buffers;
+  // waits on other queues timelines, chains work without host round trip
+  vector<TimelineWait> waits;
+  // swapchain works only with binary semaphores
+  vector<VkSemaphore> binary_waits;
+  vector<VkPipelineStageFlags> binary_wait_stages;
+  vector<VkSemaphore> binary_signals;
+};
+
+// timeline semaphore of one queue, every submit signals next value, so work
+// is finished when counter reached value returned by its Submit
+class GpuTimeline {
+private:
+  Device *device;
+  Queue queue;
+  VkSemaphore handle;
+
+  uint64_t submitted_value;
+  uint64_t completed_value;
+
+public:
+  GpuTimeline(Device &device, Queue queue);
+  GpuTimeline(GpuTimeline &) = delete;
+  GpuTimeline &operator=(GpuTimeline &) = delete;
+  ~GpuTimeline();
+
+  void Destroy();
+
+  uint64_t Submit(TimelineSubmitInfo &submit_info);
+  uint64_t Submit(VkCommandBuffer command_buffer);
+
+  // reads counter from gpu, returns last completed value
+  uint64_t Poll();
+  bool IsComplete(uint64_t value);
+  void Wait(uint64_t value);
+  void WaitIdle();
+
+  // value which will be signaled by next submit
+  uint64_t GetNextValue();
+  uint64_t GetSubmittedValue();
+  VkSemaphore GetHandle();
+  Queue GetQueue();
+};
+
+} // namespace vk
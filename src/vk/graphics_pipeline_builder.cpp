@@ -0,0 +1,311 @@
+#include "graphics_pipeline_builder.hpp"
+
+namespace vk {
+
+template <typename T> static void AppendKey(string &key, const T &value) {
+  key.append((const char *)&value, sizeof(T));
+}
+
+GraphicsPipelineBuilder::GraphicsPipelineBuilder() {
+  topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+  polygon_mode = VK_POLYGON_MODE_FILL;
+  cull_mode = VK_CULL_MODE_NONE;
+  front_face = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+  dynamic_states = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+  layout = VK_NULL_HANDLE;
+  render_pass = VK_NULL_HANDLE;
+  subpass = 0;
+}
+
+GraphicsPipelineBuilder &
+GraphicsPipelineBuilder::AddShader(VkShaderStageFlagBits stage,
+                                   ShaderModule &module, string entry) {
+  stages.push_back(
+      {stage, module.GetHandle(), {}, module.GetCode(), entry});
+  return *this;
+}
+
+GraphicsPipelineBuilder &
+GraphicsPipelineBuilder::AddShader(VkShaderStageFlagBits stage,
+                                   fs::path filepath, string entry) {
+  stages.push_back({stage, VK_NULL_HANDLE, filepath, {}, entry});
+  return *this;
+}
+
+GraphicsPipelineBuilder &GraphicsPipelineBuilder::SetSpecialization(
+    VkShaderStageFlagBits stage, SpecializationConstants &specialization) {
+  bool found = false;
+  for (ShaderStage &shader_stage : stages) {
+    if (shader_stage.stage == stage) {
+      shader_stage.specialization = specialization;
+      found = true;
+    }
+  }
+
+  if (!found) {
+    throw CriticalException("specialized shader stage is not added");
+  }
+
+  return *this;
+}
+
+GraphicsPipelineBuilder &
+GraphicsPipelineBuilder::AddVertexBinding(uint32_t binding, uint32_t stride,
+                                          VkVertexInputRate input_rate) {
+  bindings.push_back({binding, stride, input_rate});
+  return *this;
+}
+
+GraphicsPipelineBuilder &
+GraphicsPipelineBuilder::AddVertexAttribute(uint32_t location,
+                                            uint32_t binding, VkFormat format,
+                                            uint32_t offset) {
+  attributes.push_back({location, binding, format, offset});
+  return *this;
+}
+
+GraphicsPipelineBuilder &
+GraphicsPipelineBuilder::SetTopology(VkPrimitiveTopology topology) {
+  this->topology = topology;
+  return *this;
+}
+
+GraphicsPipelineBuilder &
+GraphicsPipelineBuilder::SetPolygonMode(VkPolygonMode polygon_mode) {
+  this->polygon_mode = polygon_mode;
+  return *this;
+}
+
+GraphicsPipelineBuilder &
+GraphicsPipelineBuilder::SetCullMode(VkCullModeFlags cull_mode,
+                                     VkFrontFace front_face) {
+  this->cull_mode = cull_mode;
+  this->front_face = front_face;
+  return *this;
+}
+
+GraphicsPipelineBuilder &GraphicsPipelineBuilder::AddColorAttachment(bool blend) {
+  VkPipelineColorBlendAttachmentState attachment;
+  attachment.colorWriteMask =
+      VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
+      VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+  attachment.blendEnable = blend;
+
+  // straight alpha when blending, color is scaled by source alpha here,
+  // plain overwrite otherwise
+  attachment.srcColorBlendFactor =
+      blend ? VK_BLEND_FACTOR_SRC_ALPHA : VK_BLEND_FACTOR_ONE;
+  attachment.dstColorBlendFactor =
+      blend ? VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA : VK_BLEND_FACTOR_ZERO;
+  attachment.colorBlendOp = VK_BLEND_OP_ADD;
+  attachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+  attachment.dstAlphaBlendFactor =
+      blend ? VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA : VK_BLEND_FACTOR_ZERO;
+  attachment.alphaBlendOp = VK_BLEND_OP_ADD;
+
+  blend_attachments.push_back(attachment);
+  return *this;
+}
+
+GraphicsPipelineBuilder &
+GraphicsPipelineBuilder::AddDynamicState(VkDynamicState state) {
+  dynamic_states.push_back(state);
+  return *this;
+}
+
+GraphicsPipelineBuilder &
+GraphicsPipelineBuilder::SetLayout(VkPipelineLayout layout) {
+  this->layout = layout;
+  return *this;
+}
+
+GraphicsPipelineBuilder &
+GraphicsPipelineBuilder::SetRenderPass(VkRenderPass render_pass,
+                                       uint32_t subpass) {
+  this->render_pass = render_pass;
+  this->subpass = subpass;
+  return *this;
+}
+
+void GraphicsPipelineBuilder::LoadShaders() {
+  for (ShaderStage &stage : stages) {
+    if (stage.module != VK_NULL_HANDLE || !stage.code.empty()) {
+      continue;
+    }
+
+    stage.code = ShaderModule::ReadFile(stage.filepath);
+  }
+}
+
+bool GraphicsPipelineBuilder::UnloadShader(const fs::path &filepath) {
+  bool used = false;
+
+  for (ShaderStage &stage : stages) {
+    if (stage.module != VK_NULL_HANDLE ||
+        fs::weakly_canonical(stage.filepath) != fs::weakly_canonical(filepath)) {
+      continue;
+    }
+
+    stage.code.clear();
+    used = true;
+  }
+
+  return used;
+}
+
+string GraphicsPipelineBuilder::GetKey() {
+  // key of file shaders is known only after reading them
+  LoadShaders();
+
+  // compute pipelines share the cache
+  string key = "graphics";
+
+  // counts keep keys of different lists from matching each other
+  AppendKey(key, stages.size());
+  for (ShaderStage &stage : stages) {
+    AppendKey(key, stage.stage);
+    // whole code, so different shaders of equal hash never share pipeline
+    AppendKey(key, stage.code.size());
+    key.append(stage.code.data(), stage.code.size());
+    key.append(stage.entry);
+    key.push_back('\0');
+    stage.specialization.AppendKey(key);
+  }
+
+  AppendKey(key, bindings.size());
+  for (VkVertexInputBindingDescription &binding : bindings) {
+    AppendKey(key, binding);
+  }
+
+  AppendKey(key, attributes.size());
+  for (VkVertexInputAttributeDescription &attribute : attributes) {
+    AppendKey(key, attribute);
+  }
+
+  AppendKey(key, topology);
+  AppendKey(key, polygon_mode);
+  AppendKey(key, cull_mode);
+  AppendKey(key, front_face);
+
+  AppendKey(key, blend_attachments.size());
+  for (VkPipelineColorBlendAttachmentState &attachment : blend_attachments) {
+    AppendKey(key, attachment);
+  }
+
+  AppendKey(key, dynamic_states.size());
+  for (VkDynamicState state : dynamic_states) {
+    AppendKey(key, state);
+  }
+
+  AppendKey(key, layout);
+  AppendKey(key, render_pass);
+  AppendKey(key, subpass);
+
+  return key;
+}
+
+size_t GraphicsPipelineBuilder::Hash() { return hash<string>()(GetKey()); }
+
+VkPipeline GraphicsPipelineBuilder::Build(Device &device) {
+  if (layout == VK_NULL_HANDLE || render_pass == VK_NULL_HANDLE) {
+    throw CriticalException("graphics pipeline has no layout or render pass");
+  }
+
+  return device.GetPipelineCache().GetPipeline(
+      GetKey(), [&]() { return Create(device); });
+}
+
+VkPipeline GraphicsPipelineBuilder::Create(Device &device) {
+  vector<VkPipelineShaderStageCreateInfo> stage_create_infos;
+  // modules made from loaded code are destroyed after creation
+  vector<VkShaderModule> created_modules;
+  for (ShaderStage &stage : stages) {
+    VkShaderModule module = stage.module;
+    if (module == VK_NULL_HANDLE) {
+      module = device.GetPipelineCache().CreateShaderModule(stage.code);
+      created_modules.push_back(module);
+    }
+
+    VkPipelineShaderStageCreateInfo stage_create_info =
+        pipeline_shader_stage_create_info_template;
+    stage_create_info.stage = stage.stage;
+    stage_create_info.module = module;
+    stage_create_info.pName = stage.entry.c_str();
+    stage_create_info.pSpecializationInfo = stage.specialization.GetInfo();
+
+    stage_create_infos.push_back(stage_create_info);
+  }
+
+  VkPipelineVertexInputStateCreateInfo vertex_input =
+      vertex_input_create_info_template;
+  vertex_input.vertexBindingDescriptionCount = bindings.size();
+  vertex_input.pVertexBindingDescriptions = bindings.data();
+  vertex_input.vertexAttributeDescriptionCount = attributes.size();
+  vertex_input.pVertexAttributeDescriptions = attributes.data();
+
+  VkPipelineInputAssemblyStateCreateInfo input_assembly =
+      pipeline_input_assembly_create_info_template;
+  input_assembly.topology = topology;
+
+  // counts only, viewport and scissor are set in command buffers
+  VkPipelineViewportStateCreateInfo viewport_state =
+      pipeline_viewport_state_create_info_template;
+  viewport_state.pViewports = nullptr;
+  viewport_state.pScissors = nullptr;
+
+  VkPipelineRasterizationStateCreateInfo rasterization_state =
+      pipeline_rasterization_state_create_info_template;
+  rasterization_state.depthClampEnable = VK_FALSE;
+  rasterization_state.polygonMode = polygon_mode;
+  rasterization_state.cullMode = cull_mode;
+  rasterization_state.frontFace = front_face;
+
+  VkPipelineMultisampleStateCreateInfo multisample_state =
+      pipeline_multisample_state_create_info_template;
+
+  VkPipelineColorBlendStateCreateInfo color_blend_state =
+      pipeline_color_blend_state_create_info_template;
+  color_blend_state.attachmentCount = blend_attachments.size();
+  color_blend_state.pAttachments = blend_attachments.data();
+
+  VkPipelineDynamicStateCreateInfo dynamic_state =
+      pipeline_dynamic_state_create_info_template;
+  dynamic_state.dynamicStateCount = dynamic_states.size();
+  dynamic_state.pDynamicStates = dynamic_states.data();
+
+  VkGraphicsPipelineCreateInfo create_info =
+      graphics_pipeline_create_info_template;
+  create_info.stageCount = stage_create_infos.size();
+  create_info.pStages = stage_create_infos.data();
+  create_info.pVertexInputState = &vertex_input;
+  create_info.pInputAssemblyState = &input_assembly;
+  create_info.pTessellationState = nullptr;
+  create_info.pViewportState = &viewport_state;
+  create_info.pRasterizationState = &rasterization_state;
+  create_info.pMultisampleState = &multisample_state;
+  create_info.pDepthStencilState = nullptr;
+  create_info.pColorBlendState = &color_blend_state;
+  create_info.pDynamicState = &dynamic_state;
+  create_info.layout = layout;
+  create_info.renderPass = render_pass;
+  create_info.subpass = subpass;
+  create_info.basePipelineHandle = VK_NULL_HANDLE;
+  create_info.basePipelineIndex = -1;
+
+  VkPipeline pipeline;
+  VkResult result = vkCreateGraphicsPipelines(
+      device.GetHandle(), device.GetPipelineCache().GetHandle(), 1,
+      &create_info, nullptr, &pipeline);
+
+  for (VkShaderModule module : created_modules) {
+    vkDestroyShaderModule(device.GetHandle(), module, nullptr);
+  }
+
+  if (result) {
+    throw CriticalException("cant create graphics pipeline");
+  }
+
+  return pipeline;
+}
+
+} // namespace vk
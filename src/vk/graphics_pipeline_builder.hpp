@@ -0,0 +1,95 @@
+#pragma once
+#include "device.hpp"
+#include "shader_module.hpp"
+#include "specialization_constants.hpp"
+#include "templates.hpp"
+#include <memory>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+using namespace std;
+
+namespace vk {
+
+// describes graphics pipeline starting from templates, viewport and scissor
+// are dynamic so pipeline does not depend on surface size, identical
+// descriptions share one pipeline owned by device pipeline cache
+class GraphicsPipelineBuilder {
+private:
+  struct ShaderStage {
+    VkShaderStageFlagBits stage;
+    // null when module is made from code while pipeline is created
+    VkShaderModule module;
+    fs::path filepath;
+    vector<char> code;
+    string entry;
+    SpecializationConstants specialization;
+  };
+
+  vector<ShaderStage> stages;
+  vector<VkVertexInputBindingDescription> bindings;
+  vector<VkVertexInputAttributeDescription> attributes;
+  VkPrimitiveTopology topology;
+  VkPolygonMode polygon_mode;
+  VkCullModeFlags cull_mode;
+  VkFrontFace front_face;
+  vector<VkPipelineColorBlendAttachmentState> blend_attachments;
+  vector<VkDynamicState> dynamic_states;
+  VkPipelineLayout layout;
+  VkRenderPass render_pass;
+  uint32_t subpass;
+
+  void LoadShaders();
+  VkPipeline Create(Device &device);
+
+public:
+  GraphicsPipelineBuilder();
+
+  GraphicsPipelineBuilder &AddShader(VkShaderStageFlagBits stage,
+                                     ShaderModule &module,
+                                     string entry = "main");
+  // file is read only when pipeline is compiled, so whole description can
+  // be built on another thread, pipelines of same code are compiled once
+  GraphicsPipelineBuilder &AddShader(VkShaderStageFlagBits stage,
+                                     fs::path filepath,
+                                     string entry = "main");
+  // constants of every added shader of the stage, values are part of the
+  // description, so each set of them is separate pipeline
+  GraphicsPipelineBuilder &
+  SetSpecialization(VkShaderStageFlagBits stage,
+                    SpecializationConstants &specialization);
+  GraphicsPipelineBuilder &AddVertexBinding(uint32_t binding, uint32_t stride,
+                                            VkVertexInputRate input_rate =
+                                                VK_VERTEX_INPUT_RATE_VERTEX);
+  GraphicsPipelineBuilder &AddVertexAttribute(uint32_t location,
+                                              uint32_t binding,
+                                              VkFormat format,
+                                              uint32_t offset);
+  GraphicsPipelineBuilder &SetTopology(VkPrimitiveTopology topology);
+  GraphicsPipelineBuilder &SetPolygonMode(VkPolygonMode polygon_mode);
+  GraphicsPipelineBuilder &SetCullMode(VkCullModeFlags cull_mode,
+                                       VkFrontFace front_face =
+                                           VK_FRONT_FACE_COUNTER_CLOCKWISE);
+  // one per color attachment of subpass, without blending by default
+  GraphicsPipelineBuilder &AddColorAttachment(bool blend = false);
+  GraphicsPipelineBuilder &AddDynamicState(VkDynamicState state);
+  GraphicsPipelineBuilder &SetLayout(VkPipelineLayout layout);
+  GraphicsPipelineBuilder &SetRenderPass(VkRenderPass render_pass,
+                                         uint32_t subpass = 0);
+
+  // shader file is read again by next Build, returns false when description
+  // does not use it
+  bool UnloadShader(const fs::path &filepath);
+
+  // whole state in bytes, shaders by their code since handles are reused,
+  // layout and render pass by handle, so they must outlive the cache
+  string GetKey();
+  size_t Hash();
+
+  // returns cached pipeline of identical description or creates one, can
+  // be called from several threads for different builders
+  VkPipeline Build(Device &device);
+};
+
+} // namespace vk
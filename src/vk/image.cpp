@@ -1,35 +1,81 @@
 #include "image.hpp"
-#include "device_memory.hpp"
+#include "memory_manager.hpp"
+#include <algorithm>
+#include <bit>
 
 namespace vk {
 
 Image::Image(Device *device, ImageCreateInfo &create_info) {
   this->device = device;
+  memory = nullptr;
   format = create_info.format;
   current_layout = create_info.layout;
+  movable = create_info.movable;
+  category = create_info.memory_category;
 
   extent.width = create_info.size.x;
   extent.height = create_info.size.y;
   extent.depth = 1;
 
+  mip_levels = create_info.mip_levels;
+  if (mip_levels == full_mip_chain) {
+    mip_levels = CalculateMipLevels(create_info.size);
+  }
+
+  usage = create_info.usage;
+
+  // defragmenter moves content with transfer commands and mips are blitted
+  // from previous level
+  if (movable || mip_levels > 1) {
+    usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+  }
+
+  CreateHandle(current_layout);
+  QueryMemoryRequirements();
+
+  if (create_info.bind_memory) {
+    device->GetMemoryManager().BindImage(*this, create_info.memory_usage);
+  }
+
+  TRACE("image created");
+}
+
+void Image::CreateHandle(VkImageLayout initial_layout) {
   VkImageCreateInfo vk_create_info = image_create_info_template;
   vk_create_info.imageType = VK_IMAGE_TYPE_2D;
   vk_create_info.extent = extent;
+  vk_create_info.mipLevels = mip_levels;
   vk_create_info.format = format;
   vk_create_info.tiling = VK_IMAGE_TILING_OPTIMAL;
-  vk_create_info.initialLayout = current_layout;
-  vk_create_info.usage =
-      VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+  vk_create_info.initialLayout = initial_layout;
+  vk_create_info.usage = usage;
 
   VkResult result =
       vkCreateImage(device->GetHandle(), &vk_create_info, nullptr, &handle);
   if (result) {
     throw CriticalException("cant create image");
   }
+}
 
-  vkGetImageMemoryRequirements(device->GetHandle(), handle, &requirements);
+void Image::QueryMemoryRequirements() {
+  VkImageMemoryRequirementsInfo2 requirements_info{};
+  requirements_info.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_REQUIREMENTS_INFO_2;
+  requirements_info.image = handle;
 
-  TRACE("image created");
+  VkMemoryDedicatedRequirements dedicated_requirements{};
+  dedicated_requirements.sType =
+      VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS;
+
+  VkMemoryRequirements2 requirements2{};
+  requirements2.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+  requirements2.pNext = &dedicated_requirements;
+
+  vkGetImageMemoryRequirements2(device->GetHandle(), &requirements_info,
+                                &requirements2);
+
+  requirements = requirements2.memoryRequirements;
+  prefers_dedicated = dedicated_requirements.prefersDedicatedAllocation ||
+                      dedicated_requirements.requiresDedicatedAllocation;
 }
 
 Image::~Image() {
@@ -51,7 +97,25 @@ VkExtent3D Image::GetExtent() { return extent; }
 
 VkFormat Image::GetFormat() { return format; }
 
+uint32_t Image::GetMipLevels() { return mip_levels; }
+
+VkImageSubresourceRange Image::GetSubresourceRange() {
+  VkImageSubresourceRange subresource_range = image_subresource_range_template;
+  subresource_range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  subresource_range.levelCount = mip_levels;
+
+  return subresource_range;
+}
+
+uint32_t Image::CalculateMipLevels(glm::ivec2 size) {
+  return bit_width((uint32_t)max(max(size.x, size.y), 1));
+}
+
 void Image::Destroy() {
+  if (memory) {
+    device->GetMemoryManager().FreeImage(*this);
+  }
+
   vkDestroyImage(device->GetHandle(), handle, nullptr);
 
   handle = VK_NULL_HANDLE;
@@ -14,10 +14,22 @@ namespace vk {
 
 class DeviceMemory;
 
+// mip levels value which creates the whole chain down to 1x1
+constexpr uint32_t full_mip_chain = 0;
+
 struct ImageCreateInfo {
   glm::ivec2 size;
   VkFormat format;
   VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+  uint32_t mip_levels = 1;
+  VkImageUsageFlags usage =
+      VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+  MemoryUsage memory_usage = MemoryUsage::gpu_only;
+  MemoryCategory memory_category = MemoryCategory::textures;
+  bool movable = false;
+  // false leaves binding to owner, like render graph which aliases
+  // transient images in one memory
+  bool bind_memory = true;
 };
 
 class Image : public MemoryObject {
@@ -28,7 +40,12 @@ private:
 
   VkExtent3D extent;
   VkFormat format;
+  uint32_t mip_levels;
   VkImageLayout current_layout;
+  VkImageUsageFlags usage;
+
+  void CreateHandle(VkImageLayout initial_layout);
+  void QueryMemoryRequirements();
 
 public:
   Image(Device *device, ImageCreateInfo &create_info);
@@ -44,8 +61,14 @@ public:
 
   VkExtent3D GetExtent();
   VkFormat GetFormat();
+  uint32_t GetMipLevels();
+  VkImageSubresourceRange GetSubresourceRange();
+
+  static uint32_t CalculateMipLevels(glm::ivec2 size);
   
   friend DeviceMemory;
+  friend class MemoryManager;
+  friend class Defragmenter;
 };
 
 } // namespace vk
@@ -4,11 +4,16 @@
 namespace vk {
 
 ImageBarrier::ImageBarrier(Image &image, SrcImageBarrier src,
-                           DstImageBarrier dst) {
+                           DstImageBarrier dst, uint32_t base_mip,
+                           uint32_t mip_count) {
   this->src = src;
   this->dst = dst;
 
   this->image = image.GetHandle();
+
+  subresource_range = image.GetSubresourceRange();
+  subresource_range.baseMipLevel = base_mip;
+  subresource_range.levelCount = mip_count;
 }
 
 void ImageBarrier::Set(CommandBuffer &command_buffer) {
@@ -23,11 +28,7 @@ VkImageMemoryBarrier ImageBarrier::ToNative() {
 
   image_barrier.image = image;
 
-  image_barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-  image_barrier.subresourceRange.baseMipLevel = 0;
-  image_barrier.subresourceRange.levelCount = 1;
-  image_barrier.subresourceRange.baseArrayLayer = 0;
-  image_barrier.subresourceRange.layerCount = 1;
+  image_barrier.subresourceRange = subresource_range;
 
   image_barrier.srcAccessMask = src.access;
   image_barrier.srcQueueFamilyIndex = src.queue_family_index;
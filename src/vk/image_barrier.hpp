@@ -7,6 +7,7 @@ using namespace std;
 
 namespace vk {
 
+class BarrierBatch;
 class Image;
 
 struct SrcImageBarrier {
@@ -29,13 +30,19 @@ private:
   DstImageBarrier dst;
 
   VkImage image;
-
-  VkImageMemoryBarrier ToNative();
+  VkImageSubresourceRange subresource_range;
 
 public:
-  ImageBarrier(Image &image, SrcImageBarrier src, DstImageBarrier dst);
+  // barrier covers mip_count levels from base_mip, by default all of them
+  ImageBarrier(Image &image, SrcImageBarrier src, DstImageBarrier dst,
+               uint32_t base_mip = 0,
+               uint32_t mip_count = VK_REMAINING_MIP_LEVELS);
+
+  VkImageMemoryBarrier ToNative();
 
   void Set(CommandBuffer &command_buffer);
+
+  friend BarrierBatch;
 };
 
 } // namespace vk
@@ -1,12 +1,27 @@
 #include "image_view.hpp"
+#include <algorithm>
 
 namespace vk {
 
-ImageView::ImageView(Device *device, Image *image) {
+ImageView::ImageView(Device *device, Image *image, uint32_t base_mip,
+                     uint32_t mip_count) {
   this->device = device;
+  this->image = image;
+  this->base_mip = base_mip;
 
-  VkImageSubresourceRange subresource_range = image_subresource_range_template;
-  subresource_range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  mip_levels = min(mip_count, image->GetMipLevels() - base_mip);
+
+  CreateHandle();
+
+  TRACE("image view created");
+}
+
+ImageView::~ImageView() { Destroy(); }
+
+void ImageView::CreateHandle() {
+  VkImageSubresourceRange subresource_range = image->GetSubresourceRange();
+  subresource_range.baseMipLevel = base_mip;
+  subresource_range.levelCount = mip_levels;
 
   VkImageViewCreateInfo create_info = image_view_create_info_template;
   create_info.image = image->GetHandle();
@@ -19,12 +34,8 @@ ImageView::ImageView(Device *device, Image *image) {
   if (result) {
     throw CriticalException("cant create image view");
   }
-
-  TRACE("image view created");
 }
 
-ImageView::~ImageView() { Destroy(); }
-
 void ImageView::Destroy() {
   if (handle == VK_NULL_HANDLE) {
     return;
@@ -36,6 +47,17 @@ void ImageView::Destroy() {
   TRACE("image view destroyed");
 }
 
+VkImageView ImageView::Recreate() {
+  VkImageView old_handle = handle;
+  CreateHandle();
+
+  TRACE("image view recreated");
+
+  return old_handle;
+}
+
 VkImageView ImageView::GetHandle() { return handle; }
 
+uint32_t ImageView::GetMipLevels() { return mip_levels; }
+
 } // namespace vk
@@ -8,11 +8,18 @@ namespace vk {
 class ImageView {
 private:
   Device* device;
+  Image *image;
 
   VkImageView handle;
+  uint32_t base_mip;
+  uint32_t mip_levels;
+
+  void CreateHandle();
 
 public:
-  ImageView(Device* device, Image *image);
+  // view covers mip_count levels from base_mip, by default all of them
+  ImageView(Device *device, Image *image, uint32_t base_mip = 0,
+            uint32_t mip_count = VK_REMAINING_MIP_LEVELS);
   ImageView(ImageView &) = delete;
   ImageView &operator=(ImageView &) = delete;
   ~ImageView();
@@ -20,7 +27,12 @@ public:
 
   void Destroy();
 
+  // after image was moved by defragmenter, new view points at its current
+  // handle, old view is returned for caller to destroy once gpu is done
+  VkImageView Recreate();
+
   VkImageView GetHandle();
+  uint32_t GetMipLevels();
 };
 
 } // namespace vk
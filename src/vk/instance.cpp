@@ -24,11 +24,17 @@ void Instance::Dispose() {
 }
 
 void Instance::CreateInstance(InstanceCreateInfo &create_info) {
+  // without application info instance is 1.0, and core 1.1 functions like
+  // vkGetBufferMemoryRequirements2 are not available
+  VkApplicationInfo application_info{};
+  application_info.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+  application_info.apiVersion = create_info.api_version;
+
   VkInstanceCreateInfo vk_create_info;
   vk_create_info.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
   vk_create_info.pNext = nullptr;
   vk_create_info.flags = 0;
-  vk_create_info.pApplicationInfo = 0;
+  vk_create_info.pApplicationInfo = &application_info;
 
   vector<const char *> layers_names_pp =
       tools::string_vector_to_c_array(create_info.layers);
@@ -15,6 +15,8 @@ namespace vk {
 struct InstanceCreateInfo {
   vector<string> layers;
   vector<string> extensions;
+  // 1.2 is needed for timeline semaphores
+  uint32_t api_version = VK_API_VERSION_1_2;
 };
 
 class Instance {
@@ -0,0 +1,131 @@
+#include "job_system.hpp"
+#include "../logs.hpp"
+#include <algorithm>
+
+namespace vk {
+
+JobSystem::JobSystem(JobSystemCreateInfo &create_info) {
+  stopping = false;
+  generation = 0;
+  job_count = 0;
+  next_job = 0;
+  busy_workers = 0;
+
+  uint32_t thread_count = create_info.thread_count;
+  if (thread_count == 0) {
+    thread_count = max(thread::hardware_concurrency(), 1u);
+  }
+
+  for (uint32_t i = 1; i < thread_count; i++) {
+    workers.emplace_back(&JobSystem::WorkerLoop, this, i);
+  }
+
+  TRACE("job system with {0} threads created", thread_count);
+}
+
+JobSystem::~JobSystem() {
+  if (!stopping) {
+    Destroy();
+  }
+}
+
+void JobSystem::Destroy() {
+  {
+    lock_guard<mutex> lock(jobs_mutex);
+    stopping = true;
+  }
+  start_condition.notify_all();
+
+  for (thread &worker : workers) {
+    worker.join();
+  }
+  workers.clear();
+
+  TRACE("job system destroyed");
+}
+
+void JobSystem::WorkerLoop(uint32_t thread_index) {
+  uint64_t last_generation = 0;
+
+  while (true) {
+    {
+      unique_lock<mutex> lock(jobs_mutex);
+      start_condition.wait(lock, [&]() {
+        return stopping || generation != last_generation;
+      });
+
+      if (stopping) {
+        return;
+      }
+
+      last_generation = generation;
+    }
+
+    RunJobs(thread_index);
+
+    {
+      lock_guard<mutex> lock(jobs_mutex);
+      busy_workers--;
+    }
+    done_condition.notify_one();
+  }
+}
+
+void JobSystem::RunJobs(uint32_t thread_index) {
+  // jobs are taken one by one, so uneven jobs still spread over threads
+  for (uint32_t index = next_job++; index < job_count; index = next_job++) {
+    try {
+      job(index, thread_index);
+    } catch (...) {
+      lock_guard<mutex> lock(jobs_mutex);
+      if (!job_exception) {
+        job_exception = current_exception();
+      }
+    }
+  }
+}
+
+void JobSystem::ParallelFor(uint32_t count,
+                            function<void(uint32_t, uint32_t)> job) {
+  if (count == 0) {
+    return;
+  }
+
+  // waking workers costs more than a single job
+  if (count == 1 || workers.empty()) {
+    for (uint32_t i = 0; i < count; i++) {
+      job(i, 0);
+    }
+    return;
+  }
+
+  {
+    lock_guard<mutex> lock(jobs_mutex);
+    this->job = job;
+    job_count = count;
+    next_job = 0;
+    busy_workers = workers.size();
+    job_exception = nullptr;
+    generation++;
+  }
+  start_condition.notify_all();
+
+  RunJobs(0);
+
+  exception_ptr exception;
+  {
+    unique_lock<mutex> lock(jobs_mutex);
+    done_condition.wait(lock, [&]() { return busy_workers == 0; });
+
+    exception = job_exception;
+    this->job = nullptr;
+  }
+
+  if (exception) {
+    rethrow_exception(exception);
+  }
+}
+
+uint32_t JobSystem::GetThreadCount() { return workers.size() + 1; }
+
+} // namespace vk
@@ -0,0 +1,59 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace vk {
+
+struct JobSystemCreateInfo {
+  // threads running jobs including the calling one, 0 uses every hardware
+  // thread
+  uint32_t thread_count = 0;
+};
+
+// fixed set of worker threads which run jobs of one ParallelFor at a time,
+// calling thread works too and is always thread 0
+class JobSystem {
+private:
+  vector<thread> workers;
+
+  mutex jobs_mutex;
+  condition_variable start_condition;
+  condition_variable done_condition;
+  bool stopping;
+  // changes with every ParallelFor, wakes workers for it
+  uint64_t generation;
+
+  function<void(uint32_t, uint32_t)> job;
+  uint32_t job_count;
+  atomic<uint32_t> next_job;
+  uint32_t busy_workers;
+  exception_ptr job_exception;
+
+  void WorkerLoop(uint32_t thread_index);
+  void RunJobs(uint32_t thread_index);
+
+public:
+  JobSystem(JobSystemCreateInfo &create_info);
+  JobSystem(JobSystem &) = delete;
+  JobSystem &operator=(JobSystem &) = delete;
+  ~JobSystem();
+
+  void Destroy();
+
+  // calls job(index, thread_index) for every index below count and returns
+  // after all of them finished, first exception of a job is rethrown
+  void ParallelFor(uint32_t count,
+                   function<void(uint32_t, uint32_t)> job);
+
+  uint32_t GetThreadCount();
+};
+
+} // namespace vk
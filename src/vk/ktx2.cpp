@@ -0,0 +1,241 @@
+#include "ktx2.hpp"
+#include "block_decoder.hpp"
+#include <cstring>
+#include <fstream>
+
+namespace vk {
+
+Ktx2File::Ktx2File(fs::path filepath) {
+  this->filepath = filepath;
+
+  ReadFile();
+  ParseHeader();
+
+  TRACE("ktx2 file {0} with {1} levels read", filepath.string(),
+        level_indices.size());
+}
+
+void Ktx2File::ReadFile() {
+  ifstream file(filepath, ios::binary);
+
+  if (!file) {
+    throw CriticalException("cant open file \"" + filepath.string() + "\"");
+  }
+
+  file.seekg(0, ios::end);
+  size_t filesize = file.tellg();
+  file.seekg(0, ios::beg);
+
+  data.resize(filesize);
+  file.read(data.data(), filesize);
+}
+
+void Ktx2File::ParseHeader() {
+  if (data.size() < sizeof(Ktx2Header)) {
+    throw CriticalException("ktx2 file is too small");
+  }
+
+  memcpy(&header, data.data(), sizeof(Ktx2Header));
+
+  if (memcmp(header.identifier, ktx2_identifier, sizeof(ktx2_identifier))) {
+    throw CriticalException("file is not ktx2");
+  }
+
+  if (header.supercompression_scheme != 0) {
+    throw CriticalException("supercompressed ktx2 is not supported");
+  }
+
+  if (header.pixel_depth > 1 || header.layer_count > 1 ||
+      header.face_count != 1) {
+    throw CriticalException("only 2d ktx2 textures are supported");
+  }
+
+  // level count 0 asks loader to generate mips
+  uint32_t level_count = max(header.level_count, 1u);
+
+  size_t index_end =
+      sizeof(Ktx2Header) + level_count * sizeof(Ktx2LevelIndex);
+  if (data.size() < index_end) {
+    throw CriticalException("ktx2 level index is truncated");
+  }
+
+  level_indices.resize(level_count);
+  memcpy(level_indices.data(), data.data() + sizeof(Ktx2Header),
+         level_count * sizeof(Ktx2LevelIndex));
+
+  if (GetLevelByteLength(GetFormat(), GetSize()) == 0) {
+    throw CriticalException("ktx2 format " + to_string(header.vk_format) +
+                            " is not supported");
+  }
+
+  for (uint32_t i = 0; i < level_count; i++) {
+    Ktx2LevelIndex &level_index = level_indices[i];
+    if (level_index.byte_offset + level_index.byte_length > data.size()) {
+      throw CriticalException("ktx2 level is out of file");
+    }
+
+    glm::ivec2 level_size = glm::max(GetSize() >> (int)i, glm::ivec2(1));
+    if (level_index.byte_length <
+        GetLevelByteLength(GetFormat(), level_size)) {
+      throw CriticalException("ktx2 level " + to_string(i) +
+                              " is shorter than its format requires");
+    }
+  }
+}
+
+size_t Ktx2File::GetLevelByteLength(VkFormat format, glm::ivec2 size) {
+  size_t blocks = (size_t)((size.x + 3) / 4) * ((size.y + 3) / 4);
+  size_t texels = (size_t)size.x * size.y;
+
+  switch (format) {
+  case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+  case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+  case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+  case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+  case VK_FORMAT_BC4_UNORM_BLOCK:
+  case VK_FORMAT_BC4_SNORM_BLOCK:
+  case VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK:
+  case VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK:
+  case VK_FORMAT_ETC2_R8G8B8A1_UNORM_BLOCK:
+  case VK_FORMAT_ETC2_R8G8B8A1_SRGB_BLOCK:
+  case VK_FORMAT_EAC_R11_UNORM_BLOCK:
+  case VK_FORMAT_EAC_R11_SNORM_BLOCK:
+    return blocks * 8;
+  case VK_FORMAT_BC2_UNORM_BLOCK:
+  case VK_FORMAT_BC2_SRGB_BLOCK:
+  case VK_FORMAT_BC3_UNORM_BLOCK:
+  case VK_FORMAT_BC3_SRGB_BLOCK:
+  case VK_FORMAT_BC5_UNORM_BLOCK:
+  case VK_FORMAT_BC5_SNORM_BLOCK:
+  case VK_FORMAT_BC7_UNORM_BLOCK:
+  case VK_FORMAT_BC7_SRGB_BLOCK:
+  case VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK:
+  case VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK:
+  case VK_FORMAT_EAC_R11G11_UNORM_BLOCK:
+  case VK_FORMAT_EAC_R11G11_SNORM_BLOCK:
+    return blocks * 16;
+  case VK_FORMAT_R8_UNORM:
+  case VK_FORMAT_R8_SRGB:
+    return texels;
+  case VK_FORMAT_R8G8_UNORM:
+  case VK_FORMAT_R8G8_SRGB:
+    return texels * 2;
+  case VK_FORMAT_R8G8B8A8_UNORM:
+  case VK_FORMAT_R8G8B8A8_SRGB:
+  case VK_FORMAT_B8G8R8A8_UNORM:
+  case VK_FORMAT_B8G8R8A8_SRGB:
+    return texels * 4;
+  default:
+    return 0;
+  }
+}
+
+fs::path Ktx2File::FindVariant(fs::path filepath,
+                               PhysicalDevice &physical_device) {
+  fs::path decodable;
+  bool has_variants = false;
+
+  for (const Ktx2Variant &variant : ktx2_variants) {
+    fs::path variant_path = filepath;
+    variant_path.replace_extension(string(variant.name) + ".ktx2");
+
+    if (!fs::exists(variant_path)) {
+      continue;
+    }
+
+    has_variants = true;
+    if (IsFormatSupported(physical_device, variant.format)) {
+      return variant_path;
+    }
+
+    if (decodable.empty() && BlockDecoder::IsSupported(variant.format)) {
+      decodable = variant_path;
+    }
+  }
+
+  if (!decodable.empty()) {
+    return decodable;
+  }
+
+  if (has_variants) {
+    throw CriticalException("no variant of \"" + filepath.string() +
+                            "\" is supported by device");
+  }
+
+  return filepath;
+}
+
+VkFormat Ktx2File::GetFormat() { return (VkFormat)header.vk_format; }
+
+glm::ivec2 Ktx2File::GetSize() {
+  return glm::ivec2(header.pixel_width, max(header.pixel_height, 1u));
+}
+
+uint32_t Ktx2File::GetLevelCount() { return level_indices.size(); }
+
+span<const char> Ktx2File::GetLevel(uint32_t level) {
+  Ktx2LevelIndex &level_index = level_indices[level];
+  return span<const char>(data.data() + level_index.byte_offset,
+                          level_index.byte_length);
+}
+
+bool Ktx2File::IsFormatSupported(PhysicalDevice &physical_device,
+                                 VkFormat format) {
+  VkFormatFeatureFlags required_features =
+      VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_TRANSFER_DST_BIT;
+
+  VkFormatProperties format_properties =
+      physical_device.GetFormatProperties(format);
+  return (format_properties.optimalTilingFeatures & required_features) ==
+         required_features;
+}
+
+TextureData Ktx2File::Prepare(PhysicalDevice &physical_device) {
+  TextureData texture_data;
+  texture_data.format = GetFormat();
+  texture_data.size = GetSize();
+  texture_data.mip_levels =
+      header.level_count == 0 ? full_mip_chain : header.level_count;
+
+  if (IsFormatSupported(physical_device, texture_data.format)) {
+    for (uint32_t i = 0; i < GetLevelCount(); i++) {
+      texture_data.levels.push_back(GetLevel(i));
+    }
+
+    // block compressed levels can not be blitted, stored ones are used
+    VkFormatProperties format_properties =
+        physical_device.GetFormatProperties(texture_data.format);
+    if (!(format_properties.optimalTilingFeatures &
+          VK_FORMAT_FEATURE_BLIT_DST_BIT)) {
+      texture_data.mip_levels = GetLevelCount();
+    }
+
+    return texture_data;
+  }
+
+  if (!BlockDecoder::IsSupported(texture_data.format)) {
+    throw CriticalException("ktx2 format " +
+                            to_string(texture_data.format) +
+                            " is not supported by device");
+  }
+
+  DEBUG("ktx2 format {0} is not supported by device, {1} decoded on cpu",
+        (uint32_t)texture_data.format, filepath.string());
+
+  decoded_levels.clear();
+  for (uint32_t i = 0; i < GetLevelCount(); i++) {
+    glm::ivec2 level_size =
+        glm::max(texture_data.size >> (int)i, glm::ivec2(1));
+    decoded_levels.push_back(
+        BlockDecoder::Decode(texture_data.format, GetLevel(i), level_size));
+  }
+
+  texture_data.format = BlockDecoder::GetDecodedFormat(texture_data.format);
+  for (vector<char> &level : decoded_levels) {
+    texture_data.levels.push_back(level);
+  }
+
+  return texture_data;
+}
+
+} // namespace vk
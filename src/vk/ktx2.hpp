@@ -0,0 +1,56 @@
+#pragma once
+#include "exception.hpp"
+#include "ktx2_format.hpp"
+#include "physical_device.hpp"
+#include "texture.hpp"
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+using namespace std;
+namespace fs = filesystem;
+
+namespace vk {
+
+// 2d, single layer and not supercompressed ktx2 texture, levels are
+// uploaded as stored when device can sample their format, otherwise they
+// are decoded on cpu
+class Ktx2File {
+private:
+  fs::path filepath;
+  vector<char> data;
+  Ktx2Header header;
+  vector<Ktx2LevelIndex> level_indices;
+
+  vector<vector<char>> decoded_levels;
+
+  void ReadFile();
+  void ParseHeader();
+
+  static bool IsFormatSupported(PhysicalDevice &physical_device,
+                                VkFormat format);
+  // 0 for formats of unknown layout
+  static size_t GetLevelByteLength(VkFormat format, glm::ivec2 size);
+
+public:
+  // best variant of filepath the device can sample, then one that can be
+  // decoded on cpu, filepath itself when it has no variants
+  static fs::path FindVariant(fs::path filepath,
+                              PhysicalDevice &physical_device);
+
+  Ktx2File(fs::path filepath);
+  Ktx2File(Ktx2File &) = delete;
+  Ktx2File &operator=(Ktx2File &) = delete;
+
+  VkFormat GetFormat();
+  glm::ivec2 GetSize();
+  uint32_t GetLevelCount();
+  span<const char> GetLevel(uint32_t level);
+
+  // returned data points into this file, so it must outlive the upload
+  TextureData Prepare(PhysicalDevice &physical_device);
+};
+
+} // namespace vk
@@ -0,0 +1,55 @@
+#pragma once
+#include <cstdint>
+#include <vulkan/vulkan_core.h>
+
+using namespace std;
+
+// plain ktx2 layout, shared with tools which do not link vulkan code
+
+namespace vk {
+
+constexpr uint8_t ktx2_identifier[12] = {0xAB, 'K',  'T',  'X', ' ',  '2',
+                                         '0',  0xBB, '\r', '\n', 0x1A, '\n'};
+
+// layout of the file start, every field is naturally aligned
+struct Ktx2Header {
+  uint8_t identifier[12];
+  uint32_t vk_format;
+  uint32_t type_size;
+  uint32_t pixel_width;
+  uint32_t pixel_height;
+  uint32_t pixel_depth;
+  uint32_t layer_count;
+  uint32_t face_count;
+  uint32_t level_count;
+  uint32_t supercompression_scheme;
+  uint32_t dfd_byte_offset;
+  uint32_t dfd_byte_length;
+  uint32_t kvd_byte_offset;
+  uint32_t kvd_byte_length;
+  uint64_t sgd_byte_offset;
+  uint64_t sgd_byte_length;
+};
+
+struct Ktx2LevelIndex {
+  uint64_t byte_offset;
+  uint64_t byte_length;
+  uint64_t uncompressed_byte_length;
+};
+
+// texture.ktx2 is stored as texture.<name>.ktx2 variants, one per format
+struct Ktx2Variant {
+  const char *name;
+  VkFormat format;
+};
+
+// colour variants with alpha in loader preference, best quality first,
+// bc1 and bc4 drop channels, so those files are only loaded by full path
+constexpr Ktx2Variant ktx2_variants[] = {
+    {"bc7", VK_FORMAT_BC7_SRGB_BLOCK},
+    {"bc3", VK_FORMAT_BC3_SRGB_BLOCK},
+    {"etc2", VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK},
+    {"rgba8", VK_FORMAT_R8G8B8A8_SRGB},
+};
+
+} // namespace vk
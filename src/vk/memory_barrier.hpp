@@ -8,6 +8,8 @@ using namespace std;
 
 namespace vk {
 
+class BarrierBatch;
+
 struct SrcMemoryBarrier {
   VkPipelineStageFlags stage;
   VkAccessFlags access;
@@ -31,6 +33,8 @@ public:
   MemoryBarrier(Buffer& buffer, SrcMemoryBarrier src, DstMemoryBarrier dst);
 
   void Set(CommandBuffer &command_buffer);
+
+  friend BarrierBatch;
 };
 
 } // namespace vk
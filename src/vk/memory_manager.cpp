@@ -0,0 +1,398 @@
+#include "memory_manager.hpp"
+
+namespace vk {
+
+MemoryManager::MemoryManager(Device &device) : statistics(device) {
+  this->device = &device;
+
+  TRACE("memory manager created");
+}
+
+MemoryManager::~MemoryManager() { Dispose(); }
+
+void MemoryManager::Dispose() {
+  for (MemoryPool &pool : pools) {
+    pool.blocks.clear();
+    pool.dedicated_blocks.clear();
+  }
+}
+
+vector<uint32_t> MemoryManager::GetMemoryTypes(uint32_t allowed_types,
+                                              MemoryUsage usage) {
+  ChooseMemoryTypeInfo choose_info;
+  choose_info.usage = usage;
+  choose_info.memory_types = allowed_types;
+
+  vector<uint32_t> memory_types =
+      device->GetPhysicalDevice().GetMemoryTypes(choose_info);
+  if (memory_types.empty()) {
+    throw MemoryTypeNotFoundException();
+  }
+
+  return memory_types;
+}
+
+VkDeviceSize MemoryManager::GetPoolBlockSize(uint32_t memory_type) {
+  VkDeviceSize heap_size =
+      device->GetPhysicalDevice().GetMemoryTypeHeap(memory_type).size;
+
+  // small heaps, like 256 mb bar, should not be taken by a couple of blocks
+  return min(default_block_size, heap_size / 8);
+}
+
+VkDeviceSize MemoryManager::CalculateBlockSize(uint32_t memory_type,
+                                               MemoryObject &memory_object) {
+  VkDeviceSize block_size = GetPoolBlockSize(memory_type);
+
+  vector<MemoryObject *> memory_objects = {&memory_object};
+  VkDeviceSize object_size = DeviceMemory::CalculateMemorySize(memory_objects);
+
+  return max(block_size, object_size);
+}
+
+bool MemoryManager::IsDedicated(uint32_t memory_type,
+                                MemoryObject &memory_object) {
+  if (memory_object.PrefersDedicated()) {
+    return true;
+  }
+
+  // big objects would leave most of a pooled block unusable
+  return memory_object.GetMemoryRequirements().size >
+         GetPoolBlockSize(memory_type) / 2;
+}
+
+bool MemoryManager::ReserveBudget(uint32_t memory_type, VkDeviceSize size) {
+  uint32_t heap_index =
+      device->GetPhysicalDevice().GetMemoryTypeHeapIndex(memory_type);
+
+  if (statistics.FitsBudget(heap_index, size)) {
+    return true;
+  }
+
+  // spare empty blocks are the only memory which can be evicted for free
+  for (uint32_t i = 0; i < VK_MAX_MEMORY_TYPES; i++) {
+    MemoryPool &pool = pools[i];
+    if (pool.blocks.empty() ||
+        device->GetPhysicalDevice().GetMemoryTypeHeapIndex(i) != heap_index) {
+      continue;
+    }
+
+    for (uint32_t j = pool.blocks.size(); j-- > 0;) {
+      if (pool.blocks[j]->IsEmpty()) {
+        ReleaseBlock(pool.blocks, pool.blocks[j].get());
+      }
+    }
+  }
+
+  return statistics.FitsBudget(heap_index, size);
+}
+
+DeviceMemory *MemoryManager::CreateBlock(uint32_t memory_type,
+                                         MemoryObject &memory_object) {
+  VkDeviceSize block_size = CalculateBlockSize(memory_type, memory_object);
+  if (!ReserveBudget(memory_type, block_size)) {
+    return nullptr;
+  }
+
+  MemoryPool &pool = pools[memory_type];
+  pool.blocks.push_back(
+      make_unique<DeviceMemory>(*device, block_size, memory_type));
+  AddBlockStatistics(*pool.blocks.back());
+
+  DEBUG("memory block of {0} bytes allocated for memory type {1}, {2} blocks "
+        "in pool",
+        block_size, memory_type, pool.blocks.size());
+
+  return pool.blocks.back().get();
+}
+
+DeviceMemory *
+MemoryManager::CreateDedicatedBlock(uint32_t memory_type,
+                                    MemoryObject &memory_object,
+                                    VkMemoryDedicatedAllocateInfo &info) {
+  VkDeviceSize size = memory_object.GetMemoryRequirements().size;
+  if (!ReserveBudget(memory_type, size)) {
+    return nullptr;
+  }
+
+  MemoryPool &pool = pools[memory_type];
+  pool.dedicated_blocks.push_back(
+      make_unique<DeviceMemory>(*device, size, memory_type, &info));
+  AddBlockStatistics(*pool.dedicated_blocks.back());
+
+  DEBUG("dedicated memory of {0} bytes allocated for memory type {1}", size,
+        memory_type);
+
+  return pool.dedicated_blocks.back().get();
+}
+
+void MemoryManager::AddBlockStatistics(DeviceMemory &memory) {
+  statistics.AddBlock(
+      device->GetPhysicalDevice().GetMemoryTypeHeapIndex(memory.GetType()),
+      memory.GetSize());
+}
+
+void MemoryManager::BindBuffer(Buffer &buffer, MemoryUsage usage) {
+  vector<uint32_t> memory_types =
+      GetMemoryTypes(buffer.GetMemoryTypes(), usage);
+
+  // when best memory type is over budget, next ranked type is used
+  for (uint32_t memory_type : memory_types) {
+    if (TryBindBuffer(buffer, memory_type)) {
+      if (memory_type != memory_types.front()) {
+        WARN("buffer placed in fallback memory type {0}", memory_type);
+      }
+
+      statistics.AddAllocation(buffer.GetCategory(),
+                               buffer.GetMemoryRequirements().size);
+      return;
+    }
+  }
+
+  throw OutOfMemoryBudgetException();
+}
+
+bool MemoryManager::TryBindBuffer(Buffer &buffer, uint32_t memory_type) {
+  if (IsDedicated(memory_type, buffer)) {
+    VkMemoryDedicatedAllocateInfo dedicated_info{};
+    dedicated_info.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO;
+    dedicated_info.buffer = buffer.GetHandle();
+
+    DeviceMemory *memory =
+        CreateDedicatedBlock(memory_type, buffer, dedicated_info);
+    if (!memory) {
+      return false;
+    }
+
+    memory->BindBuffer(buffer);
+    return true;
+  }
+
+  for (auto &block : pools[memory_type].blocks) {
+    if (block->TryBindBuffer(buffer)) {
+      return true;
+    }
+  }
+
+  DeviceMemory *memory = CreateBlock(memory_type, buffer);
+  if (!memory) {
+    return false;
+  }
+
+  memory->BindBuffer(buffer);
+  return true;
+}
+
+void MemoryManager::BindImage(Image &image, MemoryUsage usage) {
+  vector<uint32_t> memory_types =
+      GetMemoryTypes(image.GetMemoryTypes(), usage);
+
+  // when best memory type is over budget, next ranked type is used
+  for (uint32_t memory_type : memory_types) {
+    if (TryBindImage(image, memory_type)) {
+      if (memory_type != memory_types.front()) {
+        WARN("image placed in fallback memory type {0}", memory_type);
+      }
+
+      statistics.AddAllocation(image.GetCategory(),
+                               image.GetMemoryRequirements().size);
+      return;
+    }
+  }
+
+  throw OutOfMemoryBudgetException();
+}
+
+bool MemoryManager::TryBindImage(Image &image, uint32_t memory_type) {
+  if (IsDedicated(memory_type, image)) {
+    VkMemoryDedicatedAllocateInfo dedicated_info{};
+    dedicated_info.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO;
+    dedicated_info.image = image.GetHandle();
+
+    DeviceMemory *memory =
+        CreateDedicatedBlock(memory_type, image, dedicated_info);
+    if (!memory) {
+      return false;
+    }
+
+    memory->BindImage(image);
+    return true;
+  }
+
+  for (auto &block : pools[memory_type].blocks) {
+    if (block->TryBindImage(image)) {
+      return true;
+    }
+  }
+
+  DeviceMemory *memory = CreateBlock(memory_type, image);
+  if (!memory) {
+    return false;
+  }
+
+  memory->BindImage(image);
+  return true;
+}
+
+void MemoryManager::FreeBuffer(Buffer &buffer) {
+  DeviceMemory *memory = buffer.memory;
+  memory->FreeBlock(&buffer);
+
+  statistics.RemoveAllocation(buffer.GetCategory(),
+                              buffer.GetMemoryRequirements().size);
+
+  buffer.memory = nullptr;
+  buffer.is_binded = false;
+
+  ReleaseEmptyBlocks(memory);
+}
+
+void MemoryManager::FreeImage(Image &image) {
+  DeviceMemory *memory = image.memory;
+  memory->FreeBlock(&image);
+
+  statistics.RemoveAllocation(image.GetCategory(),
+                              image.GetMemoryRequirements().size);
+
+  image.memory = nullptr;
+
+  ReleaseEmptyBlocks(memory);
+}
+
+DeviceMemory *MemoryManager::AllocateMemory(VkDeviceSize size,
+                                            uint32_t memory_types,
+                                            MemoryUsage usage,
+                                            MemoryCategory category) {
+  // when best memory type is over budget, next ranked type is used
+  for (uint32_t memory_type : GetMemoryTypes(memory_types, usage)) {
+    if (!ReserveBudget(memory_type, size)) {
+      continue;
+    }
+
+    // kept with dedicated blocks, so it is never suballocated or moved
+    MemoryPool &pool = pools[memory_type];
+    pool.dedicated_blocks.push_back(
+        make_unique<DeviceMemory>(*device, size, memory_type));
+    AddBlockStatistics(*pool.dedicated_blocks.back());
+    statistics.AddAllocation(category, size);
+
+    DEBUG("memory of {0} bytes allocated for memory type {1}", size,
+          memory_type);
+
+    return pool.dedicated_blocks.back().get();
+  }
+
+  throw OutOfMemoryBudgetException();
+}
+
+void MemoryManager::FreeMemory(DeviceMemory *memory, MemoryCategory category) {
+  statistics.RemoveAllocation(category, memory->GetSize());
+  ReleaseBlock(pools[memory->GetType()].dedicated_blocks, memory);
+
+  DEBUG("memory released");
+}
+
+void MemoryManager::ReleaseEmptyBlocks(DeviceMemory *freed_memory) {
+  if (!freed_memory->IsEmpty()) {
+    return;
+  }
+
+  MemoryPool &pool = pools[freed_memory->GetType()];
+
+  if (freed_memory->IsDedicated()) {
+    ReleaseBlock(pool.dedicated_blocks, freed_memory);
+
+    DEBUG("dedicated memory released");
+    return;
+  }
+
+  // keep a spare empty block, so alloc/free around the edge of a block does
+  // not call vkAllocateMemory and vkFreeMemory every time
+  uint32_t empty_blocks = 0;
+  for (auto &block : pool.blocks) {
+    if (block->IsEmpty()) {
+      empty_blocks++;
+    }
+  }
+
+  if (empty_blocks <= max_empty_blocks) {
+    return;
+  }
+
+  ReleaseBlock(pool.blocks, freed_memory);
+
+  DEBUG("empty memory block released, {0} blocks in pool", pool.blocks.size());
+}
+
+void MemoryManager::ReleaseBlock(vector<unique_ptr<DeviceMemory>> &blocks,
+                                 DeviceMemory *memory) {
+  statistics.RemoveBlock(
+      device->GetPhysicalDevice().GetMemoryTypeHeapIndex(memory->GetType()),
+      memory->GetSize());
+
+  erase_if(queued_ranges, [&](VkMappedMemoryRange &range) {
+    return range.memory == memory->GetHandle();
+  });
+
+  auto freed_block =
+      find_if(blocks.begin(), blocks.end(),
+              [&](unique_ptr<DeviceMemory> &b) { return b.get() == memory; });
+  blocks.erase(freed_block);
+}
+
+void MemoryManager::QueueFlush(Buffer &buffer, VkDeviceSize offset,
+                               VkDeviceSize size) {
+  if (buffer.memory->IsHostCoherent()) {
+    return;
+  }
+
+  queued_ranges.push_back(
+      buffer.memory->CreateMappedRange(&buffer, offset, size));
+}
+
+void MemoryManager::FlushQueuedRanges() {
+  if (queued_ranges.empty()) {
+    return;
+  }
+
+  VkResult result = vkFlushMappedMemoryRanges(
+      device->GetHandle(), queued_ranges.size(), queued_ranges.data());
+  if (result) {
+    throw CriticalException("cant flush mapped memory ranges");
+  }
+
+  TRACE("{0} mapped memory ranges flushed", queued_ranges.size());
+
+  queued_ranges.clear();
+}
+
+MemoryStatistics &MemoryManager::GetStatistics() { return statistics; }
+
+vector<MemoryFragmentation> MemoryManager::GetFragmentation() {
+  vector<MemoryFragmentation> fragmentation;
+
+  for (uint32_t i = 0; i < VK_MAX_MEMORY_TYPES; i++) {
+    MemoryPool &pool = pools[i];
+    if (pool.blocks.empty()) {
+      continue;
+    }
+
+    MemoryFragmentation pool_fragmentation{};
+    pool_fragmentation.memory_type = i;
+    pool_fragmentation.block_count = pool.blocks.size();
+
+    for (auto &block : pool.blocks) {
+      pool_fragmentation.total_size += block->GetSize();
+      pool_fragmentation.free_size += block->GetFreeSize();
+      pool_fragmentation.largest_free_size =
+          max(pool_fragmentation.largest_free_size,
+              block->GetLargestFreeSize());
+    }
+
+    fragmentation.push_back(pool_fragmentation);
+  }
+
+  return fragmentation;
+}
+
+} // namespace vk
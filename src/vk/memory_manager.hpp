@@ -0,0 +1,89 @@
+#pragma once
+#include "buffer.hpp"
+#include "device.hpp"
+#include "device_memory.hpp"
+#include "image.hpp"
+#include "memory_statistics.hpp"
+#include <memory>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+using namespace std;
+
+namespace vk {
+
+struct MemoryFragmentation {
+  uint32_t memory_type;
+  uint32_t block_count;
+  VkDeviceSize total_size;
+  VkDeviceSize free_size;
+  VkDeviceSize largest_free_size;
+};
+
+// suballocates buffers and images from big per memory type blocks, so
+// vkAllocateMemory is called only when all blocks of a type are full
+class MemoryManager {
+private:
+  struct MemoryPool {
+    vector<unique_ptr<DeviceMemory>> blocks;
+    // one object per memory, never shared with other objects
+    vector<unique_ptr<DeviceMemory>> dedicated_blocks;
+  };
+
+  static constexpr VkDeviceSize default_block_size = 64 * 1024 * 1024;
+  static constexpr uint32_t max_empty_blocks = 1;
+
+  Device *device;
+  MemoryPool pools[VK_MAX_MEMORY_TYPES];
+
+  vector<VkMappedMemoryRange> queued_ranges;
+
+  MemoryStatistics statistics;
+
+  vector<uint32_t> GetMemoryTypes(uint32_t allowed_types, MemoryUsage usage);
+  VkDeviceSize GetPoolBlockSize(uint32_t memory_type);
+  VkDeviceSize CalculateBlockSize(uint32_t memory_type,
+                                  MemoryObject &memory_object);
+  bool IsDedicated(uint32_t memory_type, MemoryObject &memory_object);
+  bool ReserveBudget(uint32_t memory_type, VkDeviceSize size);
+  DeviceMemory *CreateBlock(uint32_t memory_type, MemoryObject &memory_object);
+  DeviceMemory *CreateDedicatedBlock(uint32_t memory_type,
+                                     MemoryObject &memory_object,
+                                     VkMemoryDedicatedAllocateInfo &info);
+  void AddBlockStatistics(DeviceMemory &memory);
+  bool TryBindBuffer(Buffer &buffer, uint32_t memory_type);
+  bool TryBindImage(Image &image, uint32_t memory_type);
+  void ReleaseEmptyBlocks(DeviceMemory *freed_memory);
+  void ReleaseBlock(vector<unique_ptr<DeviceMemory>> &blocks,
+                    DeviceMemory *memory);
+
+public:
+  MemoryManager(Device &device);
+  MemoryManager(MemoryManager &) = delete;
+  MemoryManager &operator=(MemoryManager &) = delete;
+  ~MemoryManager();
+
+  void Dispose();
+
+  void BindBuffer(Buffer &buffer, MemoryUsage usage);
+  void BindImage(Image &image, MemoryUsage usage);
+
+  void FreeBuffer(Buffer &buffer);
+  void FreeImage(Image &image);
+
+  // whole memory for objects binded by caller at its own offsets, like
+  // aliased render graph transients, counted in budget and statistics
+  DeviceMemory *AllocateMemory(VkDeviceSize size, uint32_t memory_types,
+                               MemoryUsage usage, MemoryCategory category);
+  void FreeMemory(DeviceMemory *memory, MemoryCategory category);
+
+  void QueueFlush(Buffer &buffer, VkDeviceSize offset, VkDeviceSize size);
+  void FlushQueuedRanges();
+
+  MemoryStatistics &GetStatistics();
+  vector<MemoryFragmentation> GetFragmentation();
+
+  friend class Defragmenter;
+};
+
+} // namespace vk
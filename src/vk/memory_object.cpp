@@ -8,4 +8,22 @@ VkMemoryRequirements MemoryObject::GetMemoryRequirements() {
 
 uint32_t MemoryObject::GetMemoryTypes() { return requirements.memoryTypeBits; }
 
+bool MemoryObject::PrefersDedicated() { return prefers_dedicated; }
+
+MemoryCategory MemoryObject::GetCategory() { return category; }
+
+bool MemoryObject::IsMovable() { return movable; }
+
+void MemoryObject::SetMovable(bool movable) { this->movable = movable; }
+
+void MemoryObject::AddMoveCallback(function<void()> callback) {
+  move_callbacks.push_back(callback);
+}
+
+void MemoryObject::NotifyMoved() {
+  for (auto &callback : move_callbacks) {
+    callback();
+  }
+}
+
 } // namespace vk
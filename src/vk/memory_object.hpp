@@ -1,17 +1,48 @@
 #pragma once
+#include <functional>
+#include <vector>
 #include <vulkan/vulkan.h>
 
 using namespace std;
 
 namespace vk {
 
+enum class MemoryCategory {
+  other,
+  textures,
+  agent_buffers,
+  staging,
+  uniforms,
+  render_targets
+};
+
+constexpr uint32_t memory_category_count = 6;
+
 class MemoryObject {
 protected:
-
   VkMemoryRequirements requirements;
+  // driver prefers or requires own VkDeviceMemory for this object
+  bool prefers_dedicated = false;
+  MemoryCategory category = MemoryCategory::other;
+
+  // movable objects can be relocated by defragmenter, owners get notified
+  // after the move to update handles they cached, like descriptor sets
+  bool movable = false;
+  vector<function<void()>> move_callbacks;
+
+  void NotifyMoved();
+
 public:
   VkMemoryRequirements GetMemoryRequirements();
   uint32_t GetMemoryTypes();
+  bool PrefersDedicated();
+  MemoryCategory GetCategory();
+
+  bool IsMovable();
+  // object needs transfer src usage and must not be used by other queues
+  // while movable, like texture which is still uploaded
+  void SetMovable(bool movable);
+  void AddMoveCallback(function<void()> callback);
 };
 
 } // namespace vk
@@ -0,0 +1,177 @@
+#include "memory_statistics.hpp"
+#include <algorithm>
+#include <bit>
+
+namespace vk {
+
+MemoryStatistics::MemoryStatistics(Device &device) {
+  this->device = &device;
+  budget_supported =
+      device.IsExtensionEnabled(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+
+  VkPhysicalDeviceMemoryProperties memory_properties =
+      device.GetPhysicalDevice().GetMemoryProperties();
+
+  heaps.resize(memory_properties.memoryHeapCount);
+  driver_usage.resize(heaps.size(), 0);
+  allocated_at_fetch.resize(heaps.size(), 0);
+
+  for (uint32_t i = 0; i < heaps.size(); i++) {
+    VkMemoryHeap heap = memory_properties.memoryHeaps[i];
+
+    heaps[i] = {};
+    heaps[i].size = heap.size;
+    heaps[i].device_local = heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT;
+  }
+
+  for (CategoryStatistics &category : categories) {
+    category = {};
+  }
+
+  for (uint32_t &count : histogram) {
+    count = 0;
+  }
+
+  FetchBudget();
+
+  DEBUG("memory statistics created, driver budget {0}",
+        budget_supported ? "enabled" : "not supported");
+}
+
+void MemoryStatistics::FetchBudget() {
+  blocks_since_fetch = 0;
+
+  if (!budget_supported) {
+    for (uint32_t i = 0; i < heaps.size(); i++) {
+      heaps[i].budget = (VkDeviceSize)(heaps[i].size * own_budget_fraction);
+      UpdateUsage(i);
+    }
+
+    return;
+  }
+
+  VkPhysicalDeviceMemoryBudgetPropertiesEXT budget_properties{};
+  budget_properties.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+
+  VkPhysicalDeviceMemoryProperties2 memory_properties{};
+  memory_properties.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+  memory_properties.pNext = &budget_properties;
+
+  vkGetPhysicalDeviceMemoryProperties2(
+      device->GetPhysicalDevice().GetHandle(), &memory_properties);
+
+  for (uint32_t i = 0; i < heaps.size(); i++) {
+    heaps[i].budget = budget_properties.heapBudget[i];
+    driver_usage[i] = budget_properties.heapUsage[i];
+    allocated_at_fetch[i] = heaps[i].allocated;
+    UpdateUsage(i);
+  }
+}
+
+void MemoryStatistics::UpdateUsage(uint32_t heap_index) {
+  HeapStatistics &heap = heaps[heap_index];
+
+  if (!budget_supported) {
+    heap.usage = heap.allocated;
+    return;
+  }
+
+  // driver numbers are refreshed rarely, own allocations since then are
+  // added on top of them
+  VkDeviceSize usage = driver_usage[heap_index] + heap.allocated;
+  heap.usage = usage - min(usage, allocated_at_fetch[heap_index]);
+}
+
+bool MemoryStatistics::IsBudgetSupported() { return budget_supported; }
+
+bool MemoryStatistics::FitsBudget(uint32_t heap_index, VkDeviceSize size) {
+  if (blocks_since_fetch >= fetch_period) {
+    FetchBudget();
+  }
+
+  HeapStatistics &heap = heaps[heap_index];
+  return heap.usage + size <= heap.budget;
+}
+
+void MemoryStatistics::AddBlock(uint32_t heap_index, VkDeviceSize size) {
+  HeapStatistics &heap = heaps[heap_index];
+  heap.allocated += size;
+  heap.peak_allocated = max(heap.peak_allocated, heap.allocated);
+
+  blocks_since_fetch++;
+  UpdateUsage(heap_index);
+}
+
+void MemoryStatistics::RemoveBlock(uint32_t heap_index, VkDeviceSize size) {
+  HeapStatistics &heap = heaps[heap_index];
+  heap.allocated -= size;
+
+  blocks_since_fetch++;
+  UpdateUsage(heap_index);
+}
+
+void MemoryStatistics::AddAllocation(MemoryCategory category,
+                                     VkDeviceSize size) {
+  CategoryStatistics &statistics = categories[(uint32_t)category];
+  statistics.used += size;
+  statistics.peak_used = max(statistics.peak_used, statistics.used);
+  statistics.allocation_count++;
+
+  histogram[GetHistogramBucket(size)]++;
+}
+
+void MemoryStatistics::RemoveAllocation(MemoryCategory category,
+                                        VkDeviceSize size) {
+  CategoryStatistics &statistics = categories[(uint32_t)category];
+  statistics.used -= size;
+  statistics.allocation_count--;
+
+  histogram[GetHistogramBucket(size)]--;
+}
+
+const vector<HeapStatistics> &MemoryStatistics::GetHeaps() { return heaps; }
+
+const CategoryStatistics &
+MemoryStatistics::GetCategory(MemoryCategory category) {
+  return categories[(uint32_t)category];
+}
+
+uint32_t MemoryStatistics::GetHistogramCount(uint32_t bucket) {
+  return histogram[bucket];
+}
+
+uint32_t MemoryStatistics::GetHistogramBucket(VkDeviceSize size) {
+  if (size <= min_histogram_size) {
+    return 0;
+  }
+
+  uint32_t bucket = bit_width((size - 1) / min_histogram_size);
+  return min(bucket, memory_histogram_size - 1);
+}
+
+VkDeviceSize MemoryStatistics::GetHistogramBucketSize(uint32_t bucket) {
+  return min_histogram_size << bucket;
+}
+
+const char *MemoryStatistics::GetCategoryName(MemoryCategory category) {
+  switch (category) {
+  case MemoryCategory::other:
+    return "other";
+  case MemoryCategory::textures:
+    return "textures";
+  case MemoryCategory::agent_buffers:
+    return "agent buffers";
+  case MemoryCategory::staging:
+    return "staging";
+  case MemoryCategory::uniforms:
+    return "uniforms";
+  case MemoryCategory::render_targets:
+    return "render targets";
+  }
+
+  return "unknown";
+}
+
+} // namespace vk
@@ -0,0 +1,76 @@
+#pragma once
+#include "device.hpp"
+#include "memory_object.hpp"
+#include <vector>
+#include <vulkan/vulkan.h>
+
+using namespace std;
+
+namespace vk {
+
+// bucket i counts allocations up to 4 kb << i, last one takes the rest
+constexpr uint32_t memory_histogram_size = 18;
+
+struct HeapStatistics {
+  VkDeviceSize size;
+  VkDeviceSize budget;
+  // whole process usage when budget comes from driver
+  VkDeviceSize usage;
+  // VkDeviceMemory allocated by memory manager
+  VkDeviceSize allocated;
+  VkDeviceSize peak_allocated;
+  bool device_local;
+};
+
+struct CategoryStatistics {
+  VkDeviceSize used;
+  VkDeviceSize peak_used;
+  uint32_t allocation_count;
+};
+
+// tracks heap budgets, from VK_EXT_memory_budget when it is enabled or from
+// own bookkeeping otherwise, and usage of objects per category and size
+class MemoryStatistics {
+private:
+  static constexpr uint32_t fetch_period = 32;
+  static constexpr VkDeviceSize min_histogram_size = 4 * 1024;
+  // without driver numbers other processes are unknown, so keep a margin
+  static constexpr float own_budget_fraction = 0.8f;
+
+  Device *device;
+  bool budget_supported;
+
+  vector<HeapStatistics> heaps;
+  vector<VkDeviceSize> driver_usage;
+  vector<VkDeviceSize> allocated_at_fetch;
+  uint32_t blocks_since_fetch;
+
+  CategoryStatistics categories[memory_category_count];
+  uint32_t histogram[memory_histogram_size];
+
+  static uint32_t GetHistogramBucket(VkDeviceSize size);
+  void UpdateUsage(uint32_t heap_index);
+
+public:
+  MemoryStatistics(Device &device);
+  MemoryStatistics(MemoryStatistics &) = delete;
+  MemoryStatistics &operator=(MemoryStatistics &) = delete;
+
+  void FetchBudget();
+  bool IsBudgetSupported();
+  bool FitsBudget(uint32_t heap_index, VkDeviceSize size);
+
+  void AddBlock(uint32_t heap_index, VkDeviceSize size);
+  void RemoveBlock(uint32_t heap_index, VkDeviceSize size);
+  void AddAllocation(MemoryCategory category, VkDeviceSize size);
+  void RemoveAllocation(MemoryCategory category, VkDeviceSize size);
+
+  const vector<HeapStatistics> &GetHeaps();
+  const CategoryStatistics &GetCategory(MemoryCategory category);
+  uint32_t GetHistogramCount(uint32_t bucket);
+
+  static const char *GetCategoryName(MemoryCategory category);
+  static VkDeviceSize GetHistogramBucketSize(uint32_t bucket);
+};
+
+} // namespace vk
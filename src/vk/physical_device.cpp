@@ -1,5 +1,8 @@
 #include "physical_device.hpp"
 #include "exception.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstring>
 
 namespace vk {
 
@@ -16,6 +19,18 @@ PhysicalDevice::PhysicalDevice(VkPhysicalDevice handle) {
   queue_families_properties.resize(queue_families_count);
   vkGetPhysicalDeviceQueueFamilyProperties(handle, &queue_families_count,
                                            queue_families_properties.data());
+
+  uint32_t extensions_count;
+  vkEnumerateDeviceExtensionProperties(handle, nullptr, &extensions_count,
+                                       nullptr);
+  extensions.resize(extensions_count);
+  vkEnumerateDeviceExtensionProperties(handle, nullptr, &extensions_count,
+                                       extensions.data());
+
+  // memory properties never change, so ranking is done once per usage
+  for (uint32_t i = 0; i < memory_usage_count; i++) {
+    RankMemoryTypes((MemoryUsage)i);
+  }
 }
 
 VkSurfaceCapabilitiesKHR
@@ -55,39 +70,242 @@ PhysicalDevice::GetSurfacePresentModes(VkSurfaceKHR surface) {
 
 VkPhysicalDevice PhysicalDevice::GetHandle() { return handle; }
 
+VkPhysicalDeviceProperties PhysicalDevice::GetProperties() {
+  return properties;
+}
+
+VkPhysicalDeviceIDProperties PhysicalDevice::GetIdProperties() {
+  VkPhysicalDeviceIDProperties id_properties{};
+  id_properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES;
+
+  VkPhysicalDeviceProperties2 properties2{};
+  properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+  properties2.pNext = &id_properties;
+
+  vkGetPhysicalDeviceProperties2(handle, &properties2);
+
+  id_properties.pNext = nullptr;
+  return id_properties;
+}
+
 VkPhysicalDeviceLimits PhysicalDevice::GetLimits() { return properties.limits; }
 
-uint32_t PhysicalDevice::ChooseQueueFamily(VkQueueFlags requirements) {
+uint32_t PhysicalDevice::GetApiVersion() { return properties.apiVersion; }
+
+VkPhysicalDeviceVulkan12Features PhysicalDevice::GetVulkan12Features() {
+  VkPhysicalDeviceVulkan12Features vulkan12_features{};
+  vulkan12_features.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+
+  VkPhysicalDeviceFeatures2 features{};
+  features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+  features.pNext = &vulkan12_features;
+
+  vkGetPhysicalDeviceFeatures2(handle, &features);
+
+  vulkan12_features.pNext = nullptr;
+  return vulkan12_features;
+}
+
+bool PhysicalDevice::IsSynchronization2Supported() {
+  if (!IsExtensionSupported(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME)) {
+    return false;
+  }
+
+  VkPhysicalDeviceSynchronization2FeaturesKHR synchronization2_features{};
+  synchronization2_features.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR;
+
+  VkPhysicalDeviceFeatures2 features{};
+  features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+  features.pNext = &synchronization2_features;
+
+  vkGetPhysicalDeviceFeatures2(handle, &features);
+
+  return synchronization2_features.synchronization2;
+}
+
+VkFormatProperties PhysicalDevice::GetFormatProperties(VkFormat format) {
+  VkFormatProperties format_properties;
+  vkGetPhysicalDeviceFormatProperties(handle, format, &format_properties);
+
+  return format_properties;
+}
+
+uint32_t PhysicalDevice::ChooseQueueFamily(VkQueueFlags requirements,
+                                           VkQueueFlags avoided) {
+  uint32_t best_family = UINT32_MAX;
+  uint32_t best_cost = UINT32_MAX;
+
   for (uint32_t i = 0; i < queue_families_properties.size(); i++) {
-    if ((queue_families_properties[i].queueFlags & requirements) ==
-        requirements) {
-      return i;
+    VkQueueFlags flags = queue_families_properties[i].queueFlags;
+
+    // graphics and compute families support transfers without reporting it
+    if (flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)) {
+      flags |= VK_QUEUE_TRANSFER_BIT;
+    }
+
+    if ((flags & requirements) != requirements) {
+      continue;
+    }
+
+    // graphics is the most shared capability, family with it is the last
+    // choice even if it has fewer other avoided flags
+    uint32_t cost =
+        popcount((VkQueueFlags)(flags & avoided & ~VK_QUEUE_GRAPHICS_BIT));
+    if (flags & avoided & VK_QUEUE_GRAPHICS_BIT) {
+      cost += 32;
+    }
+
+    if (cost < best_cost) {
+      best_family = i;
+      best_cost = cost;
     }
   }
 
-  throw QueueFamilyNotFoundException();
+  if (best_family == UINT32_MAX) {
+    throw QueueFamilyNotFoundException();
+  }
+
+  return best_family;
 };
 
+VkQueueFamilyProperties
+PhysicalDevice::GetQueueFamilyProperties(uint32_t family) {
+  return queue_families_properties[family];
+}
+
+PhysicalDevice::MemoryUsageFlags
+PhysicalDevice::GetMemoryUsageFlags(MemoryUsage usage, uint32_t memory_type) {
+  MemoryUsageFlags flags{};
+  flags.forbidden = VK_MEMORY_PROPERTY_PROTECTED_BIT;
+
+  switch (usage) {
+  case MemoryUsage::gpu_only:
+    flags.preferred = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    flags.forbidden |= VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+    break;
+
+  case MemoryUsage::upload:
+    flags.required = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+    flags.preferred = VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    break;
+
+  case MemoryUsage::readback:
+    flags.required = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+    flags.preferred =
+        VK_MEMORY_PROPERTY_HOST_CACHED_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    break;
+
+  case MemoryUsage::dynamic_per_frame:
+    flags.required = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+    flags.preferred = VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+    // small bar window is left for drivers, data goes over pcie each read
+    if (IsResizableBar(memory_type)) {
+      flags.preferred |= VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    }
+    break;
+
+  case MemoryUsage::transient_attachment:
+    flags.required = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    flags.preferred = VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+    flags.forbidden |= VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+    break;
+  }
+
+  return flags;
+}
+
+void PhysicalDevice::RankMemoryTypes(MemoryUsage usage) {
+  vector<pair<uint32_t, uint32_t>> costs;
+
+  for (uint32_t i = 0; i < memory_properties.memoryTypeCount; i++) {
+    VkMemoryPropertyFlags type_flags =
+        memory_properties.memoryTypes[i].propertyFlags;
+    MemoryUsageFlags flags = GetMemoryUsageFlags(usage, i);
+
+    if ((type_flags & flags.required) != flags.required ||
+        (type_flags & flags.forbidden)) {
+      continue;
+    }
+
+    // every missing preferred and every not asked flag costs one point,
+    // so gpu only resources do not take bar and staging stays in ram
+    uint32_t missing_flags = flags.preferred & ~type_flags;
+    uint32_t extra_flags = type_flags & ~(flags.required | flags.preferred);
+    uint32_t cost = popcount(missing_flags) + popcount(extra_flags);
+
+    costs.push_back({cost, i});
+  }
+
+  // types with equal cost stay in driver order, it is sorted by performance
+  stable_sort(costs.begin(), costs.end(),
+              [](auto &a, auto &b) { return a.first < b.first; });
+
+  for (auto &[cost, memory_type] : costs) {
+    ranked_memory_types[(uint32_t)usage].push_back(memory_type);
+  }
+}
+
 uint32_t PhysicalDevice::ChooseMemoryType(ChooseMemoryTypeInfo &choose_info) {
-  bool valid_heaps[VK_MAX_MEMORY_HEAPS] = {0};
+  vector<uint32_t> memory_types = GetMemoryTypes(choose_info);
+  if (memory_types.empty()) {
+    throw MemoryTypeNotFoundException();
+  }
+
+  return memory_types.front();
+}
+
+vector<uint32_t>
+PhysicalDevice::GetMemoryTypes(ChooseMemoryTypeInfo &choose_info) {
+  vector<uint32_t> memory_types;
 
-  for (int i = 0; i < memory_properties.memoryHeapCount; i++) {
-    VkMemoryHeap heap = memory_properties.memoryHeaps[i];
-    if ((heap.flags & choose_info.heap_properties) ==choose_info.heap_properties) {
-      valid_heaps[i] = true;
-    };
+  for (uint32_t memory_type :
+       ranked_memory_types[(uint32_t)choose_info.usage]) {
+    if (1 << memory_type & choose_info.memory_types) {
+      memory_types.push_back(memory_type);
+    }
   }
 
-  for (int i = 0; i < memory_properties.memoryTypeCount; i++) {
-    VkMemoryType memory_type = memory_properties.memoryTypes[i];
-    if (valid_heaps[memory_type.heapIndex] &&
-        (memory_type.propertyFlags & choose_info.properties) == choose_info.properties &&
-        (1 << i & choose_info.memory_types)) {
-      return i;
+  return memory_types;
+}
+
+VkPhysicalDeviceMemoryProperties PhysicalDevice::GetMemoryProperties() {
+  return memory_properties;
+}
+
+bool PhysicalDevice::IsResizableBar(uint32_t memory_type) {
+  VkMemoryPropertyFlags flags = GetMemoryTypeProperties(memory_type);
+  VkMemoryPropertyFlags bar_flags =
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+
+  return (flags & bar_flags) == bar_flags &&
+         GetMemoryTypeHeap(memory_type).size > bar_heap_size;
+}
+
+VkMemoryHeap PhysicalDevice::GetMemoryTypeHeap(uint32_t memory_type) {
+  uint32_t heap_index = memory_properties.memoryTypes[memory_type].heapIndex;
+  return memory_properties.memoryHeaps[heap_index];
+}
+
+uint32_t PhysicalDevice::GetMemoryTypeHeapIndex(uint32_t memory_type) {
+  return memory_properties.memoryTypes[memory_type].heapIndex;
+}
+
+VkMemoryPropertyFlags
+PhysicalDevice::GetMemoryTypeProperties(uint32_t memory_type) {
+  return memory_properties.memoryTypes[memory_type].propertyFlags;
+}
+
+bool PhysicalDevice::IsExtensionSupported(const char *extension_name) {
+  for (VkExtensionProperties &extension : extensions) {
+    if (strcmp(extension.extensionName, extension_name) == 0) {
+      return true;
     }
   }
 
-  throw MemoryTypeNotFoundException();
+  return false;
 }
 
 } // namespace vk
@@ -7,18 +7,48 @@ using namespace std;
 
 namespace vk {
 
+enum class MemoryUsage {
+  // device local, never touched by cpu
+  gpu_only,
+  // written once by cpu and copied to gpu only memory, like staging buffers
+  upload,
+  // written by gpu and read back by cpu
+  readback,
+  // rewritten by cpu every frame and read directly by gpu
+  dynamic_per_frame,
+  // attachments which live only inside a render pass
+  transient_attachment
+};
+
+constexpr uint32_t memory_usage_count = 5;
+
 struct ChooseMemoryTypeInfo {
-  VkMemoryPropertyFlags properties;
-  VkMemoryHeapFlags heap_properties;
+  MemoryUsage usage;
   uint32_t memory_types;
 };
 
 class PhysicalDevice {
 private:
+  struct MemoryUsageFlags {
+    VkMemoryPropertyFlags required;
+    VkMemoryPropertyFlags preferred;
+    VkMemoryPropertyFlags forbidden;
+  };
+
+  // legacy bar window, bigger device local host visible heap is resizable bar
+  static constexpr VkDeviceSize bar_heap_size = 256 * 1024 * 1024;
+
   VkPhysicalDevice handle;
   VkPhysicalDeviceProperties properties;
   VkPhysicalDeviceMemoryProperties memory_properties;
   vector<VkQueueFamilyProperties> queue_families_properties;
+  vector<VkExtensionProperties> extensions;
+
+  vector<uint32_t> ranked_memory_types[memory_usage_count];
+
+  MemoryUsageFlags GetMemoryUsageFlags(MemoryUsage usage,
+                                       uint32_t memory_type);
+  void RankMemoryTypes(MemoryUsage usage);
 
 public:
   PhysicalDevice(VkPhysicalDevice handle);
@@ -26,9 +56,25 @@ public:
   PhysicalDevice &operator=(PhysicalDevice &) = delete;
 
   VkPhysicalDevice GetHandle();
+  VkPhysicalDeviceProperties GetProperties();
+  VkPhysicalDeviceIDProperties GetIdProperties();
   VkPhysicalDeviceLimits GetLimits();
-  uint32_t ChooseQueueFamily(VkQueueFlags requirements);
+  uint32_t GetApiVersion();
+  VkPhysicalDeviceVulkan12Features GetVulkan12Features();
+  bool IsSynchronization2Supported();
+  VkFormatProperties GetFormatProperties(VkFormat format);
+  // family with fewest avoided flags wins, first one on a tie
+  uint32_t ChooseQueueFamily(VkQueueFlags requirements,
+                             VkQueueFlags avoided = 0);
+  VkQueueFamilyProperties GetQueueFamilyProperties(uint32_t family);
   uint32_t ChooseMemoryType(ChooseMemoryTypeInfo &choose_info);
+  vector<uint32_t> GetMemoryTypes(ChooseMemoryTypeInfo &choose_info);
+  VkPhysicalDeviceMemoryProperties GetMemoryProperties();
+  VkMemoryHeap GetMemoryTypeHeap(uint32_t memory_type);
+  uint32_t GetMemoryTypeHeapIndex(uint32_t memory_type);
+  VkMemoryPropertyFlags GetMemoryTypeProperties(uint32_t memory_type);
+  bool IsResizableBar(uint32_t memory_type);
+  bool IsExtensionSupported(const char *extension_name);
   VkSurfaceCapabilitiesKHR GetSurfaceCapabilities(VkSurfaceKHR surface);
   vector<VkSurfaceFormatKHR> GetSurfaceFormats(VkSurfaceKHR surface);
   vector<VkPresentModeKHR> GetSurfacePresentModes(VkSurfaceKHR surface);
@@ -0,0 +1,250 @@
+#include "pipeline_cache.hpp"
+#include "device.hpp"
+#include <cstring>
+#include <fstream>
+
+namespace vk {
+
+PipelineCache::PipelineCache(Device &device, fs::path filepath) {
+  this->device = &device;
+  this->filepath = filepath;
+  warm = false;
+  created_pipeline_count = 0;
+
+  vector<char> data = ReadFile();
+
+  VkPipelineCacheCreateInfo create_info = pipeline_cache_create_info_template;
+  create_info.initialDataSize = data.size();
+  create_info.pInitialData = data.data();
+
+  VkResult result = vkCreatePipelineCache(device.GetHandle(), &create_info,
+                                          nullptr, &handle);
+  if (result) {
+    throw CriticalException("cant create pipeline cache");
+  }
+
+  warm = !data.empty();
+
+  if (warm) {
+    DEBUG("pipeline cache created warm from {0} bytes", data.size());
+  } else {
+    DEBUG("pipeline cache created cold");
+  }
+}
+
+PipelineCache::~PipelineCache() {
+  if (handle == VK_NULL_HANDLE) {
+    return;
+  }
+
+  Destroy();
+}
+
+void PipelineCache::Destroy() {
+  try {
+    Save();
+  } catch (CriticalException &) {
+    // next run only compiles pipelines again
+  }
+
+  for (auto &[key, pipeline] : pipelines) {
+    vkDestroyPipeline(device->GetHandle(), pipeline, nullptr);
+  }
+  pipelines.clear();
+
+  vkDestroyPipelineCache(device->GetHandle(), handle, nullptr);
+  handle = VK_NULL_HANDLE;
+
+  TRACE("pipeline cache destroyed");
+}
+
+PipelineCacheFileHeader PipelineCache::CreateHeader() {
+  PhysicalDevice &physical_device = device->GetPhysicalDevice();
+  VkPhysicalDeviceProperties properties = physical_device.GetProperties();
+  VkPhysicalDeviceIDProperties id_properties =
+      physical_device.GetIdProperties();
+
+  PipelineCacheFileHeader header{};
+  header.magic = pipeline_cache_magic;
+  header.vendor_id = properties.vendorID;
+  header.device_id = properties.deviceID;
+  memcpy(header.driver_uuid, id_properties.driverUUID, VK_UUID_SIZE);
+  memcpy(header.pipeline_cache_uuid, properties.pipelineCacheUUID,
+         VK_UUID_SIZE);
+
+  return header;
+}
+
+// fields are compared one by one, padding of read header is arbitrary
+bool PipelineCache::IsHeaderValid(PipelineCacheFileHeader &header) {
+  PipelineCacheFileHeader expected_header = CreateHeader();
+
+  return header.magic == expected_header.magic &&
+         header.vendor_id == expected_header.vendor_id &&
+         header.device_id == expected_header.device_id &&
+         memcmp(header.driver_uuid, expected_header.driver_uuid,
+                VK_UUID_SIZE) == 0 &&
+         memcmp(header.pipeline_cache_uuid, expected_header.pipeline_cache_uuid,
+                VK_UUID_SIZE) == 0;
+}
+
+// returns no data when file is missing or written by other device or driver
+vector<char> PipelineCache::ReadFile() {
+  if (filepath.empty()) {
+    return {};
+  }
+
+  ifstream file(filepath, ios::binary);
+  if (!file) {
+    DEBUG("no pipeline cache file {0}", filepath.string());
+    return {};
+  }
+
+  PipelineCacheFileHeader header;
+  file.read((char *)&header, sizeof(header));
+
+  if (!file || !IsHeaderValid(header)) {
+    DEBUG("pipeline cache file {0} is from other device or driver",
+          filepath.string());
+    return {};
+  }
+
+  vector<char> data(header.data_size);
+  file.read(data.data(), data.size());
+
+  if (!file) {
+    WARN("pipeline cache file {0} is truncated", filepath.string());
+    return {};
+  }
+
+  return data;
+}
+
+void PipelineCache::Save() {
+  if (filepath.empty()) {
+    return;
+  }
+
+  size_t data_size;
+  VkResult result =
+      vkGetPipelineCacheData(device->GetHandle(), handle, &data_size, nullptr);
+  if (result) {
+    throw CriticalException("cant get pipeline cache data size");
+  }
+
+  vector<char> data(data_size);
+  result = vkGetPipelineCacheData(device->GetHandle(), handle, &data_size,
+                                  data.data());
+  if (result) {
+    throw CriticalException("cant get pipeline cache data");
+  }
+  data.resize(data_size);
+
+  PipelineCacheFileHeader header = CreateHeader();
+  header.data_size = data.size();
+
+  fs::path temporary_path = filepath;
+  temporary_path += ".tmp";
+
+  {
+    ofstream file(temporary_path, ios::binary | ios::trunc);
+    file.write((char *)&header, sizeof(header));
+    file.write(data.data(), data.size());
+
+    if (!file) {
+      throw CriticalException("cant write pipeline cache file \"" +
+                              temporary_path.string() + "\"");
+    }
+  }
+
+  error_code error;
+  fs::rename(temporary_path, filepath, error);
+  if (error) {
+    throw CriticalException("cant replace pipeline cache file \"" +
+                            filepath.string() + "\"");
+  }
+
+  DEBUG("pipeline cache with {0} bytes saved to {1}", data.size(),
+        filepath.string());
+}
+
+VkPipeline PipelineCache::GetPipeline(const string &key,
+                                      function<VkPipeline()> create) {
+  {
+    lock_guard<mutex> lock(pipelines_mutex);
+
+    auto it = pipelines.find(key);
+    if (it != pipelines.end()) {
+      TRACE("pipeline {0:x} reused", hash<string>()(key));
+      return it->second;
+    }
+  }
+
+  VkPipeline created_pipeline = create();
+
+  {
+    lock_guard<mutex> lock(pipelines_mutex);
+
+    auto [it, inserted] = pipelines.emplace(key, created_pipeline);
+    if (inserted) {
+      created_pipeline_count++;
+      DEBUG("pipeline {0:x} created", hash<string>()(key));
+      return created_pipeline;
+    }
+
+    // other thread built identical description meanwhile
+    vkDestroyPipeline(device->GetHandle(), created_pipeline, nullptr);
+    return it->second;
+  }
+}
+
+VkShaderModule PipelineCache::CreateShaderModule(const vector<char> &code) {
+  VkShaderModuleCreateInfo create_info = shader_module_create_info_template;
+  create_info.codeSize = code.size();
+  create_info.pCode = (uint32_t *)code.data();
+
+  VkShaderModule module;
+  VkResult result =
+      vkCreateShaderModule(device->GetHandle(), &create_info, nullptr, &module);
+  if (result) {
+    throw CriticalException("cant create shader module");
+  }
+
+  TRACE("shader module with {0} bytes created", code.size());
+
+  return module;
+}
+
+void PipelineCache::DestroyPipeline(VkPipeline pipeline) {
+  lock_guard<mutex> lock(pipelines_mutex);
+
+  for (auto it = pipelines.begin(); it != pipelines.end(); it++) {
+    if (it->second != pipeline) {
+      continue;
+    }
+
+    TRACE("pipeline {0:x} destroyed", hash<string>()(it->first));
+
+    vkDestroyPipeline(device->GetHandle(), pipeline, nullptr);
+    pipelines.erase(it);
+    return;
+  }
+}
+
+uint32_t PipelineCache::GetPipelineCount() {
+  lock_guard<mutex> lock(pipelines_mutex);
+
+  return pipelines.size();
+}
+
+uint32_t PipelineCache::GetCreatedPipelineCount() {
+  lock_guard<mutex> lock(pipelines_mutex);
+
+  return created_pipeline_count;
+}
+
+bool PipelineCache::IsWarm() { return warm; }
+
+VkPipelineCache PipelineCache::GetHandle() { return handle; }
+
+} // namespace vk
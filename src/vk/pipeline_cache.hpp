@@ -0,0 +1,85 @@
+#pragma once
+#include "exception.hpp"
+#include "templates.hpp"
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+using namespace std;
+namespace fs = filesystem;
+
+namespace vk {
+
+class Device;
+
+// driver data is valid only for the device and driver which wrote it
+struct PipelineCacheFileHeader {
+  uint32_t magic;
+  uint32_t vendor_id;
+  uint32_t device_id;
+  uint8_t driver_uuid[VK_UUID_SIZE];
+  uint8_t pipeline_cache_uuid[VK_UUID_SIZE];
+  uint64_t data_size;
+};
+
+constexpr uint32_t pipeline_cache_magic = 0x48435056; // "VPCH"
+
+// one cache shared by every pipeline creation of the device, loaded from
+// file when it was written by the same device and driver, written back on
+// Destroy, empty filepath keeps it in memory only, it also owns pipelines
+// built from descriptions so identical ones are compiled once, keys hold
+// spir-v code, so unchanged code is never made into module again
+class PipelineCache {
+private:
+  Device *device;
+  VkPipelineCache handle;
+  fs::path filepath;
+  // pipelines can be created from loaded data without compilation
+  bool warm;
+
+  // maps below are guarded by mutex since warmup threads build pipelines
+  // at once, pipelines are keyed by whole description
+  mutex pipelines_mutex;
+  unordered_map<string, VkPipeline> pipelines;
+  uint32_t created_pipeline_count;
+
+  PipelineCacheFileHeader CreateHeader();
+  bool IsHeaderValid(PipelineCacheFileHeader &header);
+  vector<char> ReadFile();
+
+public:
+  PipelineCache(Device &device, fs::path filepath);
+  PipelineCache(PipelineCache &) = delete;
+  PipelineCache &operator=(PipelineCache &) = delete;
+  ~PipelineCache();
+
+  void Destroy();
+
+  // file is replaced by rename, so crash during write never leaves it
+  // half written
+  void Save();
+
+  // returns pipeline stored under key or stores one made by create, which
+  // runs without lock, so several threads can compile different keys, when
+  // other thread stored same key meanwhile, created pipeline is destroyed
+  VkPipeline GetPipeline(const string &key, function<VkPipeline()> create);
+  // pipeline replaced by shader reload, gpu must be done with it, nothing
+  // happens when it is not cached
+  void DestroyPipeline(VkPipeline pipeline);
+  uint32_t GetPipelineCount();
+  // module is needed only while pipeline is created, caller destroys it
+  // right after, so code replaced by reload does not keep its module
+  VkShaderModule CreateShaderModule(const vector<char> &code);
+  // compiles since creation, resizes must not add to it
+  uint32_t GetCreatedPipelineCount();
+
+  bool IsWarm();
+  VkPipelineCache GetHandle();
+};
+
+} // namespace vk
@@ -0,0 +1,260 @@
+#include "pipeline_warmup.hpp"
+
+namespace vk {
+
+PipelineWarmup::PipelineWarmup(Device &device,
+                               PipelineWarmupCreateInfo &create_info) {
+  this->device = &device;
+
+  JobSystemCreateInfo job_system_create_info;
+  job_system_create_info.thread_count = create_info.thread_count;
+
+  job_system = make_unique<JobSystem>(job_system_create_info);
+
+  TRACE("pipeline warmup with {0} threads created",
+        job_system->GetThreadCount());
+}
+
+PipelineWarmup::~PipelineWarmup() {
+  if (job_system == nullptr) {
+    return;
+  }
+
+  Destroy();
+}
+
+void PipelineWarmup::Destroy() {
+  // pipelines themselves are owned by device pipeline cache
+  WaitIdle();
+
+  job_system.reset();
+  entries.clear();
+  // retired pipelines are destroyed with the cache
+  retired.clear();
+
+  TRACE("pipeline warmup destroyed");
+}
+
+PipelineTicket PipelineWarmup::Add(GraphicsPipelineBuilder &builder) {
+  return Add(Builder(builder));
+}
+
+PipelineTicket PipelineWarmup::Add(ComputePipelineBuilder &builder) {
+  return Add(Builder(builder));
+}
+
+PipelineTicket PipelineWarmup::Add(Builder builder) {
+  unique_ptr<Entry> entry = make_unique<Entry>();
+  entry->builder = move(builder);
+  entry->pipeline = entry->pipeline_promise.get_future().share();
+  entry->started = false;
+  entry->reloaded = VK_NULL_HANDLE;
+
+  lock_guard<mutex> lock(entries_mutex);
+  entries.push_back(move(entry));
+
+  return entries.size() - 1;
+}
+
+void PipelineWarmup::Start() {
+  if (compile_thread.joinable()) {
+    compile_thread.join();
+  }
+
+  vector<Entry *> pending;
+  {
+    lock_guard<mutex> lock(entries_mutex);
+    for (unique_ptr<Entry> &entry : entries) {
+      if (!entry->started) {
+        entry->started = true;
+        pending.push_back(entry.get());
+      }
+    }
+  }
+
+  if (pending.empty()) {
+    return;
+  }
+
+  DEBUG("pipeline warmup of {0} pipelines started", pending.size());
+
+  compile_thread = thread([this, pending]() {
+    chrono::high_resolution_clock::time_point start =
+        chrono::high_resolution_clock::now();
+
+    // errors are kept in entry promises, so jobs never throw
+    job_system->ParallelFor(
+        pending.size(), [&](uint32_t index, uint32_t thread_index) {
+          Compile(*pending[index]);
+        });
+
+    float time = chrono::duration<float, milli>(
+                     chrono::high_resolution_clock::now() - start)
+                     .count();
+    DEBUG("pipeline warmup of {0} pipelines finished in {1} ms",
+          pending.size(), time);
+  });
+}
+
+void PipelineWarmup::Compile(Entry &entry) {
+  try {
+    entry.pipeline_promise.set_value(visit(
+        [&](auto &builder) { return builder.Build(*device); }, entry.builder));
+  } catch (...) {
+    entry.pipeline_promise.set_exception(current_exception());
+  }
+}
+
+VkPipeline PipelineWarmup::Get(PipelineTicket ticket) {
+  Entry *entry;
+  bool compile;
+  {
+    lock_guard<mutex> lock(entries_mutex);
+    if (ticket >= entries.size()) {
+      throw CriticalException("pipeline ticket " + to_string(ticket) +
+                              " is not added");
+    }
+
+    entry = entries[ticket].get();
+    compile = !entry->started;
+    entry->started = true;
+  }
+
+  if (compile) {
+    Compile(*entry);
+  }
+
+  // reload also fixes pipeline whose first compilation failed
+  {
+    lock_guard<mutex> lock(entries_mutex);
+    if (entry->reloaded != VK_NULL_HANDLE) {
+      return entry->reloaded;
+    }
+  }
+
+  return entry->pipeline.get();
+}
+
+void PipelineWarmup::Reload(const fs::path &spirv_path) {
+  vector<Entry *> started;
+  {
+    lock_guard<mutex> lock(entries_mutex);
+    for (unique_ptr<Entry> &entry : entries) {
+      // others read the file when they are compiled
+      if (entry->started) {
+        started.push_back(entry.get());
+      }
+    }
+  }
+
+  exception_ptr exception;
+  uint32_t reloaded_count = 0;
+
+  for (Entry *entry : started) {
+    try {
+      // builder is not touched by compiling threads after this
+      entry->pipeline.wait();
+
+      Builder builder;
+      {
+        lock_guard<mutex> lock(entries_mutex);
+        builder = entry->builder;
+      }
+
+      bool used = visit(
+          [&](auto &builder) { return builder.UnloadShader(spirv_path); },
+          builder);
+      if (!used) {
+        continue;
+      }
+
+      VkPipeline pipeline = visit(
+          [&](auto &builder) { return builder.Build(*device); }, builder);
+
+      lock_guard<mutex> lock(entries_mutex);
+      VkPipeline previous = GetCurrent(*entry);
+      if (previous != VK_NULL_HANDLE && previous != pipeline) {
+        Retire(previous);
+      }
+
+      entry->builder = builder;
+      entry->reloaded = pipeline;
+      reloaded_count++;
+    } catch (...) {
+      if (!exception) {
+        exception = current_exception();
+      }
+    }
+  }
+
+  DEBUG("{0} pipelines reloaded with {1}", reloaded_count,
+        spirv_path.string());
+
+  if (exception) {
+    rethrow_exception(exception);
+  }
+}
+
+VkPipeline PipelineWarmup::GetCurrent(Entry &entry) {
+  if (entry.reloaded != VK_NULL_HANDLE) {
+    return entry.reloaded;
+  }
+
+  if (entry.pipeline.wait_for(chrono::seconds(0)) != future_status::ready) {
+    return VK_NULL_HANDLE;
+  }
+
+  try {
+    return entry.pipeline.get();
+  } catch (...) {
+    return VK_NULL_HANDLE;
+  }
+}
+
+void PipelineWarmup::Retire(VkPipeline pipeline) {
+  // entries of identical description share pipeline
+  for (RetiredPipeline &retired_pipeline : retired) {
+    if (retired_pipeline.pipeline == pipeline) {
+      return;
+    }
+  }
+
+  retired.push_back({pipeline, false, 0});
+}
+
+void PipelineWarmup::Collect(GpuTimeline &timeline) {
+  lock_guard<mutex> lock(entries_mutex);
+
+  for (auto it = retired.begin(); it != retired.end();) {
+    // renderers record with new handles from this frame on
+    if (!it->has_timeline_value) {
+      it->has_timeline_value = true;
+      it->timeline_value = timeline.GetSubmittedValue();
+    }
+
+    if (!timeline.IsComplete(it->timeline_value)) {
+      it++;
+      continue;
+    }
+
+    // description of shader module stage can match old code of file
+    bool used = false;
+    for (unique_ptr<Entry> &entry : entries) {
+      used = used || GetCurrent(*entry) == it->pipeline;
+    }
+
+    if (!used) {
+      device->GetPipelineCache().DestroyPipeline(it->pipeline);
+    }
+
+    it = retired.erase(it);
+  }
+}
+
+void PipelineWarmup::WaitIdle() {
+  if (compile_thread.joinable()) {
+    compile_thread.join();
+  }
+}
+
+} // namespace vk
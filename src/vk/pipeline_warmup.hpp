@@ -0,0 +1,99 @@
+#pragma once
+#include "compute_pipeline_builder.hpp"
+#include "device.hpp"
+#include "gpu_timeline.hpp"
+#include "graphics_pipeline_builder.hpp"
+#include "job_system.hpp"
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <variant>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+using namespace std;
+
+namespace vk {
+
+struct PipelineWarmupCreateInfo {
+  // compiling threads, 0 uses every hardware thread
+  uint32_t thread_count = 0;
+};
+
+typedef uint32_t PipelineTicket;
+
+// renderers add their pipeline descriptions while they are created, Start
+// then reads shaders and compiles all of them on a thread pool in background,
+// every renderer waits only for pipelines it records with
+class PipelineWarmup {
+private:
+  typedef variant<GraphicsPipelineBuilder, ComputePipelineBuilder> Builder;
+
+  struct Entry {
+    Builder builder;
+    promise<VkPipeline> pipeline_promise;
+    shared_future<VkPipeline> pipeline;
+    bool started;
+    // replaces compiled pipeline after its shader changed
+    VkPipeline reloaded;
+  };
+
+  // pipeline replaced by Reload, frames recorded before renderers took new
+  // handle may still execute it
+  struct RetiredPipeline {
+    VkPipeline pipeline;
+    // set by first Collect after Reload, last submit which can use it
+    bool has_timeline_value;
+    uint64_t timeline_value;
+  };
+
+  Device *device;
+  unique_ptr<JobSystem> job_system;
+
+  mutex entries_mutex;
+  // pointers keep entries valid while vector grows during compilation
+  vector<unique_ptr<Entry>> entries;
+  // guarded by entries mutex too
+  vector<RetiredPipeline> retired;
+
+  // runs ParallelFor of job system, so Start returns at once
+  thread compile_thread;
+
+  PipelineTicket Add(Builder builder);
+  void Compile(Entry &entry);
+  // null while entry is compiled or when compilation failed
+  VkPipeline GetCurrent(Entry &entry);
+  void Retire(VkPipeline pipeline);
+
+public:
+  PipelineWarmup(Device &device, PipelineWarmupCreateInfo &create_info);
+  PipelineWarmup(PipelineWarmup &) = delete;
+  PipelineWarmup &operator=(PipelineWarmup &) = delete;
+  ~PipelineWarmup();
+
+  void Destroy();
+
+  PipelineTicket Add(GraphicsPipelineBuilder &builder);
+  PipelineTicket Add(ComputePipelineBuilder &builder);
+  // compiles descriptions added since last Start, waits for previous Start
+  void Start();
+  // blocks until pipeline is compiled, one not started yet is compiled by
+  // calling thread, compilation error is rethrown here
+  VkPipeline Get(PipelineTicket ticket);
+  void WaitIdle();
+
+  // builds pipelines using changed spir-v file again, callers see new
+  // handles from Get and record with them, old ones stay valid for frames
+  // in flight, so no device wait is needed, pipelines which fail keep old
+  // handle and first error is rethrown
+  void Reload(const fs::path &spirv_path);
+  // called by frame loop before renderers record, they must take handles
+  // from Get every frame, destroys pipelines replaced by Reload once
+  // timeline completed frames recorded before that
+  void Collect(GpuTimeline &timeline);
+};
+
+} // namespace vk
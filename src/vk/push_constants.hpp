@@ -0,0 +1,47 @@
+#pragma once
+#include "command_buffer.hpp"
+#include <cstdint>
+#include <type_traits>
+#include <vulkan/vulkan.h>
+
+using namespace std;
+
+namespace vk {
+
+// maxPushConstantsSize of every device is at least this, so ranges checked
+// against it at compile time fit on any of them
+constexpr uint32_t guaranteed_push_constants_size = 128;
+
+// small per draw data, like camera or transform, recorded into command buffer
+// instead of written to uniform buffer and bound with descriptor, T must
+// match std430 layout of push_constant block, several structs of one layout
+// use different offsets
+template <typename T, uint32_t offset = 0> class PushConstants {
+private:
+  static_assert(is_trivially_copyable_v<T>,
+                "push constants are copied byte by byte");
+  static_assert(offset % 4 == 0 && sizeof(T) % 4 == 0,
+                "push constant range must be aligned to 4 bytes");
+  static_assert(offset + sizeof(T) <= guaranteed_push_constants_size,
+                "push constants do not fit guaranteed size");
+
+public:
+  // for pipeline layout creation
+  static VkPushConstantRange GetRange(VkShaderStageFlags stages) {
+    VkPushConstantRange range;
+    range.stageFlags = stages;
+    range.offset = offset;
+    range.size = sizeof(T);
+
+    return range;
+  }
+
+  // stages must be same as in range of layout
+  static void Push(CommandBuffer &command_buffer, VkPipelineLayout layout,
+                   VkShaderStageFlags stages, const T &data) {
+    vkCmdPushConstants(command_buffer.GetHandle(), layout, stages, offset,
+                       sizeof(T), &data);
+  }
+};
+
+} // namespace vk
@@ -0,0 +1,615 @@
+#include "render_graph.hpp"
+#include "memory_manager.hpp"
+#include <algorithm>
+
+namespace vk {
+
+RenderGraphPass::RenderGraphPass(string name) {
+  this->name = name;
+  side_effects = false;
+}
+
+void RenderGraphPass::AddAccess(RenderResource resource,
+                                ResourceAccess access, bool write) {
+  // one resource used twice in a pass gets one merged access
+  for (Access &existing : accesses) {
+    if (existing.resource != resource) {
+      continue;
+    }
+
+    if (existing.access.layout != access.layout) {
+      throw CriticalException("pass " + name +
+                              " uses resource in two layouts");
+    }
+
+    existing.access.stage |= access.stage;
+    existing.access.access |= access.access;
+    existing.write |= write;
+    return;
+  }
+
+  accesses.push_back({resource, access, write});
+}
+
+RenderGraphPass &RenderGraphPass::Read(RenderResource resource,
+                                       ResourceAccess access) {
+  AddAccess(resource, access, false);
+  return *this;
+}
+
+RenderGraphPass &RenderGraphPass::Write(RenderResource resource,
+                                        ResourceAccess access) {
+  AddAccess(resource, access, true);
+  return *this;
+}
+
+RenderGraphPass &
+RenderGraphPass::Record(function<void(CommandBuffer &)> record) {
+  this->record = record;
+  return *this;
+}
+
+RenderGraphPass &RenderGraphPass::SetSideEffects() {
+  side_effects = true;
+  return *this;
+}
+
+RenderGraph::RenderGraph(Device &device) {
+  this->device = &device;
+  compiled = false;
+  transient_memory = nullptr;
+
+  TRACE("render graph created");
+}
+
+RenderGraph::~RenderGraph() { Destroy(); }
+
+void RenderGraph::Destroy() {
+  for (Resource &resource : resources) {
+    resource.transient_image.reset();
+  }
+
+  FreeTransientMemory();
+  slots.clear();
+  resources.clear();
+  passes.clear();
+  order.clear();
+  compiled = false;
+}
+
+RenderResource RenderGraph::AddResource(string name, bool is_image,
+                                        bool imported) {
+  Resource resource;
+  resource.name = name;
+  resource.is_image = is_image;
+  resource.imported = imported;
+  resource.image = nullptr;
+  resource.image_handle = VK_NULL_HANDLE;
+  resource.subresource_range = image_subresource_range_template;
+  resource.subresource_range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  resource.buffer = nullptr;
+  resource.has_final_access = false;
+  resource.slot = 0;
+  resource.first_pass = UINT32_MAX;
+  resource.last_pass = 0;
+
+  resources.push_back(move(resource));
+  compiled = false;
+
+  return resources.size() - 1;
+}
+
+RenderResource RenderGraph::ImportImage(string name, Image &image) {
+  RenderResource handle = AddResource(name, true, true);
+
+  Resource &resource = resources[handle];
+  resource.image = &image;
+  resource.image_handle = image.GetHandle();
+  resource.subresource_range = image.GetSubresourceRange();
+  resource.state.layout = image.GetLayout();
+
+  return handle;
+}
+
+RenderResource
+RenderGraph::ImportImage(string name,
+                         VkImageSubresourceRange subresource_range) {
+  RenderResource handle = AddResource(name, true, true);
+  resources[handle].subresource_range = subresource_range;
+
+  return handle;
+}
+
+RenderResource RenderGraph::ImportBuffer(string name, Buffer &buffer) {
+  RenderResource handle = AddResource(name, false, true);
+  resources[handle].buffer = &buffer;
+
+  return handle;
+}
+
+RenderResource RenderGraph::CreateImage(string name,
+                                        TransientImageInfo &info) {
+  RenderResource handle = AddResource(name, true, false);
+  resources[handle].transient_info = info;
+
+  return handle;
+}
+
+void RenderGraph::SetImportedImage(RenderResource resource, VkImage handle,
+                                   ResourceAccess current_access) {
+  Resource &imported = resources[resource];
+  imported.image_handle = handle;
+
+  // everything before current access is synchronized by caller, like by
+  // acquire semaphore wait
+  imported.state = ResourceState();
+  imported.state.write_stages = current_access.stage;
+  imported.state.write_access = current_access.access;
+  imported.state.layout = current_access.layout;
+}
+
+void RenderGraph::SetFinalAccess(RenderResource resource,
+                                 ResourceAccess access) {
+  resources[resource].has_final_access = true;
+  resources[resource].final_access = access;
+}
+
+RenderGraphPass &RenderGraph::AddPass(string name) {
+  passes.push_back(make_unique<RenderGraphPass>(name));
+  compiled = false;
+
+  return *passes.back();
+}
+
+void RenderGraph::Compile() {
+  vector<bool> needed(passes.size(), false);
+
+  CullPasses(needed);
+  OrderPasses(needed);
+  CreateTransientImages();
+  AliasTransientImages();
+
+  statistics.pass_count = order.size();
+  statistics.culled_pass_count = passes.size() - order.size();
+  compiled = true;
+
+  DEBUG("render graph compiled, {0} passes, {1} culled",
+        statistics.pass_count, statistics.culled_pass_count);
+}
+
+void RenderGraph::CullPasses(vector<bool> &needed) {
+  for (uint32_t i = 0; i < passes.size(); i++) {
+    needed[i] = passes[i]->side_effects;
+
+    for (RenderGraphPass::Access &access : passes[i]->accesses) {
+      if (access.write && resources[access.resource].imported) {
+        needed[i] = true;
+      }
+    }
+  }
+
+  // needed pass keeps every earlier writer of what it reads
+  for (int i = passes.size() - 1; i >= 0; i--) {
+    if (!needed[i]) {
+      continue;
+    }
+
+    for (RenderGraphPass::Access &access : passes[i]->accesses) {
+      bool reads = !access.write || access.access.access & ~write_access_mask;
+      if (!reads) {
+        continue;
+      }
+
+      for (int j = 0; j < i; j++) {
+        for (RenderGraphPass::Access &earlier : passes[j]->accesses) {
+          if (earlier.resource == access.resource && earlier.write) {
+            needed[j] = true;
+          }
+        }
+      }
+    }
+  }
+
+  for (uint32_t i = 0; i < passes.size(); i++) {
+    if (!needed[i]) {
+      DEBUG("render graph pass {0} culled", passes[i]->name);
+    }
+  }
+}
+
+void RenderGraph::OrderPasses(vector<bool> &needed) {
+  vector<vector<uint32_t>> dependents(passes.size());
+  vector<uint32_t> dependency_counts(passes.size(), 0);
+
+  vector<int> last_writers(resources.size(), -1);
+  vector<vector<uint32_t>> readers(resources.size());
+
+  auto add_dependency = [&](uint32_t from, uint32_t to) {
+    dependents[from].push_back(to);
+    dependency_counts[to]++;
+  };
+
+  for (uint32_t i = 0; i < passes.size(); i++) {
+    if (!needed[i]) {
+      continue;
+    }
+
+    for (RenderGraphPass::Access &access : passes[i]->accesses) {
+      RenderResource resource = access.resource;
+
+      if (last_writers[resource] >= 0) {
+        add_dependency(last_writers[resource], i);
+      }
+
+      if (!access.write) {
+        readers[resource].push_back(i);
+        continue;
+      }
+
+      for (uint32_t reader : readers[resource]) {
+        add_dependency(reader, i);
+      }
+      readers[resource].clear();
+      last_writers[resource] = i;
+    }
+  }
+
+  vector<uint32_t> ready;
+  for (uint32_t i = 0; i < passes.size(); i++) {
+    if (needed[i] && dependency_counts[i] == 0) {
+      ready.push_back(i);
+    }
+  }
+
+  order.clear();
+  int last_pass = -1;
+
+  while (!ready.empty()) {
+    // passes independent of the one just scheduled go first, so barrier is
+    // further from its producer and gpu can overlap them
+    auto depends_on_last = [&](uint32_t pass) {
+      return last_pass >= 0 &&
+             find(dependents[last_pass].begin(), dependents[last_pass].end(),
+                  pass) != dependents[last_pass].end();
+    };
+
+    auto best = min_element(ready.begin(), ready.end(),
+                            [&](uint32_t a, uint32_t b) {
+                              bool a_depends = depends_on_last(a);
+                              bool b_depends = depends_on_last(b);
+                              if (a_depends != b_depends) {
+                                return b_depends;
+                              }
+                              return a < b;
+                            });
+
+    uint32_t pass = *best;
+    ready.erase(best);
+    order.push_back(pass);
+    last_pass = pass;
+
+    for (uint32_t dependent : dependents[pass]) {
+      if (--dependency_counts[dependent] == 0) {
+        ready.push_back(dependent);
+      }
+    }
+  }
+
+  for (Resource &resource : resources) {
+    resource.first_pass = UINT32_MAX;
+    resource.last_pass = 0;
+  }
+
+  for (uint32_t i = 0; i < order.size(); i++) {
+    for (RenderGraphPass::Access &access : passes[order[i]]->accesses) {
+      Resource &resource = resources[access.resource];
+      resource.first_pass = min(resource.first_pass, i);
+      resource.last_pass = max(resource.last_pass, i);
+    }
+  }
+}
+
+void RenderGraph::CreateTransientImages() {
+  // gpu must be done with previous transients before recompilation
+  for (Resource &resource : resources) {
+    resource.transient_image.reset();
+  }
+  FreeTransientMemory();
+
+  for (Resource &resource : resources) {
+    if (resource.imported || resource.first_pass == UINT32_MAX) {
+      continue;
+    }
+
+    ImageCreateInfo create_info;
+    create_info.size = resource.transient_info.size;
+    create_info.format = resource.transient_info.format;
+    create_info.usage = resource.transient_info.usage;
+    create_info.memory_category = MemoryCategory::render_targets;
+    create_info.bind_memory = false;
+
+    resource.transient_image = make_unique<Image>(device, create_info);
+    resource.image = resource.transient_image.get();
+    resource.image_handle = resource.image->GetHandle();
+    resource.subresource_range = resource.image->GetSubresourceRange();
+  }
+}
+
+void RenderGraph::AliasTransientImages() {
+  vector<RenderResource> transients;
+  for (RenderResource i = 0; i < resources.size(); i++) {
+    if (resources[i].transient_image) {
+      transients.push_back(i);
+    }
+  }
+
+  slots.clear();
+  statistics.transient_size = 0;
+  statistics.aliased_size = 0;
+
+  if (transients.empty()) {
+    return;
+  }
+
+  // biggest first, so later images fit in slots they share
+  sort(transients.begin(), transients.end(),
+       [&](RenderResource a, RenderResource b) {
+         return resources[a].image->GetMemoryRequirements().size >
+                resources[b].image->GetMemoryRequirements().size;
+       });
+
+  for (RenderResource handle : transients) {
+    Resource &resource = resources[handle];
+    VkMemoryRequirements requirements =
+        resource.image->GetMemoryRequirements();
+    statistics.transient_size += requirements.size;
+
+    auto overlaps = [&](RenderResource other) {
+      return resource.first_pass <= resources[other].last_pass &&
+             resources[other].first_pass <= resource.last_pass;
+    };
+
+    uint32_t slot_index = slots.size();
+    for (uint32_t i = 0; i < slots.size(); i++) {
+      AliasSlot &slot = slots[i];
+      if (slot.size < requirements.size ||
+          !(slot.memory_types & requirements.memoryTypeBits) ||
+          any_of(slot.resources.begin(), slot.resources.end(), overlaps)) {
+        continue;
+      }
+
+      slot_index = i;
+      break;
+    }
+
+    if (slot_index == slots.size()) {
+      AliasSlot slot;
+      slot.offset = 0;
+      slot.size = requirements.size;
+      slot.alignment = requirements.alignment;
+      slot.memory_types = requirements.memoryTypeBits;
+      slots.push_back(slot);
+    }
+
+    AliasSlot &slot = slots[slot_index];
+    slot.alignment = max(slot.alignment, requirements.alignment);
+    slot.memory_types &= requirements.memoryTypeBits;
+    slot.resources.push_back(handle);
+    resource.slot = slot_index;
+  }
+
+  VkDeviceSize memory_size = 0;
+  uint32_t memory_types = UINT32_MAX;
+  for (AliasSlot &slot : slots) {
+    slot.offset = tools::align_up(memory_size, slot.alignment);
+    memory_size = slot.offset + slot.size;
+    memory_types &= slot.memory_types;
+  }
+
+  if (memory_types == 0) {
+    throw CriticalException("transient images have no common memory type");
+  }
+
+  transient_memory = device->GetMemoryManager().AllocateMemory(
+      memory_size, memory_types, MemoryUsage::gpu_only,
+      MemoryCategory::render_targets);
+
+  for (RenderResource handle : transients) {
+    Resource &resource = resources[handle];
+
+    VkResult result = vkBindImageMemory(
+        device->GetHandle(), resource.image_handle,
+        transient_memory->GetHandle(), slots[resource.slot].offset);
+    if (result) {
+      throw CriticalException("cant bind transient image " + resource.name);
+    }
+  }
+
+  statistics.aliased_size = memory_size;
+
+  DEBUG("{0} transient images aliased in {1} slots, {2} of {3} bytes",
+        transients.size(), slots.size(), statistics.aliased_size,
+        statistics.transient_size);
+}
+
+void RenderGraph::FreeTransientMemory() {
+  if (!transient_memory) {
+    return;
+  }
+
+  device->GetMemoryManager().FreeMemory(transient_memory,
+                                        MemoryCategory::render_targets);
+  transient_memory = nullptr;
+}
+
+RenderGraph::ResourceState &RenderGraph::GetState(Resource &resource) {
+  if (resource.imported) {
+    return resource.state;
+  }
+
+  return slots[resource.slot].state;
+}
+
+void RenderGraph::AddBarrier(BarrierBatch &barriers, Resource &resource,
+                             ResourceAccess access, bool write,
+                             bool discard) {
+  ResourceState &state = GetState(resource);
+
+  // transient content is never kept, previous slot user left garbage
+  VkImageLayout old_layout = discard ? VK_IMAGE_LAYOUT_UNDEFINED : state.layout;
+  VkImageLayout new_layout =
+      access.layout == VK_IMAGE_LAYOUT_UNDEFINED ? old_layout : access.layout;
+  bool layout_change = resource.is_image && new_layout != old_layout;
+
+  VkPipelineStageFlags src_stages;
+  VkAccessFlags src_access;
+  bool needs_barrier;
+
+  if (write || layout_change) {
+    // reads before a write need only execution dependency
+    src_stages = state.write_stages | state.read_stages;
+    src_access = state.write_access;
+    needs_barrier = src_stages || layout_change;
+  } else {
+    // reads after a read in the same layout are not synchronized, reads
+    // after a write only when the write is not visible to them yet
+    src_stages = state.write_stages;
+    src_access = state.write_access;
+    needs_barrier =
+        state.write_stages &&
+        ((state.visible_stages & access.stage) != access.stage ||
+         (state.visible_access & access.access) != access.access);
+  }
+
+  if (needs_barrier) {
+    if (resource.is_image) {
+      // defragmenter can move imported image in an earlier pass
+      if (resource.image) {
+        resource.image_handle = resource.image->GetHandle();
+      }
+
+      VkImageMemoryBarrier image_barrier = image_memory_barrier_template;
+      image_barrier.image = resource.image_handle;
+      image_barrier.subresourceRange = resource.subresource_range;
+      image_barrier.srcAccessMask = src_access;
+      image_barrier.dstAccessMask = access.access;
+      image_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+      image_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+      image_barrier.oldLayout = old_layout;
+      image_barrier.newLayout = new_layout;
+
+      barriers.Add(src_stages, access.stage, image_barrier);
+    } else {
+      VkBufferMemoryBarrier buffer_barrier = buffer_barrier_template;
+      buffer_barrier.buffer = resource.buffer->GetHandle();
+      buffer_barrier.srcAccessMask = src_access;
+      buffer_barrier.dstAccessMask = access.access;
+
+      barriers.Add(src_stages, access.stage, buffer_barrier);
+    }
+  }
+
+  if (write) {
+    state.write_stages = access.stage;
+    state.write_access = access.access & write_access_mask;
+    state.read_stages = 0;
+    state.visible_stages = 0;
+    state.visible_access = 0;
+  } else if (layout_change) {
+    // transition is a write this read already waited for
+    state.write_stages = access.stage;
+    state.write_access = 0;
+    state.read_stages = access.stage;
+    state.visible_stages = access.stage;
+    state.visible_access = access.access;
+  } else {
+    state.read_stages |= access.stage;
+    if (needs_barrier) {
+      state.visible_stages |= access.stage;
+      state.visible_access |= access.access;
+    }
+  }
+
+  state.layout = new_layout;
+}
+
+void RenderGraph::SetBarriers(CommandBuffer &command_buffer,
+                              BarrierBatch &barriers) {
+  if (barriers.IsEmpty()) {
+    return;
+  }
+
+  statistics.barrier_count += barriers.GetSize();
+  statistics.barrier_batch_count++;
+
+  // src stages of layout transition of unused resource stay empty, batch
+  // waits for nothing then
+  barriers.Flush(command_buffer);
+}
+
+void RenderGraph::Execute(CommandBuffer &command_buffer) {
+  if (!compiled) {
+    throw CriticalException("render graph is not compiled");
+  }
+
+  statistics.barrier_count = 0;
+  statistics.barrier_batch_count = 0;
+
+  // layouts of imported images could be changed outside of graph
+  for (Resource &resource : resources) {
+    if (resource.imported && resource.image) {
+      resource.state.layout = resource.image->GetLayout();
+    }
+  }
+
+  for (uint32_t i = 0; i < order.size(); i++) {
+    RenderGraphPass &pass = *passes[order[i]];
+
+    BarrierBatch barriers(*device);
+    for (RenderGraphPass::Access &access : pass.accesses) {
+      Resource &resource = resources[access.resource];
+      bool discard = !resource.imported && resource.first_pass == i;
+
+      AddBarrier(barriers, resource, access.access, access.write, discard);
+    }
+    SetBarriers(command_buffer, barriers);
+
+    if (pass.record) {
+      pass.record(command_buffer);
+    }
+  }
+
+  BarrierBatch final_barriers(*device);
+  for (Resource &resource : resources) {
+    if (resource.imported && resource.has_final_access) {
+      AddBarrier(final_barriers, resource, resource.final_access, false,
+                 false);
+    }
+  }
+  SetBarriers(command_buffer, final_barriers);
+
+  for (Resource &resource : resources) {
+    if (resource.imported && resource.image) {
+      resource.image->ChangeLayout(resource.state.layout);
+    }
+  }
+
+  TRACE("render graph executed {0} passes with {1} barriers in {2} batches",
+        order.size(), statistics.barrier_count,
+        statistics.barrier_batch_count);
+}
+
+Image &RenderGraph::GetImage(RenderResource resource) {
+  if (!resources[resource].image) {
+    throw CriticalException("render graph resource " +
+                            resources[resource].name + " is not an image");
+  }
+
+  return *resources[resource].image;
+}
+
+const RenderGraphStatistics &RenderGraph::GetStatistics() {
+  return statistics;
+}
+
+} // namespace vk
@@ -0,0 +1,220 @@
+#pragma once
+#include "barrier_batch.hpp"
+#include "buffer.hpp"
+#include "command_buffer.hpp"
+#include "device.hpp"
+#include "device_memory.hpp"
+#include "image.hpp"
+#include "memory_manager.hpp"
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+using namespace std;
+
+namespace vk {
+
+typedef uint32_t RenderResource;
+
+// how a pass touches a resource, layout is ignored for buffers
+struct ResourceAccess {
+  VkPipelineStageFlags stage;
+  VkAccessFlags access;
+  VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+};
+
+constexpr ResourceAccess color_attachment_access = {
+    VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+    VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+    VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+// attachment loaded and drawn over, like ui over rendered scene
+constexpr ResourceAccess color_attachment_load_access = {
+    VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+    VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+    VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+constexpr ResourceAccess fragment_sampled_access = {
+    VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT,
+    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+constexpr ResourceAccess compute_storage_read_access = {
+    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT,
+    VK_IMAGE_LAYOUT_GENERAL};
+constexpr ResourceAccess compute_storage_write_access = {
+    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+    VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+    VK_IMAGE_LAYOUT_GENERAL};
+constexpr ResourceAccess vertex_buffer_access = {
+    VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT};
+constexpr ResourceAccess transfer_write_access = {
+    VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL};
+// swapchain image right after acquire semaphore wait
+constexpr ResourceAccess acquired_access = {
+    VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0,
+    VK_IMAGE_LAYOUT_UNDEFINED};
+constexpr ResourceAccess present_access = {
+    VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR};
+
+struct TransientImageInfo {
+  glm::ivec2 size;
+  VkFormat format;
+  VkImageUsageFlags usage;
+};
+
+struct RenderGraphStatistics {
+  uint32_t pass_count = 0;
+  uint32_t culled_pass_count = 0;
+  // image and buffer barriers of last frame
+  uint32_t barrier_count = 0;
+  // pipeline barrier calls they were merged into
+  uint32_t barrier_batch_count = 0;
+  VkDeviceSize transient_size = 0;
+  VkDeviceSize aliased_size = 0;
+};
+
+class RenderGraph;
+
+class RenderGraphPass {
+private:
+  struct Access {
+    RenderResource resource;
+    ResourceAccess access;
+    bool write;
+  };
+
+  string name;
+  vector<Access> accesses;
+  function<void(CommandBuffer &)> record;
+  bool side_effects;
+
+  void AddAccess(RenderResource resource, ResourceAccess access, bool write);
+
+public:
+  RenderGraphPass(string name);
+
+  RenderGraphPass &Read(RenderResource resource, ResourceAccess access);
+  RenderGraphPass &Write(RenderResource resource, ResourceAccess access);
+  RenderGraphPass &Record(function<void(CommandBuffer &)> record);
+  // pass is never culled, like one which acquires uploads
+  RenderGraphPass &SetSideEffects();
+
+  friend RenderGraph;
+};
+
+// passes declare what they read and write, graph culls passes whose results
+// are unused, orders the rest, derives merged barriers and layouts between
+// them and places transient images with disjoint lifetimes in same memory
+class RenderGraph {
+private:
+  struct ResourceState {
+    VkPipelineStageFlags write_stages = 0;
+    VkAccessFlags write_access = 0;
+    // stages which read since last write, next write waits for them
+    VkPipelineStageFlags read_stages = 0;
+    // last write is already visible to these
+    VkPipelineStageFlags visible_stages = 0;
+    VkAccessFlags visible_access = 0;
+    VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+  };
+
+  struct Resource {
+    string name;
+    bool is_image;
+    bool imported;
+
+    Image *image;
+    unique_ptr<Image> transient_image;
+    TransientImageInfo transient_info;
+    VkImage image_handle;
+    VkImageSubresourceRange subresource_range;
+    Buffer *buffer;
+
+    // imported resources keep state between frames, transients use state
+    // of their alias slot
+    ResourceState state;
+    bool has_final_access;
+    ResourceAccess final_access;
+
+    uint32_t slot;
+    uint32_t first_pass;
+    uint32_t last_pass;
+  };
+
+  // memory range shared by transient images which never live at once
+  struct AliasSlot {
+    VkDeviceSize offset;
+    VkDeviceSize size;
+    VkDeviceSize alignment;
+    uint32_t memory_types;
+    vector<RenderResource> resources;
+    ResourceState state;
+  };
+
+  static constexpr VkAccessFlags write_access_mask =
+      VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+      VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+      VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_HOST_WRITE_BIT |
+      VK_ACCESS_MEMORY_WRITE_BIT;
+
+  Device *device;
+
+  vector<Resource> resources;
+  // pointers keep passes returned by AddPass valid
+  vector<unique_ptr<RenderGraphPass>> passes;
+
+  vector<uint32_t> order;
+  bool compiled;
+
+  vector<AliasSlot> slots;
+  // allocated from memory manager, so it counts in heap budget
+  DeviceMemory *transient_memory;
+
+  RenderGraphStatistics statistics;
+
+  RenderResource AddResource(string name, bool is_image, bool imported);
+
+  void CullPasses(vector<bool> &needed);
+  void OrderPasses(vector<bool> &needed);
+  void CreateTransientImages();
+  void AliasTransientImages();
+  void FreeTransientMemory();
+
+  ResourceState &GetState(Resource &resource);
+  void AddBarrier(BarrierBatch &barriers, Resource &resource,
+                  ResourceAccess access, bool write, bool discard);
+  void SetBarriers(CommandBuffer &command_buffer, BarrierBatch &barriers);
+
+public:
+  RenderGraph(Device &device);
+  RenderGraph(RenderGraph &) = delete;
+  RenderGraph &operator=(RenderGraph &) = delete;
+  ~RenderGraph();
+
+  void Destroy();
+
+  // image state is tracked between frames and its layout kept in sync
+  RenderResource ImportImage(string name, Image &image);
+  // image not owned by graph, like swapchain one, it is set every frame
+  RenderResource ImportImage(string name,
+                             VkImageSubresourceRange subresource_range);
+  RenderResource ImportBuffer(string name, Buffer &buffer);
+  // created by Compile and placed in memory shared with other transients
+  RenderResource CreateImage(string name, TransientImageInfo &info);
+
+  void SetImportedImage(RenderResource resource, VkImage handle,
+                        ResourceAccess current_access);
+  // state imported resource must be left in after last pass
+  void SetFinalAccess(RenderResource resource, ResourceAccess access);
+
+  RenderGraphPass &AddPass(string name);
+
+  // must be called after passes change, before Execute
+  void Compile();
+  void Execute(CommandBuffer &command_buffer);
+
+  Image &GetImage(RenderResource resource);
+  const RenderGraphStatistics &GetStatistics();
+};
+
+} // namespace vk
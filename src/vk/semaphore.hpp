@@ -7,6 +7,8 @@ using namespace std;
 
 namespace vk {
 
+// binary semaphore for swapchain acquire and present, which do not work
+// with timelines, queue ordering goes through GpuTimeline
 class Semaphore {
 private:
   VkSemaphore handle;
@@ -2,10 +2,14 @@
 
 namespace vk {
 
-ShaderModule::ShaderModule(Device &device, fs::path filepath) {
-  this->device = &device;
+ShaderModule::ShaderModule(Device &device, fs::path filepath)
+    : ShaderModule(device, ReadFile(filepath)) {
+  TRACE("shader module from {0} file created", filepath.string());
+}
 
-  vector<char> code = ReadFile(filepath);
+ShaderModule::ShaderModule(Device &device, const vector<char> &code) {
+  this->device = &device;
+  this->code = code;
 
   VkShaderModuleCreateInfo create_info = shader_module_create_info_template;
   create_info.codeSize = code.size();
@@ -16,8 +20,6 @@ ShaderModule::ShaderModule(Device &device, fs::path filepath) {
   if (result) {
     throw CriticalException("cant create shader module");
   }
-
-  TRACE("shader module from {0} file created", filepath.string());
 }
 
 ShaderModule::~ShaderModule() {
@@ -28,6 +30,8 @@ ShaderModule::~ShaderModule() {
 
 VkShaderModule ShaderModule::GetHandle() { return handle; }
 
+const vector<char> &ShaderModule::GetCode() { return code; }
+
 vector<char> ShaderModule::ReadFile(fs::path filepath) {
   ifstream file(filepath, ios::binary);
 
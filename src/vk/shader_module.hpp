@@ -14,15 +14,21 @@ class ShaderModule {
 private:
   VkShaderModule handle;
   Device* device;
-  
-  vector<char> ReadFile(fs::path filepath);
+  // identifies module in pipeline descriptions, handles can be reused
+  vector<char> code;
+
 public:
   ShaderModule(Device& device, fs::path filepath);
+  // code read before, like by pipeline warmup threads
+  ShaderModule(Device& device, const vector<char> &code);
   ShaderModule(ShaderModule &) = delete;
   ShaderModule &operator=(ShaderModule &) = delete;
   ~ShaderModule();
 
   VkShaderModule GetHandle();
+  const vector<char> &GetCode();
+
+  static vector<char> ReadFile(fs::path filepath);
 };
 
 } // namespace vk
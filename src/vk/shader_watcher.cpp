@@ -0,0 +1,193 @@
+#include "shader_watcher.hpp"
+#include <array>
+#include <cstdio>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+namespace vk {
+
+ShaderWatcher::ShaderWatcher(ShaderWatcherCreateInfo &create_info) {
+  directory = create_info.directory;
+  compiler = create_info.compiler;
+  reload = create_info.reload;
+  stopping = false;
+  reload_count = 0;
+
+  inotify_handle = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (inotify_handle < 0) {
+    throw CriticalException("cant init inotify");
+  }
+
+  // editors often save by rename, which is only a move into directory
+  int watch = inotify_add_watch(inotify_handle, directory.c_str(),
+                                IN_CLOSE_WRITE | IN_MOVED_TO);
+  if (watch < 0) {
+    close(inotify_handle);
+    inotify_handle = -1;
+    throw CriticalException("cant watch \"" + directory.string() + "\"");
+  }
+
+  watch_thread = thread(&ShaderWatcher::WatchLoop, this);
+
+  DEBUG("shader watcher of \"{0}\" created", directory.string());
+}
+
+ShaderWatcher::~ShaderWatcher() {
+  if (inotify_handle < 0) {
+    return;
+  }
+
+  Destroy();
+}
+
+void ShaderWatcher::Destroy() {
+  stopping = true;
+  watch_thread.join();
+
+  close(inotify_handle);
+  inotify_handle = -1;
+
+  TRACE("shader watcher destroyed");
+}
+
+void ShaderWatcher::WatchLoop() {
+  while (!stopping) {
+    pollfd poll_info = {inotify_handle, POLLIN, 0};
+    if (poll(&poll_info, 1, poll_timeout) <= 0) {
+      continue;
+    }
+
+    // one save can produce several events, each source is compiled once
+    for (const fs::path &source : ReadEvents()) {
+      Reload(source);
+    }
+  }
+}
+
+set<fs::path> ShaderWatcher::ReadEvents() {
+  set<fs::path> sources;
+
+  alignas(inotify_event) array<char, 4096> buffer;
+  while (true) {
+    ssize_t size = read(inotify_handle, buffer.data(), buffer.size());
+    if (size <= 0) {
+      break;
+    }
+
+    for (ssize_t offset = 0; offset < size;) {
+      inotify_event *event = (inotify_event *)(buffer.data() + offset);
+      offset += sizeof(inotify_event) + event->len;
+
+      if (event->len == 0) {
+        continue;
+      }
+
+      fs::path filepath = directory / event->name;
+      if (IsShaderSource(filepath)) {
+        sources.insert(filepath);
+      }
+    }
+  }
+
+  return sources;
+}
+
+void ShaderWatcher::Reload(const fs::path &source) {
+  fs::path spirv_path = GetSpirvPath(source);
+
+  string error = Compile(source, spirv_path);
+
+  if (error.empty() && reload) {
+    try {
+      reload(spirv_path);
+    } catch (IException &exception) {
+      error = (string)exception;
+    } catch (std::exception &e) {
+      // like filesystem errors of rebuild, they must not end watcher thread
+      error = e.what();
+    }
+  }
+
+  lock_guard<mutex> lock(errors_mutex);
+
+  if (!error.empty()) {
+    errors[source] = error;
+    WARN("shader {0} not reloaded: {1}", source.string(), error);
+    return;
+  }
+
+  errors.erase(source);
+  reload_count++;
+
+  INFO("shader {0} reloaded", source.string());
+}
+
+string ShaderWatcher::Compile(const fs::path &source,
+                              const fs::path &spirv_path) {
+  // readers never see half written file
+  fs::path temporary_path = spirv_path;
+  temporary_path += ".tmp";
+
+  string command = compiler + " \"" + source.string() + "\" -o \"" +
+                   temporary_path.string() + "\" 2>&1";
+
+  FILE *process = popen(command.c_str(), "r");
+  if (process == nullptr) {
+    return "cant run " + compiler;
+  }
+
+  string output;
+  array<char, 256> buffer;
+  while (fgets(buffer.data(), buffer.size(), process) != nullptr) {
+    output += buffer.data();
+  }
+
+  int status = pclose(process);
+  if (status != 0) {
+    if (output.empty()) {
+      output = compiler + " failed with status " + to_string(status);
+    }
+
+    error_code error;
+    fs::remove(temporary_path, error);
+    return output;
+  }
+
+  error_code error;
+  fs::rename(temporary_path, spirv_path, error);
+  if (error) {
+    return "cant replace " + spirv_path.string() + ": " + error.message();
+  }
+
+  return "";
+}
+
+vector<ShaderError> ShaderWatcher::GetErrors() {
+  lock_guard<mutex> lock(errors_mutex);
+
+  vector<ShaderError> result;
+  for (auto &[source, message] : errors) {
+    result.push_back({source, message});
+  }
+
+  return result;
+}
+
+uint32_t ShaderWatcher::GetReloadCount() { return reload_count; }
+
+fs::path ShaderWatcher::GetSpirvPath(const fs::path &source) {
+  string stage = source.extension().string().substr(1);
+
+  return source.parent_path() /
+         (source.stem().string() + "_" + stage + ".spv");
+}
+
+bool ShaderWatcher::IsShaderSource(const fs::path &filepath) {
+  static const set<string> extensions = {".vert", ".frag", ".comp",
+                                         ".geom", ".tesc", ".tese"};
+
+  return extensions.count(filepath.extension().string()) != 0;
+}
+
+} // namespace vk
@@ -0,0 +1,73 @@
+#pragma once
+#include "exception.hpp"
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+namespace fs = filesystem;
+
+namespace vk {
+
+struct ShaderWatcherCreateInfo {
+  // glsl sources and spir-v next to them, like build.sh writes it
+  fs::path directory = "shaders";
+  string compiler = "glslc";
+  // called on watcher thread after spir-v file was replaced, exception
+  // keeps error of the source until its next successful reload
+  function<void(const fs::path &spirv_path)> reload;
+};
+
+struct ShaderError {
+  fs::path source;
+  string message;
+};
+
+// watches glsl sources with inotify and compiles changed ones in background,
+// failed compile leaves previous spir-v file, so pipelines keep old code
+class ShaderWatcher {
+private:
+  fs::path directory;
+  string compiler;
+  function<void(const fs::path &)> reload;
+
+  int inotify_handle;
+  thread watch_thread;
+  atomic<bool> stopping;
+
+  mutex errors_mutex;
+  map<fs::path, string> errors;
+  atomic<uint32_t> reload_count;
+
+  static constexpr int poll_timeout = 100; // in milliseconds
+
+  void WatchLoop();
+  set<fs::path> ReadEvents();
+  void Reload(const fs::path &source);
+  // returns compiler output, empty on success
+  string Compile(const fs::path &source, const fs::path &spirv_path);
+
+public:
+  ShaderWatcher(ShaderWatcherCreateInfo &create_info);
+  ShaderWatcher(ShaderWatcher &) = delete;
+  ShaderWatcher &operator=(ShaderWatcher &) = delete;
+  ~ShaderWatcher();
+
+  void Destroy();
+
+  vector<ShaderError> GetErrors();
+  uint32_t GetReloadCount();
+
+  // texture.frag is compiled to texture_frag.spv
+  static fs::path GetSpirvPath(const fs::path &source);
+  static bool IsShaderSource(const fs::path &filepath);
+};
+
+} // namespace vk
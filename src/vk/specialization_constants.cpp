@@ -0,0 +1,55 @@
+#include "specialization_constants.hpp"
+#include <cstring>
+
+namespace vk {
+
+void SpecializationConstants::SetBytes(uint32_t constant_id, const void *value,
+                                       size_t size) {
+  for (VkSpecializationMapEntry &entry : entries) {
+    if (entry.constantID != constant_id) {
+      continue;
+    }
+
+    if (entry.size != size) {
+      throw CriticalException("specialization constant " +
+                              to_string(constant_id) + " changed its type");
+    }
+
+    memcpy(data.data() + entry.offset, value, size);
+    return;
+  }
+
+  VkSpecializationMapEntry entry;
+  entry.constantID = constant_id;
+  entry.offset = data.size();
+  entry.size = size;
+
+  entries.push_back(entry);
+  data.resize(data.size() + size);
+  memcpy(data.data() + entry.offset, value, size);
+}
+
+bool SpecializationConstants::IsEmpty() { return entries.empty(); }
+
+const VkSpecializationInfo *SpecializationConstants::GetInfo() {
+  if (entries.empty()) {
+    return nullptr;
+  }
+
+  info.mapEntryCount = entries.size();
+  info.pMapEntries = entries.data();
+  info.dataSize = data.size();
+  info.pData = data.data();
+
+  return &info;
+}
+
+void SpecializationConstants::AppendKey(string &key) {
+  uint32_t entry_count = entries.size();
+  key.append((const char *)&entry_count, sizeof(entry_count));
+  key.append((const char *)entries.data(),
+             entries.size() * sizeof(VkSpecializationMapEntry));
+  key.append((const char *)data.data(), data.size());
+}
+
+} // namespace vk
@@ -0,0 +1,64 @@
+#pragma once
+#include "exception.hpp"
+#include "glm/glm.hpp"
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+using namespace std;
+
+namespace vk {
+
+// values of constant_id constants of a shader, they are baked in at pipeline
+// creation, so compiler folds them like literals, unrolls loops over them and
+// drops bounds checks, every set of values is a separate cached pipeline
+class SpecializationConstants {
+private:
+  vector<VkSpecializationMapEntry> entries;
+  vector<uint8_t> data;
+  // points into vectors above, filled by GetInfo so copies stay valid
+  VkSpecializationInfo info;
+
+  void SetBytes(uint32_t constant_id, const void *value, size_t size);
+
+public:
+  // glsl bool is 32 bit, 8 and 16 bit types need extra device features
+  template <typename T>
+  SpecializationConstants &Set(uint32_t constant_id, T value) {
+    static_assert(is_same_v<T, bool> || is_same_v<T, int32_t> ||
+                      is_same_v<T, uint32_t> || is_same_v<T, float> ||
+                      is_same_v<T, int64_t> || is_same_v<T, uint64_t> ||
+                      is_same_v<T, double>,
+                  "type has no matching glsl specialization constant");
+
+    if constexpr (is_same_v<T, bool>) {
+      VkBool32 bool_value = value;
+      SetBytes(constant_id, &bool_value, sizeof(bool_value));
+    } else {
+      SetBytes(constant_id, &value, sizeof(value));
+    }
+
+    return *this;
+  }
+
+  // components take consecutive ids, like map width and height
+  template <glm::length_t L, typename T, glm::qualifier Q>
+  SpecializationConstants &Set(uint32_t first_constant_id,
+                               glm::vec<L, T, Q> value) {
+    for (glm::length_t i = 0; i < L; i++) {
+      Set(first_constant_id + i, value[i]);
+    }
+
+    return *this;
+  }
+
+  bool IsEmpty();
+  // null when no constant is set
+  const VkSpecializationInfo *GetInfo();
+  // ids, sizes and values in order of setting
+  void AppendKey(string &key);
+};
+
+} // namespace vk
@@ -71,7 +71,9 @@ uint32_t Swapchain::AcquireNextImage(VkSemaphore semaphore) {
   VkResult result =
       vkAcquireNextImageKHR(device->GetHandle(), handle, UINT64_MAX, semaphore,
                             VK_NULL_HANDLE, &next_image);
-  if (result) {
+  // suboptimal image is still acquired and its semaphore will be signaled,
+  // so it is presented and surface is changed after that
+  if (result && result != VK_SUBOPTIMAL_KHR) {
     throw AcquireNextImageFailedException();
   }
 
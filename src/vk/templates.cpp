@@ -35,11 +35,40 @@ VkBufferMemoryBarrier buffer_barrier_template = {
     .offset = 0,
     .size = VK_WHOLE_SIZE};
 
+VkMemoryBarrier2KHR memory_barrier2_template = {
+    .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2_KHR, .pNext = nullptr};
+
+VkBufferMemoryBarrier2KHR buffer_barrier2_template = {
+    .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2_KHR,
+    .pNext = nullptr,
+    .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+    .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+    .offset = 0,
+    .size = VK_WHOLE_SIZE};
+
+VkImageMemoryBarrier2KHR image_memory_barrier2_template = {
+    .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2_KHR,
+    .pNext = nullptr,
+    .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+    .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED};
+
+VkDependencyInfoKHR dependency_info_template = {
+    .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO_KHR,
+    .pNext = nullptr,
+    .dependencyFlags = 0};
+
 VkCommandBufferBeginInfo command_buffer_begin_info_template = {
     .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
     .pNext = nullptr,
     .flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT};
 
+VkCommandBufferInheritanceInfo command_buffer_inheritance_info_template = {
+    .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+    .pNext = nullptr,
+    .occlusionQueryEnable = VK_FALSE,
+    .queryFlags = 0,
+    .pipelineStatistics = 0};
+
 VkPresentInfoKHR present_info_template = {
     .sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR, .pNext = nullptr};
 
@@ -71,6 +100,13 @@ VkComputePipelineCreateInfo compute_pipeline_create_info_template = {
     .flags = 0,
 };
 
+VkPipelineCacheCreateInfo pipeline_cache_create_info_template = {
+    .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+    .pNext = nullptr,
+    .flags = 0,
+    .initialDataSize = 0,
+    .pInitialData = nullptr};
+
 VkPipelineShaderStageCreateInfo pipeline_shader_stage_create_info_template = {
     .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
     .pNext = nullptr,
@@ -256,11 +292,21 @@ VkSamplerCreateInfo sampler_create_info_template = {
     .unnormalizedCoordinates = VK_FALSE
     };
 
+VkSemaphoreWaitInfo semaphore_wait_info_template = {
+    .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+    .pNext = nullptr,
+    .flags = 0};
+
+VkSemaphoreTypeCreateInfo semaphore_type_create_info_template = {
+    .sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+    .pNext = nullptr,
+    .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+    .initialValue = 0};
 
-  VkSemaphoreWaitInfo semaphore_wait_info = {
-	.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
-	.pNext = nullptr,
-	.flags = 0,
-  };
+VkTimelineSemaphoreSubmitInfo timeline_semaphore_submit_info_template = {
+    .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+    .pNext = nullptr,
+    .waitSemaphoreValueCount = 0,
+    .signalSemaphoreValueCount = 0};
 
 } // namespace vk
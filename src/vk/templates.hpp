@@ -7,10 +7,12 @@ extern VkDeviceCreateInfo device_create_info_template;
 extern VkDeviceQueueCreateInfo queue_create_info_template;
 extern VkBufferMemoryBarrier buffer_barrier_template;
 extern VkCommandBufferBeginInfo command_buffer_begin_info_template;
+extern VkCommandBufferInheritanceInfo command_buffer_inheritance_info_template;
 extern VkCommandPoolCreateInfo command_pool_create_info_template;
 extern VkSubmitInfo submit_info_template;
 extern VkShaderModuleCreateInfo shader_module_create_info_template;
 extern VkComputePipelineCreateInfo compute_pipeline_create_info_template;
+extern VkPipelineCacheCreateInfo pipeline_cache_create_info_template;
 extern VkPipelineShaderStageCreateInfo
     pipeline_shader_stage_create_info_template;
 extern VkDescriptorSetLayoutCreateInfo
@@ -47,6 +49,10 @@ extern VkRenderPassBeginInfo render_pass_begin_info_template;
 extern VkPresentInfoKHR present_info_template;
 
 extern VkMemoryBarrier memory_barrier_template;
+extern VkMemoryBarrier2KHR memory_barrier2_template;
+extern VkBufferMemoryBarrier2KHR buffer_barrier2_template;
+extern VkImageMemoryBarrier2KHR image_memory_barrier2_template;
+extern VkDependencyInfoKHR dependency_info_template;
 
 extern VkImageSubresourceRange image_subresource_range_template;
 
@@ -55,6 +61,8 @@ extern VkImageCreateInfo image_create_info_template;
 
 extern VkSamplerCreateInfo sampler_create_info_template;
 
-extern VkSemaphoreWaitInfo semaphore_wait_info;
+extern VkSemaphoreWaitInfo semaphore_wait_info_template;
+extern VkSemaphoreTypeCreateInfo semaphore_type_create_info_template;
+extern VkTimelineSemaphoreSubmitInfo timeline_semaphore_submit_info_template;
 
 } // namespace vk
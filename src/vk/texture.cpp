@@ -12,76 +12,43 @@ void Texture::Destroy() {
     image.reset();
     TRACE("texture image destoyed");
   }
-
-  if (memory) {
-    memory->Free();
-    memory.reset();
-
-    TRACE("texture memory destoyed");
-  }
-
 }
-void Texture::LoadImage(char *image_data, glm::ivec2 image_size,
-                        CommandBuffer *command_buffer, Queue graphics_queue) {
-  vk::ImageCreateInfo image_crate_info;
-  image_crate_info.size = image_size;
-  image_crate_info.format = VK_FORMAT_R8G8B8A8_SRGB;
-
-  image = make_unique<vk::Image>(device, image_crate_info);
-
-  vector<vk::MemoryObject *> memory_objects = {image.get()};
-  VkDeviceSize memory_size =
-      vk::DeviceMemory::CalculateMemorySize(memory_objects);
-
-  vk::PhysicalDevice &physical_device = device->GetPhysicalDevice();
-
-  vk::ChooseMemoryTypeInfo choose_info;
-  choose_info.memory_types = image->GetMemoryTypes();
-  choose_info.heap_properties = 0;
-  choose_info.properties = 0;
 
-  uint32_t memory_type = physical_device.ChooseMemoryType(choose_info);
-
-  memory = make_unique<vk::DeviceMemory>(*device, memory_size, memory_type);
-
-  memory->BindImage(*image);
-
-  // load data to image
+UploadToken Texture::LoadImage(char *image_data, glm::ivec2 image_size,
+                               UploadManager &upload_manager) {
   int image_size_in_bytes = image_size.x * image_size.y * 4;
 
-  vk::StagingBufferCreateInfo staging_buffer_create_info;
-  staging_buffer_create_info.command_buffer = command_buffer;
-  staging_buffer_create_info.queue = graphics_queue;
-  staging_buffer_create_info.size = image_size_in_bytes;
-
-  unique_ptr<vk::StagingBuffer> staging_buffer =
-      make_unique<vk::StagingBuffer>(*device, staging_buffer_create_info);
-
-  command_buffer->Begin();
+  TextureData data;
+  data.format = VK_FORMAT_R8G8B8A8_SRGB;
+  data.size = image_size;
+  data.levels.push_back(span<const char>(image_data, image_size_in_bytes));
 
-  staging_buffer->LoadData(span<char>(image_data, image_size_in_bytes));
+  return Load(data, upload_manager);
+}
 
-  vk::SrcImageBarrier src_barrier;
+UploadToken Texture::Load(TextureData &data, UploadManager &upload_manager) {
+  vk::ImageCreateInfo image_crate_info;
+  image_crate_info.size = data.size;
+  image_crate_info.format = data.format;
+  image_crate_info.mip_levels = data.mip_levels;
 
-  vk::SrcImageBarrier afterload_src_barrier =
-      staging_buffer->CopyToImage(image.get(), src_barrier);
+  image_crate_info.memory_usage = MemoryUsage::gpu_only;
+  // owner can make it movable after upload, defragmenter copies it then
+  image_crate_info.usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
 
-  image->ChangeLayout(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+  image = make_unique<vk::Image>(device, image_crate_info);
 
   vk::DstImageBarrier afterload_dst_barrier;
   afterload_dst_barrier.access = VK_ACCESS_SHADER_READ_BIT;
-  afterload_dst_barrier.layout = image->GetLayout();
+  afterload_dst_barrier.layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
   afterload_dst_barrier.stage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
 
-  vk::ImageBarrier afterload_barrier(*image, afterload_src_barrier,
-                                     afterload_dst_barrier);
-  afterload_barrier.Set(*command_buffer);
+  UploadToken token =
+      upload_manager.CopyToImage(*image, data.levels, afterload_dst_barrier);
 
-  command_buffer->End();
+  TRACE("image load to texture queued");
 
-  command_buffer->SoloExecute();
-
-  TRACE("image loaded to texture");
+  return token;
 }
 
 unique_ptr<ImageView> Texture::CreateImageView() {
@@ -91,4 +58,6 @@ unique_ptr<ImageView> Texture::CreateImageView() {
   return image_view;
 }
 
+Image &Texture::GetImage() { return *image; }
+
 } // namespace vk
@@ -1,20 +1,27 @@
 #pragma once
 #include "command_buffer.hpp"
 #include "device.hpp"
-#include "device_memory.hpp"
 #include "image_view.hpp"
-#include "staging_buffer.hpp"
+#include "upload_manager.hpp"
 #include <span>
 
 using namespace std;
 
 namespace vk {
 
+// levels are given from level 0, missing ones up to mip_levels are blitted
+// on gpu, so block compressed textures must have all of them
+struct TextureData {
+  VkFormat format;
+  glm::ivec2 size;
+  uint32_t mip_levels = full_mip_chain;
+  vector<span<const char>> levels;
+};
+
 class Texture {
 private:
   Device *device;
   unique_ptr<Image> image;
-  unique_ptr<DeviceMemory> memory;
 
 public:
   Texture(Device *device);
@@ -24,9 +31,13 @@ public:
 
   void Destroy();
 
-  void LoadImage(char *image_data, glm::ivec2 image_size,
-                 CommandBuffer *command_buffer, Queue graphics_queue);
+  // image with full mip chain can be used after returned token is complete
+  UploadToken LoadImage(char *image_data, glm::ivec2 image_size,
+                        UploadManager &upload_manager);
+  UploadToken Load(TextureData &data, UploadManager &upload_manager);
   unique_ptr<ImageView> CreateImageView();
+
+  Image &GetImage();
 };
 
 } // namespace vk
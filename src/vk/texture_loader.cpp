@@ -0,0 +1,266 @@
+#include "texture_loader.hpp"
+#include <stb_image.h>
+
+namespace vk {
+
+TextureLoader::TextureLoader(Device &device, UploadManager &upload_manager,
+                             TextureLoaderCreateInfo &create_info) {
+  this->device = &device;
+  this->upload_manager = &upload_manager;
+  defragmenter = create_info.defragmenter;
+  uploading_count = 0;
+  stopping = false;
+
+  CreatePlaceholder();
+
+  uint32_t worker_count = create_info.worker_count;
+  if (worker_count == 0) {
+    worker_count = max(thread::hardware_concurrency(), 2u) - 1;
+  }
+
+  for (uint32_t i = 0; i < worker_count; i++) {
+    workers.emplace_back(&TextureLoader::WorkerLoop, this);
+  }
+
+  TRACE("texture loader with {0} workers created", worker_count);
+}
+
+TextureLoader::~TextureLoader() {
+  if (placeholder) {
+    Destroy();
+  }
+}
+
+void TextureLoader::Destroy() {
+  {
+    lock_guard<mutex> lock(jobs_mutex);
+    stopping = true;
+    jobs.clear();
+  }
+  jobs_condition.notify_all();
+
+  for (thread &worker : workers) {
+    worker.join();
+  }
+  workers.clear();
+
+  for (DecodedImage &decoded_image : decoded_images) {
+    stbi_image_free(decoded_image.pixels);
+  }
+  decoded_images.clear();
+
+  // images still in upload batches must not be freed under gpu
+  if (uploading_count > 0) {
+    upload_manager->Wait(upload_manager->Submit());
+  }
+
+  entries.clear();
+  placeholder_view.reset();
+  placeholder.reset();
+
+  TRACE("texture loader destroyed");
+}
+
+void TextureLoader::CreatePlaceholder() {
+  char pixel[4] = {(char)128, (char)128, (char)128, (char)255};
+
+  placeholder = make_unique<Texture>(device);
+  UploadToken token =
+      placeholder->LoadImage(pixel, {1, 1}, *upload_manager);
+
+  upload_manager->Wait(token);
+  placeholder_view = placeholder->CreateImageView();
+}
+
+TextureHandle TextureLoader::Load(string path) {
+  TextureHandle handle = entries.size();
+
+  Entry entry;
+  entry.state = TextureState::decoding;
+  entry.token = 0;
+  entries.push_back(move(entry));
+
+  {
+    lock_guard<mutex> lock(jobs_mutex);
+    jobs.push_back({handle, path});
+  }
+  jobs_condition.notify_one();
+
+  return handle;
+}
+
+void TextureLoader::WorkerLoop() {
+  while (true) {
+    pair<TextureHandle, string> job;
+
+    {
+      unique_lock<mutex> lock(jobs_mutex);
+      jobs_condition.wait(lock, [&]() { return stopping || !jobs.empty(); });
+
+      if (stopping) {
+        return;
+      }
+
+      job = move(jobs.front());
+      jobs.pop_front();
+    }
+
+    Decode(job.first, job.second);
+  }
+}
+
+void TextureLoader::Decode(TextureHandle handle, string path) {
+  DecodedImage decoded_image;
+  decoded_image.handle = handle;
+  decoded_image.failed = false;
+  decoded_image.pixels = nullptr;
+
+  if (fs::path(path).extension() == ".ktx2") {
+    DecodeKtx2(path, decoded_image);
+  } else {
+    DecodeImage(path, decoded_image);
+  }
+
+  lock_guard<mutex> lock(decoded_mutex);
+  decoded_images.push_back(decoded_image);
+}
+
+void TextureLoader::DecodeImage(string path, DecodedImage &decoded_image) {
+  glm::ivec2 size;
+  int channels;
+  decoded_image.pixels =
+      stbi_load(path.c_str(), &size.x, &size.y, &channels, STBI_rgb_alpha);
+
+  if (!decoded_image.pixels) {
+    WARN("cant decode texture {0}: {1}", path, stbi_failure_reason());
+    decoded_image.failed = true;
+    return;
+  }
+
+  decoded_image.data.format = VK_FORMAT_R8G8B8A8_SRGB;
+  decoded_image.data.size = size;
+  decoded_image.data.levels.push_back(
+      span<const char>((char *)decoded_image.pixels, size.x * size.y * 4));
+}
+
+void TextureLoader::DecodeKtx2(string path, DecodedImage &decoded_image) {
+  try {
+    decoded_image.ktx2_file = make_shared<Ktx2File>(
+        Ktx2File::FindVariant(path, device->GetPhysicalDevice()));
+    decoded_image.data =
+        decoded_image.ktx2_file->Prepare(device->GetPhysicalDevice());
+  } catch (IException &exception) {
+    WARN("cant load texture {0}: {1}", path, (string)exception);
+    decoded_image.ktx2_file.reset();
+    decoded_image.failed = true;
+  }
+}
+
+void TextureLoader::Update() {
+  StageDecoded();
+  CheckUploads();
+}
+
+void TextureLoader::StageDecoded() {
+  vector<DecodedImage> staged_images;
+
+  {
+    lock_guard<mutex> lock(decoded_mutex);
+    staged_images.swap(decoded_images);
+  }
+
+  if (staged_images.empty()) {
+    return;
+  }
+
+  for (DecodedImage &decoded_image : staged_images) {
+    Entry &entry = entries[decoded_image.handle];
+
+    if (decoded_image.failed) {
+      entry.state = TextureState::failed;
+      continue;
+    }
+
+    entry.texture = make_unique<Texture>(device);
+    entry.token = entry.texture->Load(decoded_image.data, *upload_manager);
+    entry.state = TextureState::uploading;
+    uploading_count++;
+
+    // pixels are already copied to staging ring
+    stbi_image_free(decoded_image.pixels);
+    decoded_image.ktx2_file.reset();
+  }
+
+  upload_manager->Submit();
+
+  TRACE("{0} decoded textures staged", staged_images.size());
+}
+
+void TextureLoader::CheckUploads() {
+  if (uploading_count == 0) {
+    return;
+  }
+
+  for (TextureHandle handle = 0; handle < entries.size(); handle++) {
+    Entry &entry = entries[handle];
+    if (entry.state != TextureState::uploading ||
+        !upload_manager->IsComplete(entry.token)) {
+      continue;
+    }
+
+    entry.view = entry.texture->CreateImageView();
+    entry.state = TextureState::resident;
+    uploading_count--;
+
+    // acquire and mip blits are already recorded before any later
+    // defragmenter step, so image is not moved while it is written
+    if (defragmenter) {
+      Image &image = entry.texture->GetImage();
+      image.SetMovable(true);
+      image.AddMoveCallback([this, handle]() { OnTextureMoved(handle); });
+    }
+  }
+}
+
+void TextureLoader::OnTextureMoved(TextureHandle handle) {
+  Entry &entry = entries[handle];
+
+  // frames in flight can still sample old view
+  defragmenter->RetireImageView(entry.view->Recreate());
+
+  for (auto &callback : entry.move_callbacks) {
+    callback();
+  }
+}
+
+bool TextureLoader::IsResident(TextureHandle handle) {
+  return entries[handle].state == TextureState::resident;
+}
+
+bool TextureLoader::IsIdle() {
+  for (Entry &entry : entries) {
+    if (entry.state == TextureState::decoding ||
+        entry.state == TextureState::uploading) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+ImageView &TextureLoader::GetView(TextureHandle handle) {
+  Entry &entry = entries[handle];
+
+  if (entry.state != TextureState::resident) {
+    return *placeholder_view;
+  }
+
+  return *entry.view;
+}
+
+void TextureLoader::AddMoveCallback(TextureHandle handle,
+                                    function<void()> callback) {
+  entries[handle].move_callbacks.push_back(callback);
+}
+
+} // namespace vk
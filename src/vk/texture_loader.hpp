@@ -0,0 +1,109 @@
+#pragma once
+#include "defragmenter.hpp"
+#include "device.hpp"
+#include "image_view.hpp"
+#include "ktx2.hpp"
+#include "texture.hpp"
+#include "upload_manager.hpp"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace vk {
+
+typedef uint32_t TextureHandle;
+
+struct TextureLoaderCreateInfo {
+  // 0 uses every hardware thread except the main one
+  uint32_t worker_count = 0;
+  // resident textures are made movable when set
+  Defragmenter *defragmenter = nullptr;
+};
+
+// decodes image and ktx2 files on worker threads, main thread only stages
+// decoded pixels and records copies, textures are drawn with a placeholder
+// until their upload is complete
+class TextureLoader {
+private:
+  enum class TextureState { decoding, uploading, resident, failed };
+
+  struct Entry {
+    TextureState state;
+    unique_ptr<Texture> texture;
+    unique_ptr<ImageView> view;
+    UploadToken token;
+    vector<function<void()>> move_callbacks;
+  };
+
+  // pixels are owned by stb for image files and by ktx2 file otherwise
+  struct DecodedImage {
+    TextureHandle handle;
+    bool failed;
+    TextureData data;
+    unsigned char *pixels;
+    shared_ptr<Ktx2File> ktx2_file;
+  };
+
+  Device *device;
+  UploadManager *upload_manager;
+  Defragmenter *defragmenter;
+
+  vector<Entry> entries;
+  unique_ptr<Texture> placeholder;
+  unique_ptr<ImageView> placeholder_view;
+  uint32_t uploading_count;
+
+  vector<thread> workers;
+  mutex jobs_mutex;
+  condition_variable jobs_condition;
+  deque<pair<TextureHandle, string>> jobs;
+  bool stopping;
+
+  mutex decoded_mutex;
+  vector<DecodedImage> decoded_images;
+
+  void CreatePlaceholder();
+  void WorkerLoop();
+  void Decode(TextureHandle handle, string path);
+  void DecodeImage(string path, DecodedImage &decoded_image);
+  void DecodeKtx2(string path, DecodedImage &decoded_image);
+
+  void StageDecoded();
+  void CheckUploads();
+  void OnTextureMoved(TextureHandle handle);
+
+public:
+  TextureLoader(Device &device, UploadManager &upload_manager,
+                TextureLoaderCreateInfo &create_info);
+  TextureLoader(TextureLoader &) = delete;
+  TextureLoader &operator=(TextureLoader &) = delete;
+  ~TextureLoader();
+
+  void Destroy();
+
+  // returns immediately, file is decoded in background
+  TextureHandle Load(string path);
+
+  // must be called once per frame on the main thread, stages decoded
+  // images and submits their copies in one batch
+  void Update();
+
+  bool IsResident(TextureHandle handle);
+  bool IsIdle();
+
+  // placeholder view while texture is not resident
+  ImageView &GetView(TextureHandle handle);
+
+  // called after resident texture was moved and its view recreated, views
+  // used in descriptor sets have to be written again
+  void AddMoveCallback(TextureHandle handle, function<void()> callback);
+};
+
+} // namespace vk
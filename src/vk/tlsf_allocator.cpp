@@ -0,0 +1,367 @@
+#include "tlsf_allocator.hpp"
+#include "tools.hpp"
+#include <algorithm>
+#include <bit>
+
+namespace vk {
+
+TlsfAllocator::TlsfAllocator(VkDeviceSize size, VkDeviceSize granularity) {
+  this->size = size;
+  this->granularity = granularity;
+
+  fl_bitmap = 0;
+  for (uint32_t fl = 0; fl < fl_index_count; fl++) {
+    sl_bitmaps[fl] = 0;
+    for (uint32_t sl = 0; sl < sl_index_count; sl++) {
+      free_lists[fl][sl] = null_block;
+    }
+  }
+
+  // first block never merges into another, so it stays at index 0
+  uint32_t block_index = CreateBlock();
+  Block &block = blocks[block_index];
+  block.offset = 0;
+  block.size = size;
+
+  free_size = 0;
+  InsertFreeBlock(block_index);
+}
+
+void TlsfAllocator::MappingInsert(VkDeviceSize size, uint32_t &fl,
+                                  uint32_t &sl) {
+  if (size < small_block_size) {
+    fl = 0;
+    sl = size / (small_block_size / sl_index_count);
+    return;
+  }
+
+  uint32_t msb = bit_width(size) - 1;
+  sl = (size >> (msb - sl_index_count_log2)) ^ sl_index_count;
+  fl = msb - fl_index_shift + 1;
+}
+
+void TlsfAllocator::MappingSearch(VkDeviceSize size, uint32_t &fl,
+                                  uint32_t &sl) {
+  // round up to the next class, so any block of the found class fits
+  if (size >= small_block_size) {
+    uint32_t msb = bit_width(size) - 1;
+    size += ((VkDeviceSize)1 << (msb - sl_index_count_log2)) - 1;
+  }
+
+  MappingInsert(size, fl, sl);
+}
+
+uint32_t TlsfAllocator::CreateBlock() {
+  uint32_t block_index;
+
+  if (unused_blocks.size()) {
+    block_index = unused_blocks.back();
+    unused_blocks.pop_back();
+  } else {
+    block_index = blocks.size();
+    blocks.emplace_back();
+  }
+
+  Block &block = blocks[block_index];
+  block.prev_physical = null_block;
+  block.next_physical = null_block;
+  block.prev_free = null_block;
+  block.next_free = null_block;
+  block.empty = true;
+  block.linear = false;
+
+  return block_index;
+}
+
+void TlsfAllocator::ReleaseBlock(uint32_t block_index) {
+  unused_blocks.push_back(block_index);
+}
+
+void TlsfAllocator::InsertFreeBlock(uint32_t block_index) {
+  Block &block = blocks[block_index];
+
+  uint32_t fl, sl;
+  MappingInsert(block.size, fl, sl);
+
+  uint32_t head = free_lists[fl][sl];
+  block.prev_free = null_block;
+  block.next_free = head;
+  if (head != null_block) {
+    blocks[head].prev_free = block_index;
+  }
+
+  free_lists[fl][sl] = block_index;
+  fl_bitmap |= (uint64_t)1 << fl;
+  sl_bitmaps[fl] |= 1u << sl;
+
+  free_size += block.size;
+}
+
+void TlsfAllocator::RemoveFreeBlock(uint32_t block_index) {
+  Block &block = blocks[block_index];
+
+  uint32_t fl, sl;
+  MappingInsert(block.size, fl, sl);
+
+  if (block.prev_free != null_block) {
+    blocks[block.prev_free].next_free = block.next_free;
+  } else {
+    free_lists[fl][sl] = block.next_free;
+  }
+
+  if (block.next_free != null_block) {
+    blocks[block.next_free].prev_free = block.prev_free;
+  }
+
+  if (free_lists[fl][sl] == null_block) {
+    sl_bitmaps[fl] &= ~(1u << sl);
+    if (!sl_bitmaps[fl]) {
+      fl_bitmap &= ~((uint64_t)1 << fl);
+    }
+  }
+
+  block.prev_free = null_block;
+  block.next_free = null_block;
+
+  free_size -= block.size;
+}
+
+void TlsfAllocator::MergeBlock(uint32_t block_index,
+                               uint32_t next_block_index) {
+  Block &block = blocks[block_index];
+  Block &next_block = blocks[next_block_index];
+
+  block.size += next_block.size;
+  block.next_physical = next_block.next_physical;
+  if (block.next_physical != null_block) {
+    blocks[block.next_physical].prev_physical = block_index;
+  }
+
+  ReleaseBlock(next_block_index);
+}
+
+bool TlsfAllocator::CheckFit(uint32_t block_index, VkDeviceSize size,
+                             VkDeviceSize alignment, bool linear,
+                             VkDeviceSize &aligned_offset) {
+  Block &block = blocks[block_index];
+  VkDeviceSize block_end = block.offset + block.size;
+
+  VkDeviceSize offset = tools::align_up(block.offset, alignment);
+
+  // linear and optimal resources must not share a bufferImageGranularity
+  // page, neighbours of an empty block are always occupied
+  uint32_t prev_index = block.prev_physical;
+  if (granularity > 1 && prev_index != null_block &&
+      blocks[prev_index].linear != linear) {
+    Block &prev_block = blocks[prev_index];
+    VkDeviceSize prev_end = prev_block.offset + prev_block.size;
+
+    if (tools::align_down(prev_end - 1, granularity) ==
+        tools::align_down(offset, granularity)) {
+      offset = tools::align_up(offset, granularity);
+    }
+  }
+
+  if (offset + size > block_end) {
+    return false;
+  }
+
+  uint32_t next_index = block.next_physical;
+  if (granularity > 1 && next_index != null_block &&
+      blocks[next_index].linear != linear) {
+    if (tools::align_down(offset + size - 1, granularity) ==
+        tools::align_down(blocks[next_index].offset, granularity)) {
+      return false;
+    }
+  }
+
+  aligned_offset = offset;
+  return true;
+}
+
+uint32_t TlsfAllocator::FindInFreeLists(uint32_t fl, uint32_t sl,
+                                        uint32_t end_fl, uint32_t end_sl,
+                                        VkDeviceSize size,
+                                        VkDeviceSize alignment, bool linear,
+                                        VkDeviceSize &aligned_offset) {
+  uint64_t fl_map = fl_bitmap & (~(uint64_t)0 << fl);
+  uint32_t sl_map = sl_bitmaps[fl] & (~0u << sl);
+
+  while (fl < end_fl || (fl == end_fl && sl < end_sl)) {
+    if (!sl_map) {
+      fl_map &= ~((uint64_t)1 << fl);
+      if (!fl_map) {
+        break;
+      }
+
+      fl = countr_zero(fl_map);
+      sl_map = sl_bitmaps[fl];
+      sl = 0;
+      continue;
+    }
+
+    sl = countr_zero(sl_map);
+    sl_map &= ~(1u << sl);
+    if (fl == end_fl && sl >= end_sl) {
+      break;
+    }
+
+    for (uint32_t i = free_lists[fl][sl]; i != null_block;
+         i = blocks[i].next_free) {
+      if (CheckFit(i, size, alignment, linear, aligned_offset)) {
+        return i;
+      }
+    }
+  }
+
+  return null_block;
+}
+
+uint32_t TlsfAllocator::FindSuitableBlock(VkDeviceSize size,
+                                          VkDeviceSize alignment, bool linear,
+                                          VkDeviceSize &aligned_offset) {
+  // good fit, heads of the found classes fit the worst alignment padding
+  uint32_t search_fl, search_sl;
+  MappingSearch(size + alignment - 1, search_fl, search_sl);
+
+  if (search_fl < fl_index_count) {
+    uint32_t block_index =
+        FindInFreeLists(search_fl, search_sl, fl_index_count, 0, size,
+                        alignment, linear, aligned_offset);
+    if (block_index != null_block) {
+      return block_index;
+    }
+  } else {
+    search_fl = fl_index_count;
+    search_sl = 0;
+  }
+
+  // smaller classes can still fit when blocks are already aligned
+  uint32_t fl, sl;
+  MappingInsert(size, fl, sl);
+
+  return FindInFreeLists(fl, sl, search_fl, search_sl, size, alignment, linear,
+                         aligned_offset);
+}
+
+void TlsfAllocator::OccupieBlock(uint32_t block_index, VkDeviceSize size,
+                                 VkDeviceSize aligned_offset, bool linear) {
+  RemoveFreeBlock(block_index);
+
+  // CreateBlock can reallocate blocks, so no references are kept around it
+  VkDeviceSize padding = aligned_offset - blocks[block_index].offset;
+  if (padding) {
+    uint32_t padding_index = CreateBlock();
+    Block &padding_block = blocks[padding_index];
+    Block &block = blocks[block_index];
+
+    padding_block.offset = block.offset;
+    padding_block.size = padding;
+    padding_block.prev_physical = block.prev_physical;
+    padding_block.next_physical = block_index;
+    if (block.prev_physical != null_block) {
+      blocks[block.prev_physical].next_physical = padding_index;
+    }
+
+    block.prev_physical = padding_index;
+    block.offset = aligned_offset;
+    block.size -= padding;
+
+    InsertFreeBlock(padding_index);
+  }
+
+  VkDeviceSize remainder = blocks[block_index].size - size;
+  if (remainder) {
+    uint32_t remainder_index = CreateBlock();
+    Block &remainder_block = blocks[remainder_index];
+    Block &block = blocks[block_index];
+
+    remainder_block.offset = block.offset + size;
+    remainder_block.size = remainder;
+    remainder_block.prev_physical = block_index;
+    remainder_block.next_physical = block.next_physical;
+    if (block.next_physical != null_block) {
+      blocks[block.next_physical].prev_physical = remainder_index;
+    }
+
+    block.next_physical = remainder_index;
+    block.size = size;
+
+    InsertFreeBlock(remainder_index);
+  }
+
+  Block &block = blocks[block_index];
+  block.empty = false;
+  block.linear = linear;
+}
+
+uint32_t TlsfAllocator::Allocate(VkDeviceSize size, VkDeviceSize alignment,
+                                 bool linear) {
+  if (!size || size > free_size) {
+    return null_block;
+  }
+
+  VkDeviceSize aligned_offset;
+  uint32_t block_index =
+      FindSuitableBlock(size, alignment, linear, aligned_offset);
+  if (block_index == null_block) {
+    return null_block;
+  }
+
+  OccupieBlock(block_index, size, aligned_offset, linear);
+
+  return block_index;
+}
+
+void TlsfAllocator::Free(uint32_t block_index) {
+  Block &block = blocks[block_index];
+  block.empty = true;
+  block.linear = false;
+
+  // merge left block
+  uint32_t prev_index = block.prev_physical;
+  if (prev_index != null_block && blocks[prev_index].empty) {
+    RemoveFreeBlock(prev_index);
+    MergeBlock(prev_index, block_index);
+    block_index = prev_index;
+  }
+
+  // merge right block
+  uint32_t next_index = blocks[block_index].next_physical;
+  if (next_index != null_block && blocks[next_index].empty) {
+    RemoveFreeBlock(next_index);
+    MergeBlock(block_index, next_index);
+  }
+
+  InsertFreeBlock(block_index);
+}
+
+const TlsfAllocator::Block &TlsfAllocator::GetBlock(uint32_t block_index) {
+  return blocks[block_index];
+}
+
+uint32_t TlsfAllocator::GetFirstBlock() { return 0; }
+
+VkDeviceSize TlsfAllocator::GetFreeSize() { return free_size; }
+
+VkDeviceSize TlsfAllocator::GetLargestFreeSize() {
+  if (!fl_bitmap) {
+    return 0;
+  }
+
+  // largest block is somewhere in the highest non empty list
+  uint32_t fl = bit_width(fl_bitmap) - 1;
+  uint32_t sl = bit_width(sl_bitmaps[fl]) - 1;
+
+  VkDeviceSize largest_size = 0;
+  for (uint32_t i = free_lists[fl][sl]; i != null_block;
+       i = blocks[i].next_free) {
+    largest_size = max(largest_size, blocks[i].size);
+  }
+
+  return largest_size;
+}
+
+bool TlsfAllocator::IsEmpty() { return free_size == size; }
+
+} // namespace vk
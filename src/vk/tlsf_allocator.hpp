@@ -0,0 +1,84 @@
+#pragma once
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+using namespace std;
+
+namespace vk {
+
+// two level segregated fit allocator, works only with offsets so it can be
+// placed over any VkDeviceMemory, allocate and free are O(1)
+class TlsfAllocator {
+public:
+  static constexpr uint32_t null_block = numeric_limits<uint32_t>::max();
+
+  struct Block {
+    VkDeviceSize offset;
+    VkDeviceSize size;
+
+    uint32_t prev_physical;
+    uint32_t next_physical;
+    uint32_t prev_free;
+    uint32_t next_free;
+
+    bool empty;
+    bool linear;
+  };
+
+private:
+  static constexpr uint32_t sl_index_count_log2 = 5;
+  static constexpr uint32_t sl_index_count = 1 << sl_index_count_log2;
+  static constexpr uint32_t fl_index_shift = sl_index_count_log2 + 3;
+  static constexpr uint32_t fl_index_count = 64 - fl_index_shift + 1;
+  static constexpr VkDeviceSize small_block_size = 1 << fl_index_shift;
+
+  VkDeviceSize size;
+  VkDeviceSize granularity;
+
+  vector<Block> blocks;
+  vector<uint32_t> unused_blocks;
+
+  uint64_t fl_bitmap;
+  uint32_t sl_bitmaps[fl_index_count];
+  uint32_t free_lists[fl_index_count][sl_index_count];
+
+  VkDeviceSize free_size;
+
+  static void MappingInsert(VkDeviceSize size, uint32_t &fl, uint32_t &sl);
+  static void MappingSearch(VkDeviceSize size, uint32_t &fl, uint32_t &sl);
+
+  uint32_t CreateBlock();
+  void ReleaseBlock(uint32_t block_index);
+
+  void InsertFreeBlock(uint32_t block_index);
+  void RemoveFreeBlock(uint32_t block_index);
+  void MergeBlock(uint32_t block_index, uint32_t next_block_index);
+
+  bool CheckFit(uint32_t block_index, VkDeviceSize size,
+                VkDeviceSize alignment, bool linear,
+                VkDeviceSize &aligned_offset);
+  uint32_t FindInFreeLists(uint32_t fl, uint32_t sl, uint32_t end_fl,
+                           uint32_t end_sl, VkDeviceSize size,
+                           VkDeviceSize alignment, bool linear,
+                           VkDeviceSize &aligned_offset);
+  uint32_t FindSuitableBlock(VkDeviceSize size, VkDeviceSize alignment,
+                             bool linear, VkDeviceSize &aligned_offset);
+  void OccupieBlock(uint32_t block_index, VkDeviceSize size,
+                    VkDeviceSize aligned_offset, bool linear);
+
+public:
+  TlsfAllocator(VkDeviceSize size, VkDeviceSize granularity);
+
+  uint32_t Allocate(VkDeviceSize size, VkDeviceSize alignment, bool linear);
+  void Free(uint32_t block_index);
+
+  const Block &GetBlock(uint32_t block_index);
+  uint32_t GetFirstBlock();
+  VkDeviceSize GetFreeSize();
+  VkDeviceSize GetLargestFreeSize();
+  bool IsEmpty();
+};
+
+} // namespace vk
@@ -0,0 +1,670 @@
+#include "upload_manager.hpp"
+#include "memory_manager.hpp"
+#include <string.h>
+
+namespace vk {
+
+UploadManager::UploadManager(Device &device,
+                             UploadManagerCreateInfo &create_info) {
+  this->device = &device;
+  queue = create_info.queue;
+  dst_queue = create_info.dst_queue;
+  ownership_transfer = queue.GetFamily() != dst_queue.GetFamily();
+  can_blit = device.GetPhysicalDevice()
+                 .GetQueueFamilyProperties(queue.GetFamily())
+                 .queueFlags &
+             VK_QUEUE_GRAPHICS_BIT;
+  timeline = &device.GetTimeline(queue);
+  head = 0;
+  recording = false;
+  next_token = 1;
+  completed_token = 0;
+  acquired_token = 0;
+
+  barriers = make_unique<BarrierBatch>(device);
+  preloads = make_unique<BarrierBatch>(device);
+  acquires = make_unique<BarrierBatch>(device);
+
+  VkPhysicalDeviceLimits limits = device.GetPhysicalDevice().GetLimits();
+
+  // 16 covers texel size of every uncompressed format and bc blocks
+  min_alignment = 16;
+  min_alignment = max(min_alignment, limits.optimalBufferCopyOffsetAlignment);
+  min_alignment = max(min_alignment, limits.nonCoherentAtomSize);
+
+  command_pool =
+      make_unique<CommandPool>(device, queue, create_info.max_batches);
+
+  CreateRingBuffer(create_info.ring_size);
+  CreateBatches(create_info.max_batches);
+
+  // used only by Wait, frames acquire uploads in their own command buffers
+  if (ownership_transfer) {
+    acquire_command_pool = make_unique<CommandPool>(device, dst_queue, 1);
+    acquire_command_buffer =
+        acquire_command_pool->AllocateCommandBuffer(CommandBufferLevel::primary);
+  }
+
+  TRACE("upload manager with {0} bytes staging ring created, ownership "
+        "transfer {1}",
+        ring_size, ownership_transfer ? "enabled" : "disabled");
+}
+
+UploadManager::~UploadManager() {
+  if (ring_buffer) {
+    Destroy();
+  }
+}
+
+void UploadManager::Destroy() {
+  if (recording) {
+    Submit();
+  }
+
+  while (!pending_batches.empty()) {
+    RetireBatches(true);
+  }
+
+  for (Batch &batch : batches) {
+    batch.command_buffer.reset();
+  }
+  batches.clear();
+  free_batches.clear();
+
+  barriers.reset();
+  preloads.reset();
+  acquires.reset();
+
+  command_pool.reset();
+
+  acquire_command_buffer.reset();
+  acquire_command_pool.reset();
+
+  ring_buffer->Destroy();
+  ring_buffer.reset();
+
+  TRACE("upload manager destroyed");
+}
+
+void UploadManager::CreateRingBuffer(VkDeviceSize size) {
+  ring_size = tools::align_up(size, min_alignment);
+
+  BufferCreateInfo create_info;
+  create_info.queue = queue;
+  create_info.size = ring_size;
+  create_info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+  create_info.memory_usage = MemoryUsage::upload;
+  create_info.memory_category = MemoryCategory::staging;
+
+  ring_buffer = make_unique<Buffer>(*device, create_info);
+  mapped_data = (char *)ring_buffer->Map();
+}
+
+void UploadManager::CreateBatches(uint32_t count) {
+  batches.resize(count);
+
+  for (uint32_t i = 0; i < count; i++) {
+    Batch &batch = batches[i];
+    batch.command_buffer =
+        command_pool->AllocateCommandBuffer(CommandBufferLevel::primary);
+    batch.acquires = make_unique<BarrierBatch>(*device);
+    batch.token = 0;
+    batch.timeline_value = 0;
+    batch.begin = 0;
+
+    free_batches.push_back(i);
+  }
+}
+
+bool UploadManager::IsRingEmpty() {
+  return pending_batches.empty() && !recording;
+}
+
+bool UploadManager::TryAllocate(VkDeviceSize size, VkDeviceSize alignment,
+                                VkDeviceSize &offset) {
+  if (IsRingEmpty()) {
+    offset = 0;
+    head = size;
+    return true;
+  }
+
+  // oldest staged data still used by gpu
+  uint32_t oldest_batch =
+      pending_batches.empty() ? current_batch : pending_batches.front();
+  VkDeviceSize tail = batches[oldest_batch].begin;
+
+  offset = tools::align_up(head, alignment);
+
+  if (tail < head) {
+    if (offset + size <= ring_size) {
+      head = offset + size;
+      return true;
+    }
+
+    // wrap around, end of the ring stays unused until tail passes it
+    offset = 0;
+  }
+
+  // head equal to tail means ring is full
+  if (offset + size <= tail) {
+    head = offset + size;
+    return true;
+  }
+
+  return false;
+}
+
+VkDeviceSize UploadManager::Allocate(VkDeviceSize size,
+                                     VkDeviceSize alignment) {
+  if (size > ring_size) {
+    throw CriticalException("upload is bigger than staging ring");
+  }
+
+  VkDeviceSize offset;
+  while (!TryAllocate(size, alignment, offset)) {
+    // only not submitted copies hold the ring, they must go to gpu first
+    if (pending_batches.empty()) {
+      Submit();
+    }
+
+    RetireBatches(true);
+  }
+
+  return offset;
+}
+
+VkDeviceSize UploadManager::Stage(span<const char> data,
+                                  VkDeviceSize alignment) {
+  VkDeviceSize offset =
+      Allocate(data.size_bytes(), max(alignment, min_alignment));
+
+  memcpy(mapped_data + offset, data.data(), data.size_bytes());
+  ring_buffer->QueueFlush(offset, data.size_bytes());
+
+  if (!recording) {
+    BeginBatch();
+    batches[current_batch].begin = offset;
+  }
+
+  return offset;
+}
+
+// levels are placed one after another in a single ring allocation, so
+// they always end in the same batch
+void UploadManager::StageLevels(span<const span<const char>> levels,
+                                vector<VkDeviceSize> &offsets) {
+  VkDeviceSize size = 0;
+  for (span<const char> level : levels) {
+    offsets.push_back(size);
+    size = tools::align_up(size + level.size_bytes(), min_alignment);
+  }
+
+  VkDeviceSize offset = Allocate(size, min_alignment);
+
+  for (uint32_t i = 0; i < levels.size(); i++) {
+    offsets[i] += offset;
+    memcpy(mapped_data + offsets[i], levels[i].data(), levels[i].size_bytes());
+  }
+  ring_buffer->QueueFlush(offset, size);
+
+  if (!recording) {
+    BeginBatch();
+    batches[current_batch].begin = offset;
+  }
+}
+
+void UploadManager::BeginBatch() {
+  // every batch is in flight, so the oldest one is reused
+  if (free_batches.empty()) {
+    RetireBatches(true);
+  }
+
+  current_batch = free_batches.back();
+  free_batches.pop_back();
+
+  Batch &batch = batches[current_batch];
+  batch.token = next_token++;
+  batch.mip_generations.clear();
+  batch.command_buffer->Begin();
+
+  recording = true;
+}
+
+UploadToken UploadManager::CopyToBuffer(Buffer &buffer, span<const char> data,
+                                        VkDeviceSize dst_offset) {
+  if (data.empty()) {
+    return acquired_token;
+  }
+
+  VkDeviceSize offset = Stage(data, 1);
+  Batch &batch = batches[current_batch];
+
+  VkBufferCopy region;
+  region.srcOffset = offset;
+  region.dstOffset = dst_offset;
+  region.size = data.size_bytes();
+
+  vkCmdCopyBuffer(batch.command_buffer->GetHandle(), ring_buffer->GetHandle(),
+                  buffer.GetHandle(), 1, &region);
+
+  if (ownership_transfer) {
+    ReleaseBuffer(buffer, dst_offset, data.size_bytes());
+  }
+
+  return batch.token;
+}
+
+UploadToken UploadManager::CopyToImage(Image &image, span<const char> data,
+                                       DstImageBarrier dst_barrier) {
+  span<const char> levels[] = {data};
+  return CopyToImage(image, levels, dst_barrier);
+}
+
+UploadToken UploadManager::CopyToImage(Image &image,
+                                       span<const span<const char>> levels,
+                                       DstImageBarrier dst_barrier) {
+  if (levels.empty() || levels.size() > image.GetMipLevels()) {
+    throw CriticalException("wrong number of image levels to upload");
+  }
+
+  vector<VkDeviceSize> offsets;
+  StageLevels(levels, offsets);
+  Batch &batch = batches[current_batch];
+
+  // image uploaded again in this batch, its previous copy and the barriers
+  // after it have to be recorded before new preload
+  if (preloads->Contains(image.GetHandle())) {
+    RecordImageCopies();
+  }
+  if (barriers->Contains(image.GetHandle())) {
+    barriers->Flush(*batch.command_buffer);
+  }
+
+  // previous content is overwritten, so nothing has to be waited for
+  SrcImageBarrier preload_src_barrier;
+  preload_src_barrier.stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+  preload_src_barrier.access = 0;
+  preload_src_barrier.layout =
+      image.ChangeLayout(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+
+  DstImageBarrier preload_dst_barrier;
+  preload_dst_barrier.stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+  preload_dst_barrier.access = VK_ACCESS_TRANSFER_WRITE_BIT;
+  preload_dst_barrier.layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+
+  ImageBarrier preload_barrier(image, preload_src_barrier,
+                               preload_dst_barrier);
+  preloads->Add(preload_barrier);
+
+  ImageCopy image_copy;
+  image_copy.image = &image;
+  image_copy.dst_barrier = dst_barrier;
+  image_copy.regions.resize(levels.size());
+  VkExtent3D extent = image.GetExtent();
+
+  for (uint32_t i = 0; i < levels.size(); i++) {
+    VkBufferImageCopy &region = image_copy.regions[i];
+    region = {};
+    region.bufferOffset = offsets[i];
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.mipLevel = i;
+    region.imageSubresource.baseArrayLayer = 0;
+    region.imageSubresource.layerCount = 1;
+    region.imageExtent = extent;
+
+    extent.width = max(extent.width / 2, 1u);
+    extent.height = max(extent.height / 2, 1u);
+  }
+
+  image_copies.push_back(image_copy);
+
+  return batch.token;
+}
+
+// one barrier call for preloads of every image, then all the copies
+void UploadManager::RecordImageCopies() {
+  if (image_copies.empty()) {
+    return;
+  }
+
+  Batch &batch = batches[current_batch];
+  preloads->Flush(*batch.command_buffer);
+
+  for (ImageCopy &image_copy : image_copies) {
+    RecordImageCopy(image_copy);
+  }
+
+  TRACE("{0} image copies recorded", image_copies.size());
+
+  image_copies.clear();
+}
+
+void UploadManager::RecordImageCopy(ImageCopy &image_copy) {
+  Batch &batch = batches[current_batch];
+  Image &image = *image_copy.image;
+  DstImageBarrier dst_barrier = image_copy.dst_barrier;
+
+  vkCmdCopyBufferToImage(batch.command_buffer->GetHandle(),
+                         ring_buffer->GetHandle(), image.GetHandle(),
+                         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                         image_copy.regions.size(), image_copy.regions.data());
+
+  uint32_t first_level = image_copy.regions.size();
+  bool has_mips = image.GetMipLevels() > first_level;
+
+  if (!ownership_transfer) {
+    if (has_mips) {
+      GenerateMips(*batch.command_buffer, image, first_level, dst_barrier,
+                   *barriers);
+      return;
+    }
+
+    SrcImageBarrier afterload_src_barrier;
+    afterload_src_barrier.stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    afterload_src_barrier.access = VK_ACCESS_TRANSFER_WRITE_BIT;
+    afterload_src_barrier.layout = image.ChangeLayout(dst_barrier.layout);
+
+    ImageBarrier afterload_barrier(image, afterload_src_barrier, dst_barrier);
+    barriers->Add(afterload_barrier);
+
+    return;
+  }
+
+  if (!has_mips) {
+    ReleaseImage(image, dst_barrier);
+    return;
+  }
+
+  // mips are blitted in transfer dst layout, on dst queue when upload queue
+  // has no graphics support
+  DstImageBarrier blit_barrier;
+  blit_barrier.stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+  blit_barrier.access =
+      VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+  blit_barrier.layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+
+  if (can_blit) {
+    GenerateMips(*batch.command_buffer, image, first_level, blit_barrier,
+                 *barriers);
+    // release must come after blits finished transition to blit_barrier
+    barriers->Flush(*batch.command_buffer);
+    ReleaseImage(image, dst_barrier);
+  } else {
+    ReleaseImage(image, blit_barrier);
+    batch.mip_generations.push_back({&image, first_level, dst_barrier});
+  }
+}
+
+// only written range changes owner, rest of the buffer was never touched
+// by upload queue, so dst queue keeps it
+void UploadManager::ReleaseBuffer(Buffer &buffer, VkDeviceSize offset,
+                                  VkDeviceSize size) {
+  Batch &batch = batches[current_batch];
+
+  VkBufferMemoryBarrier barrier = buffer_barrier_template;
+  barrier.buffer = buffer.GetHandle();
+  barrier.offset = offset;
+  barrier.size = size;
+  barrier.srcQueueFamilyIndex = queue.GetFamily();
+  barrier.dstQueueFamilyIndex = dst_queue.GetFamily();
+
+  barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.dstAccessMask = 0;
+
+  barriers->Add(VK_PIPELINE_STAGE_TRANSFER_BIT,
+                VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, barrier);
+
+  barrier.srcAccessMask = 0;
+  barrier.dstAccessMask =
+      VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+
+  batch.acquires->Add(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                      VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, barrier);
+}
+
+// layout transition is the same in release and acquire, so it is done once
+// and dst stages which upload queue may not support are used only in acquire
+void UploadManager::ReleaseImage(Image &image, DstImageBarrier dst_barrier) {
+  Batch &batch = batches[current_batch];
+
+  SrcImageBarrier release_src_barrier;
+  release_src_barrier.stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+  release_src_barrier.access = VK_ACCESS_TRANSFER_WRITE_BIT;
+  release_src_barrier.queue_family_index = queue.GetFamily();
+  release_src_barrier.layout = image.ChangeLayout(dst_barrier.layout);
+
+  DstImageBarrier release_dst_barrier;
+  release_dst_barrier.stage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+  release_dst_barrier.access = 0;
+  release_dst_barrier.queue_family_index = dst_queue.GetFamily();
+  release_dst_barrier.layout = dst_barrier.layout;
+
+  ImageBarrier release_barrier(image, release_src_barrier,
+                               release_dst_barrier);
+  barriers->Add(release_barrier);
+
+  SrcImageBarrier acquire_src_barrier = release_src_barrier;
+  acquire_src_barrier.stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+  acquire_src_barrier.access = 0;
+
+  DstImageBarrier acquire_dst_barrier = dst_barrier;
+  acquire_dst_barrier.queue_family_index = dst_queue.GetFamily();
+
+  ImageBarrier acquire_barrier(image, acquire_src_barrier,
+                               acquire_dst_barrier);
+  batch.acquires->Add(acquire_barrier);
+}
+
+// all levels must be in transfer dst layout with levels below first_level
+// written, each next level is blitted from the previous one
+void UploadManager::GenerateMips(CommandBuffer &command_buffer, Image &image,
+                                 uint32_t first_level,
+                                 DstImageBarrier dst_barrier,
+                                 BarrierBatch &mip_barriers) {
+  VkFormatProperties format_properties =
+      device->GetPhysicalDevice().GetFormatProperties(image.GetFormat());
+  VkFilter filter = format_properties.optimalTilingFeatures &
+                            VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT
+                        ? VK_FILTER_LINEAR
+                        : VK_FILTER_NEAREST;
+
+  uint32_t mip_levels = image.GetMipLevels();
+  VkExtent3D extent = image.GetExtent();
+  int32_t width = max(extent.width >> (first_level - 1), 1u);
+  int32_t height = max(extent.height >> (first_level - 1), 1u);
+
+  SrcImageBarrier written_barrier;
+  written_barrier.stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+  written_barrier.access = VK_ACCESS_TRANSFER_WRITE_BIT;
+  written_barrier.layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+
+  DstImageBarrier blit_source_barrier;
+  blit_source_barrier.stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+  blit_source_barrier.access = VK_ACCESS_TRANSFER_READ_BIT;
+  blit_source_barrier.layout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+
+  ImageBarrier written_levels_barrier(image, written_barrier,
+                                      blit_source_barrier, 0, first_level);
+  mip_barriers.Add(written_levels_barrier);
+  mip_barriers.Flush(command_buffer);
+
+  for (uint32_t i = first_level; i < mip_levels; i++) {
+    VkImageBlit blit{};
+    blit.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, i - 1, 0, 1};
+    blit.srcOffsets[1] = {width, height, 1};
+
+    width = max(width / 2, 1);
+    height = max(height / 2, 1);
+
+    blit.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, i, 0, 1};
+    blit.dstOffsets[1] = {width, height, 1};
+
+    vkCmdBlitImage(command_buffer.GetHandle(), image.GetHandle(),
+                   VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image.GetHandle(),
+                   VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, filter);
+
+    if (i + 1 < mip_levels) {
+      ImageBarrier source_barrier(image, written_barrier, blit_source_barrier,
+                                  i, 1);
+      mip_barriers.Add(source_barrier);
+      mip_barriers.Flush(command_buffer);
+    }
+  }
+
+  // every level except the last one was a blit source
+  SrcImageBarrier blitted_barrier;
+  blitted_barrier.stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+  blitted_barrier.access = VK_ACCESS_TRANSFER_READ_BIT;
+  blitted_barrier.layout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+
+  ImageBarrier blitted_levels_barrier(image, blitted_barrier, dst_barrier, 0,
+                                      mip_levels - 1);
+  ImageBarrier last_level_barrier(image, written_barrier, dst_barrier,
+                                  mip_levels - 1, 1);
+  mip_barriers.Add(blitted_levels_barrier);
+  mip_barriers.Add(last_level_barrier);
+
+  image.ChangeLayout(dst_barrier.layout);
+
+  TRACE("{0} mip levels generated from {1} written", mip_levels,
+        first_level);
+}
+
+UploadToken UploadManager::Submit() {
+  if (!recording) {
+    return next_token - 1;
+  }
+
+  RecordImageCopies();
+
+  Batch &batch = batches[current_batch];
+
+  // buffer copies are made visible to everything submitted after the batch
+  // and go in one call with barriers left by the last copies
+  VkMemoryBarrier memory_barrier = memory_barrier_template;
+  memory_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  memory_barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+
+  barriers->Add(VK_PIPELINE_STAGE_TRANSFER_BIT,
+                VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, memory_barrier);
+  barriers->Flush(*batch.command_buffer);
+
+  batch.command_buffer->End();
+
+  device->GetMemoryManager().FlushQueuedRanges();
+
+  batch.timeline_value =
+      timeline->Submit(batch.command_buffer->GetHandle());
+
+  pending_batches.push_back(current_batch);
+  recording = false;
+
+  TRACE("upload batch {0} submitted", batch.token);
+
+  return batch.token;
+}
+
+void UploadManager::RetireBatches(bool wait_oldest) {
+  if (wait_oldest && !pending_batches.empty()) {
+    timeline->Wait(batches[pending_batches.front()].timeline_value);
+  }
+
+  while (!pending_batches.empty()) {
+    uint32_t batch_index = pending_batches.front();
+    Batch &batch = batches[batch_index];
+
+    if (!timeline->IsComplete(batch.timeline_value)) {
+      break;
+    }
+
+    batch.command_buffer->Reset();
+
+    acquires->Append(*batch.acquires);
+    mip_generations.insert(mip_generations.end(),
+                           batch.mip_generations.begin(),
+                           batch.mip_generations.end());
+    batch.mip_generations.clear();
+
+    completed_token = batch.token;
+    if (!ownership_transfer) {
+      acquired_token = completed_token;
+    }
+
+    pending_batches.pop_front();
+    free_batches.push_back(batch_index);
+  }
+}
+
+void UploadManager::AcquireUploads(CommandBuffer &command_buffer) {
+  RetireBatches(false);
+
+  // release is finished, since batch value signaled before this recording,
+  // so no semaphore between queues is needed
+  if (!acquires->IsEmpty()) {
+    TRACE("{0} uploads acquired", acquires->GetSize());
+
+    // acquire has to finish before blits transition same levels
+    acquires->Flush(command_buffer);
+  }
+
+  // last barriers of every image go in one call
+  BarrierBatch mip_barriers(*device);
+  for (MipGeneration &mip_generation : mip_generations) {
+    GenerateMips(command_buffer, *mip_generation.image,
+                 mip_generation.first_level, mip_generation.dst_barrier,
+                 mip_barriers);
+  }
+  mip_barriers.Flush(command_buffer);
+  mip_generations.clear();
+
+  acquired_token = completed_token;
+}
+
+bool UploadManager::IsComplete(UploadToken token) {
+  RetireBatches(false);
+
+  return acquired_token >= token;
+}
+
+void UploadManager::Wait(UploadToken token) {
+  if (recording && batches[current_batch].token <= token) {
+    Submit();
+  }
+
+  while (completed_token < token && !pending_batches.empty()) {
+    RetireBatches(true);
+  }
+
+  if (acquired_token >= token || !ownership_transfer) {
+    return;
+  }
+
+  acquire_command_buffer->Begin();
+  AcquireUploads(*acquire_command_buffer);
+  acquire_command_buffer->End();
+  acquire_command_buffer->SoloExecute();
+  acquire_command_buffer->Reset();
+}
+
+uint64_t UploadManager::GetTimelineValue(UploadToken token) {
+  if (recording && batches[current_batch].token <= token) {
+    Submit();
+  }
+
+  // tokens of retired batches are already reached
+  uint64_t value = 0;
+  for (uint32_t batch_index : pending_batches) {
+    Batch &batch = batches[batch_index];
+    if (batch.token > token) {
+      break;
+    }
+
+    value = batch.timeline_value;
+  }
+
+  return value;
+}
+
+GpuTimeline &UploadManager::GetTimeline() { return *timeline; }
+
+} // namespace vk
@@ -0,0 +1,156 @@
+#pragma once
+#include "barrier.hpp"
+#include "barrier_batch.hpp"
+#include "buffer.hpp"
+#include "command_buffer.hpp"
+#include "command_pool.hpp"
+#include "device.hpp"
+#include "image.hpp"
+#include "queue.hpp"
+#include <deque>
+#include <memory>
+#include <span>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+using namespace std;
+
+namespace vk {
+
+// increases with every batch, upload is finished when its batch token is
+typedef uint64_t UploadToken;
+
+struct UploadManagerCreateInfo {
+  Queue queue;
+  // queue which uses uploaded resources, when its family differs ownership
+  // is released after copies and acquired by AcquireUploads
+  Queue dst_queue;
+  VkDeviceSize ring_size;
+  uint32_t max_batches = 4;
+};
+
+// copies data to buffers and images through one persistently mapped
+// staging ring, all copies between two submits go in one command buffer
+class UploadManager {
+private:
+  struct MipGeneration {
+    Image *image;
+    uint32_t first_level;
+    DstImageBarrier dst_barrier;
+  };
+
+  // copy staged in ring, recorded with other images of the batch after one
+  // call with all their preload transitions
+  struct ImageCopy {
+    Image *image;
+    vector<VkBufferImageCopy> regions;
+    DstImageBarrier dst_barrier;
+  };
+
+  struct Batch {
+    unique_ptr<CommandBuffer> command_buffer;
+    // value of upload queue timeline signaled when batch is finished
+    uint64_t timeline_value;
+    UploadToken token;
+    VkDeviceSize begin;
+
+    unique_ptr<BarrierBatch> acquires;
+    // blits which upload queue can not do, recorded after acquires
+    vector<MipGeneration> mip_generations;
+  };
+
+  Device *device;
+  Queue queue;
+  Queue dst_queue;
+  bool ownership_transfer;
+  bool can_blit;
+  GpuTimeline *timeline;
+
+  unique_ptr<CommandPool> command_pool;
+  unique_ptr<Buffer> ring_buffer;
+  char *mapped_data;
+  VkDeviceSize ring_size;
+  VkDeviceSize head;
+  VkDeviceSize min_alignment;
+
+  vector<Batch> batches;
+  vector<uint32_t> free_batches;
+  deque<uint32_t> pending_batches;
+  uint32_t current_batch;
+  bool recording;
+
+  UploadToken next_token;
+  UploadToken completed_token;
+  // completed and owned by dst queue family
+  UploadToken acquired_token;
+
+  // barriers of recording batch, flushed before next copy needing them
+  unique_ptr<BarrierBatch> barriers;
+  // transitions to transfer dst of image_copies
+  unique_ptr<BarrierBatch> preloads;
+  vector<ImageCopy> image_copies;
+  // acquires of retired batches not recorded on dst queue yet
+  unique_ptr<BarrierBatch> acquires;
+  vector<MipGeneration> mip_generations;
+
+  unique_ptr<CommandPool> acquire_command_pool;
+  unique_ptr<CommandBuffer> acquire_command_buffer;
+
+  void CreateRingBuffer(VkDeviceSize size);
+  void CreateBatches(uint32_t count);
+
+  bool IsRingEmpty();
+  bool TryAllocate(VkDeviceSize size, VkDeviceSize alignment,
+                   VkDeviceSize &offset);
+  VkDeviceSize Allocate(VkDeviceSize size, VkDeviceSize alignment);
+  VkDeviceSize Stage(span<const char> data, VkDeviceSize alignment);
+  void StageLevels(span<const span<const char>> levels,
+                   vector<VkDeviceSize> &offsets);
+
+  void BeginBatch();
+  void RecordImageCopies();
+  void RecordImageCopy(ImageCopy &image_copy);
+  void RetireBatches(bool wait_oldest);
+  void ReleaseBuffer(Buffer &buffer, VkDeviceSize offset, VkDeviceSize size);
+  void ReleaseImage(Image &image, DstImageBarrier dst_barrier);
+  // barriers to dst_barrier are left in mip_barriers for caller to flush
+  void GenerateMips(CommandBuffer &command_buffer, Image &image,
+                    uint32_t first_level, DstImageBarrier dst_barrier,
+                    BarrierBatch &mip_barriers);
+
+public:
+  UploadManager(Device &device, UploadManagerCreateInfo &create_info);
+  UploadManager(UploadManager &) = delete;
+  UploadManager &operator=(UploadManager &) = delete;
+  ~UploadManager();
+
+  void Destroy();
+
+  UploadToken CopyToBuffer(Buffer &buffer, span<const char> data,
+                           VkDeviceSize dst_offset = 0);
+  // data is level 0, other mip levels are blitted from it, image ends in
+  // dst_barrier layout, ready for dst_barrier stage
+  UploadToken CopyToImage(Image &image, span<const char> data,
+                          DstImageBarrier dst_barrier);
+  // levels are written from level 0, rest of the mip chain is blitted
+  UploadToken CopyToImage(Image &image, span<const span<const char>> levels,
+                          DstImageBarrier dst_barrier);
+
+  // submits recorded copies without waiting, returns token of the batch
+  UploadToken Submit();
+
+  // records ownership acquires of finished uploads, must be called once per
+  // frame on dst queue before uploaded resources are used
+  void AcquireUploads(CommandBuffer &command_buffer);
+
+  bool IsComplete(UploadToken token);
+  // after return resources can be used on dst queue
+  void Wait(UploadToken token);
+
+  // upload queue timeline value of submitted token, lets other queues wait
+  // for copies on gpu, ownership still has to be acquired
+  uint64_t GetTimelineValue(UploadToken token);
+  GpuTimeline &GetTimeline();
+};
+
+} // namespace vk
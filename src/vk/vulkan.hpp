@@ -7,17 +7,35 @@
 #include "queue.hpp"
 #include "command_buffer.hpp"
 #include "command_pool.hpp"
+#include "command_buffer_cache.hpp"
+#include "command_arena.hpp"
+#include "push_constants.hpp"
+#include "job_system.hpp"
 
 #include "shader_module.hpp"
+#include "specialization_constants.hpp"
+#include "graphics_pipeline_builder.hpp"
+#include "compute_pipeline_builder.hpp"
+#include "pipeline_warmup.hpp"
+#include "shader_watcher.hpp"
 #include "swapchain.hpp"
 
 #include "device_memory.hpp"
+#include "memory_manager.hpp"
+#include "memory_statistics.hpp"
+#include "frame_allocator.hpp"
+#include "defragmenter.hpp"
 
 #include "image.hpp"
 #include "image_view.hpp"
 #include "texture.hpp"
+#include "texture_loader.hpp"
+#include "ktx2.hpp"
 
 #include "buffer.hpp"
-#include "staging_buffer.hpp"
+#include "upload_manager.hpp"
 
+#include "barrier_batch.hpp"
+#include "gpu_timeline.hpp"
+#include "render_graph.hpp"
 #include "semaphore.hpp"
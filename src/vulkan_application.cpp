@@ -1,14 +1,39 @@
 #include "vulkan_application.hpp"
 
-VulkanApplication::VulkanApplication() {}
+VulkanApplication::VulkanApplication(uint32_t frames_in_flight,
+                                     uint32_t record_threads) {
+  this->frames_in_flight = frames_in_flight;
+  frame_statistics.record_threads = record_threads;
+}
 
 VulkanApplication::~VulkanApplication() {
+  // frames in flight may still use resources below
+  vkDeviceWaitIdle(device->GetHandle());
 
   CleanupFramebuffers();
 
   CleanupSyncObjects();
+  CleanupFrames();
+
+  render_graph.reset();
+  imgui_renderer.reset();
+  car_renderer.reset();
+  texture_renderer.reset();
+  shader_watcher.reset();
+  pipeline_warmup.reset();
+  command_arena.reset();
+  job_system.reset();
+
+  pheromone_map_view.reset();
+  pheromone_map_image.reset();
+
+  vkDestroyRenderPass(device->GetHandle(), ui_render_pass, nullptr);
+  vkDestroyRenderPass(device->GetHandle(), pheromone_render_pass, nullptr);
 
-  car_texture->Destroy();
+  texture_loader.reset();
+  frame_allocator.reset();
+  defragmenter.reset();
+  upload_manager.reset();
 
   swapchain->Dispose();
 
@@ -30,6 +55,8 @@ void VulkanApplication::InitVulkan(uint32_t glfw_extensions_count,
 }
 
 void VulkanApplication::Prepare() {
+  prepare_start = chrono::high_resolution_clock::now();
+
   window = unique_ptr<Window>(new Window());
 
   uint32_t glfw_extensions_count;
@@ -45,27 +72,55 @@ void VulkanApplication::Prepare() {
 
   swapchain = make_unique<vk::Swapchain>(*device, window->GetSurface());
 
+  CreateFrames();
   CreateSyncObjects();
 
+  CreatePipelineWarmup();
+  CreateCommandArena();
+  CreateFrameAllocator();
+  CreateDefragmenter();
+  CreateUploadManager();
+  CreateTextureLoader();
+
   CreateTextureRenderPass();
+  CreateUiRenderPass();
   
   CreateFramebuffers();
+  CreateImguiRenderer();
+
+  CreatePheromoneMap();
+  CreateTextureRenderer();
+  CreateCarRenderer();
+  CreateRenderGraph();
+
+  // renderers added their pipelines, frames wait only for ones they use
+  pipeline_warmup->Start();
+  CreateShaderWatcher();
 
   DEBUG("vulkan application prepared");
 }
 
-void VulkanApplication::CreateSyncObjects() {
-  VkSemaphoreCreateInfo semphore_create_info =
-      vk::semaphore_create_info_template;
+void VulkanApplication::CreateFrames() {
+  frames.resize(frames_in_flight);
 
-  VkFenceCreateInfo fence_create_info = vk::fence_create_info_template;
+  for (Frame &frame : frames) {
+    frame.command_buffer = nullptr;
+    // value 0 is always reached, so first wait on every slot returns at once
+    frame.timeline_value = 0;
+  }
+
+  current_frame = 0;
 
-  VkResult result = vkCreateFence(device->GetHandle(), &fence_create_info, nullptr, &fence);
-  if(result){
-	throw vk::CriticalException("cant create fence");
+  DEBUG("{0} frames in flight created", frames_in_flight);
+}
+
+void VulkanApplication::CreateSyncObjects() {
+  for (Frame &frame : frames) {
+    frame.image_available = make_unique<vk::Semaphore>(device.get());
+    frame.render_finished = make_unique<vk::Semaphore>(device.get());
   }
-  
-  TRACE("fence created");
+
+  TRACE("frame semaphores created");
 }
 
 void VulkanApplication::CreateTextureRenderer(){
@@ -74,15 +129,257 @@ void VulkanApplication::CreateTextureRenderer(){
   create_info.queue = graphics_queue;
   create_info.framebuffers = framebuffers;
   create_info.render_pass = pheromone_render_pass;
+  create_info.frames_in_flight = frames_in_flight;
   create_info.extent = swapchain->GetExtent();
   create_info.texture_view = pheromone_map_view.get();
+  create_info.pipeline_warmup = pipeline_warmup.get();
+
+  texture_renderer = make_unique<TextureRenderer>(device.get(), create_info);
+
+  // defragmenter moved pheromone map, view points at old image, which is
+  // destroyed after frames in flight together with retired view
+  pheromone_map_image->AddMoveCallback([this]() {
+    defragmenter->RetireImageView(pheromone_map_view->Recreate());
+    texture_renderer->SetTexture(pheromone_map_view.get());
+  });
 }
 
-void VulkanApplication::CleanupSyncObjects() {
+void VulkanApplication::CreateCarRenderer() {
+  car_view = &texture_loader->GetView(car_texture);
+
+  TextureRendererCreateInfo create_info;
+  create_info.device = device.get();
+  create_info.queue = graphics_queue;
+  create_info.framebuffers = framebuffers;
+  create_info.render_pass = pheromone_render_pass;
+  create_info.frames_in_flight = frames_in_flight;
+  create_info.extent = swapchain->GetExtent();
+  create_info.texture_view = car_view;
+  create_info.blend = true;
+  create_info.pipeline_warmup = pipeline_warmup.get();
+
+  car_renderer = make_unique<TextureRenderer>(device.get(), create_info);
+
+  Camera camera;
+  camera.pos = {0, 0};
+  camera.scale = 0.25f;
+  car_renderer->SetCamera(camera);
 
-  vkDestroyFence(device->GetHandle(), fence, nullptr);
+  // loader recreated view of moved car texture
+  texture_loader->AddMoveCallback(
+      car_texture, [this]() { car_renderer->SetTexture(car_view); });
+
+  AddSurfaceLayer([this](vk::CommandBuffer &command_buffer) {
+    car_renderer->Record(command_buffer);
+  });
 }
 
+void VulkanApplication::CreateImguiRenderer() {
+  ImguiRendererCreateInfo create_info;
+  create_info.instance = instance.get();
+  create_info.device = device.get();
+  create_info.queue = graphics_queue;
+  create_info.window = window.get();
+  create_info.swapchain_min_image_count = swapchain->GetMinImageCount();
+  create_info.framebuffers = framebuffers;
+  create_info.extent = swapchain->GetExtent();
+  create_info.render_pass = ui_render_pass;
+
+  imgui_renderer = make_unique<ImguiRenderer>(create_info);
+}
+
+void VulkanApplication::CreatePipelineWarmup() {
+  vk::PipelineWarmupCreateInfo create_info;
+
+  pipeline_warmup = make_unique<vk::PipelineWarmup>(*device, create_info);
+}
+
+void VulkanApplication::CreateShaderWatcher() {
+  vk::ShaderWatcherCreateInfo create_info;
+  create_info.directory = shaders_directory;
+  // renderers pick new pipelines up when they record next time
+  create_info.reload = [this](const fs::path &spirv_path) {
+    pipeline_warmup->Reload(spirv_path);
+  };
+
+  try {
+    shader_watcher = make_unique<vk::ShaderWatcher>(create_info);
+  } catch (vk::CriticalException &) {
+    WARN("shader hot reload disabled");
+  }
+}
+
+void VulkanApplication::CreateCommandArena() {
+  vk::JobSystemCreateInfo job_system_create_info;
+  job_system_create_info.thread_count = frame_statistics.record_threads;
+
+  job_system = make_unique<vk::JobSystem>(job_system_create_info);
+  frame_statistics.record_threads = job_system->GetThreadCount();
+
+  vk::CommandArenaCreateInfo create_info;
+  create_info.queue = graphics_queue;
+  create_info.frames_in_flight = frames_in_flight;
+  create_info.job_system = job_system.get();
+
+  command_arena = make_unique<vk::CommandArena>(*device, create_info);
+}
+
+void VulkanApplication::CreateFrameAllocator() {
+  vk::FrameAllocatorCreateInfo create_info;
+  create_info.frames_in_flight = frames_in_flight;
+  create_info.frame_size = frame_allocator_size;
+  create_info.queue = graphics_queue;
+  create_info.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT |
+                      VK_BUFFER_USAGE_VERTEX_BUFFER_BIT |
+                      VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+
+  frame_allocator = make_unique<vk::FrameAllocator>(*device, create_info);
+}
+
+void VulkanApplication::CreateDefragmenter() {
+  vk::DefragmenterCreateInfo create_info;
+  create_info.frames_in_flight = frames_in_flight;
+  create_info.max_bytes_per_frame = defragmentation_bytes_per_frame;
+
+  defragmenter = make_unique<vk::Defragmenter>(*device, create_info);
+}
+
+void VulkanApplication::CreateUploadManager() {
+  vk::UploadManagerCreateInfo create_info;
+  create_info.queue = transfer_queue;
+  create_info.dst_queue = graphics_queue;
+  create_info.ring_size = upload_ring_size;
+
+  upload_manager = make_unique<vk::UploadManager>(*device, create_info);
+}
+
+void VulkanApplication::CreateTextureLoader() {
+  vk::TextureLoaderCreateInfo create_info;
+  create_info.defragmenter = defragmenter.get();
+
+  texture_loader =
+      make_unique<vk::TextureLoader>(*device, *upload_manager, create_info);
+
+  // drawn with placeholder until decoded and uploaded
+  car_texture = texture_loader->Load("textures/car.png");
+}
+
+void VulkanApplication::CreateRenderGraph() {
+  render_graph = make_unique<vk::RenderGraph>(*device);
+
+  VkImageSubresourceRange surface_range = vk::image_subresource_range_template;
+  surface_range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+
+  surface_resource = render_graph->ImportImage("surface", surface_range);
+  render_graph->SetFinalAccess(surface_resource, vk::present_access);
+
+  pheromone_map_resource =
+      render_graph->ImportImage("pheromone map", *pheromone_map_image);
+
+  render_graph->AddPass("uploads").SetSideEffects().Record(
+      [this](vk::CommandBuffer &command_buffer) {
+        upload_manager->AcquireUploads(command_buffer);
+        defragmenter->Step(command_buffer);
+      });
+
+  // pheromone map is only sampled until simulation pass writing it exists
+  render_graph->AddPass("surface")
+      .Read(pheromone_map_resource, vk::fragment_sampled_access)
+      .Write(surface_resource, vk::color_attachment_access)
+      .Record([this](vk::CommandBuffer &command_buffer) {
+        VkClearValue clear_value = {{{0.0f, 0.0f, 0.0f, 1.0f}}};
+
+        VkRenderPassBeginInfo render_pass_begin_info =
+            vk::render_pass_begin_info_template;
+        render_pass_begin_info.renderPass = pheromone_render_pass;
+        render_pass_begin_info.framebuffer =
+            framebuffers[surface_image_index];
+        render_pass_begin_info.renderArea.offset = {0, 0};
+        render_pass_begin_info.renderArea.extent = swapchain->GetExtent();
+        render_pass_begin_info.clearValueCount = 1;
+        render_pass_begin_info.pClearValues = &clear_value;
+
+        vkCmdBeginRenderPass(command_buffer.GetHandle(),
+                             &render_pass_begin_info,
+                             VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+
+        // descriptor sets of this frame get views changed by defragmenter
+        texture_renderer->BeginFrame(current_frame);
+        car_renderer->BeginFrame(current_frame);
+
+        // recorded again only after pheromone view or surface changed
+        VkCommandBuffer texture_commands =
+            texture_renderer->Render(surface_image_index);
+        vkCmdExecuteCommands(command_buffer.GetHandle(), 1,
+                             &texture_commands);
+
+        vk::SecondaryRecordInfo record_info;
+        record_info.render_pass = pheromone_render_pass;
+        record_info.framebuffer = framebuffers[surface_image_index];
+        command_arena->RecordSecondary(command_buffer, record_info,
+                                       surface_layers);
+
+        vkCmdEndRenderPass(command_buffer.GetHandle());
+      });
+
+  // loads surface, so it is ordered after surface pass
+  render_graph->AddPass("ui")
+      .Write(surface_resource, vk::color_attachment_load_access)
+      .Record([this](vk::CommandBuffer &command_buffer) {
+        imgui_renderer->Record(command_buffer, surface_image_index);
+      });
+
+  render_graph->Compile();
+}
+
+vk::MemoryStatistics &VulkanApplication::GetMemoryStatistics() {
+  return device->GetMemoryManager().GetStatistics();
+}
+
+const FrameStatistics &VulkanApplication::GetFrameStatistics() {
+  return frame_statistics;
+}
+
+const vk::RenderGraphStatistics &VulkanApplication::GetRenderGraphStatistics() {
+  return render_graph->GetStatistics();
+}
+
+uint32_t VulkanApplication::GetFramesInFlight() { return frames_in_flight; }
+
+const SimulationConstants &VulkanApplication::GetSimulationConstants() {
+  return simulation_constants;
+}
+
+vector<vk::ShaderError> VulkanApplication::GetShaderErrors() {
+  if (shader_watcher == nullptr) {
+    return {};
+  }
+
+  return shader_watcher->GetErrors();
+}
+
+uint32_t VulkanApplication::GetShaderReloadCount() {
+  if (shader_watcher == nullptr) {
+    return 0;
+  }
+
+  return shader_watcher->GetReloadCount();
+}
+
+void VulkanApplication::AddSurfaceLayer(
+    function<void(vk::CommandBuffer &)> record) {
+  surface_layers.push_back(record);
+}
+
+void VulkanApplication::CleanupSyncObjects() {
+  for (Frame &frame : frames) {
+    frame.image_available.reset();
+    frame.render_finished.reset();
+  }
+}
+
+void VulkanApplication::CleanupFrames() { frames.clear(); }
+
 void VulkanApplication::ChangeSurface() {
   DEBUG("changing suface");
 
@@ -101,6 +398,10 @@ void VulkanApplication::ChangeSurface() {
   CleanupFramebuffers();
   CreateFramebuffers();
 
+  texture_renderer->SetFramebuffers(framebuffers, swapchain->GetExtent());
+  car_renderer->SetFramebuffers(framebuffers, swapchain->GetExtent());
+  imgui_renderer->SetFramebuffers(framebuffers, swapchain->GetExtent());
+
   surface_changed = true;
 }
 
@@ -108,22 +409,36 @@ void VulkanApplication::CreatePheromoneMap() {
   vk::ImageCreateInfo create_info;
   create_info.format = VK_FORMAT_R32_SFLOAT;
   create_info.layout = VK_IMAGE_LAYOUT_UNDEFINED;
-  create_info.size = map_size;
+  create_info.size = simulation_constants.map_size;
+  create_info.movable = true;
 
   pheromone_map_image = make_unique<vk::Image>(device.get(), create_info);
 
   pheromone_map_view = make_unique<vk::ImageView>(device.get(), pheromone_map_image.get());
-  
+
+  // starts empty and keeps its content, so defragmenter moves it as is
+  vector<char> empty_map(create_info.size.x * create_info.size.y *
+                         sizeof(float));
+
+  vk::DstImageBarrier dst_barrier;
+  dst_barrier.access = VK_ACCESS_SHADER_READ_BIT;
+  dst_barrier.layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+  dst_barrier.stage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+
+  upload_manager->Wait(upload_manager->CopyToImage(*pheromone_map_image,
+                                                   empty_map, dst_barrier));
 }
 
-void VulkanApplication::CreateTextureRenderPass() {
+VkRenderPass
+VulkanApplication::CreateSurfaceRenderPass(VkAttachmentLoadOp load_op) {
   VkAttachmentDescription surface_attachment =
       vk::attachment_description_template;
   surface_attachment.format = swapchain->GetFormat().format;
-  surface_attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+  surface_attachment.loadOp = load_op;
   surface_attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+  // render graph transitions surface before and after the pass
   surface_attachment.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-  surface_attachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+  surface_attachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
   VkAttachmentReference color_attachment_reference;
   color_attachment_reference.attachment = 0;
@@ -140,25 +455,242 @@ void VulkanApplication::CreateTextureRenderPass() {
   create_info.subpassCount = 1;
   create_info.pSubpasses = &subpass_description;
 
+  VkRenderPass render_pass;
   VkResult result = vkCreateRenderPass(device->GetHandle(), &create_info,
-                                       nullptr, &pheromone_render_pass);
+                                       nullptr, &render_pass);
   if (result) {
     throw vk::CriticalException("cant create render pass");
   }
 
+  return render_pass;
+}
+
+void VulkanApplication::CreateTextureRenderPass() {
+  pheromone_render_pass =
+      CreateSurfaceRenderPass(VK_ATTACHMENT_LOAD_OP_CLEAR);
+
   DEBUG("pheromone pass created");
 }
 
+void VulkanApplication::CreateUiRenderPass() {
+  ui_render_pass = CreateSurfaceRenderPass(VK_ATTACHMENT_LOAD_OP_LOAD);
+
+  DEBUG("ui pass created");
+}
+
 bool VulkanApplication::IsSurfaceChanged() {
-  return surface_changed;
+  bool changed = surface_changed;
   surface_changed = false;
+  return changed;
+}
+
+void VulkanApplication::Draw() {
+  // cpu side work overlaps with frames still executing on gpu
+  texture_loader->Update();
+
+  // placeholder is replaced once car texture is resident
+  vk::ImageView &view = texture_loader->GetView(car_texture);
+  if (&view != car_view) {
+    car_view = &view;
+    car_renderer->SetTexture(car_view);
+  }
+
+  Frame &frame = frames[current_frame];
+  WaitForFrame(frame);
+
+  uint32_t next_image_index;
+  try {
+    next_image_index =
+        swapchain->AcquireNextImage(frame.image_available->GetHandle());
+  } catch (vk::AcquireNextImageFailedException &exception) {
+    ChangeSurface();
+    return;
+  }
+
+  Render(next_image_index);
+  Present(next_image_index);
+
+  current_frame = (current_frame + 1) % frames_in_flight;
+}
+
+void VulkanApplication::BenchmarkRecording() {
+  vector<function<void(vk::CommandBuffer &)>> jobs;
+  for (uint32_t i = 0; i < benchmark_layer_copies; i++) {
+    jobs.insert(jobs.end(), surface_layers.begin(), surface_layers.end());
+  }
+
+  // layers take pipelines from warmup, compilation is not measured
+  pipeline_warmup->WaitIdle();
+
+  for (uint32_t thread_count = 1; thread_count <= benchmark_max_threads;
+       thread_count++) {
+    vk::JobSystemCreateInfo job_system_create_info;
+    job_system_create_info.thread_count = thread_count;
+    vk::JobSystem benchmark_job_system(job_system_create_info);
+
+    vk::CommandArenaCreateInfo create_info;
+    create_info.queue = graphics_queue;
+    create_info.frames_in_flight = 1;
+    create_info.job_system = &benchmark_job_system;
+    create_info.max_command_buffers = jobs.size();
+
+    vk::CommandArena arena(*device, create_info);
+
+    chrono::high_resolution_clock::time_point start =
+        chrono::high_resolution_clock::now();
+
+    for (uint32_t frame = 0; frame < benchmark_frames; frame++) {
+      // nothing is submitted, so pools are reset without waiting
+      arena.BeginFrame(0);
+
+      vk::CommandBuffer &command_buffer =
+          arena.Allocate(0, vk::CommandBufferLevel::primary);
+      command_buffer.Begin();
+
+      VkClearValue clear_value = {{{0.0f, 0.0f, 0.0f, 1.0f}}};
+
+      VkRenderPassBeginInfo render_pass_begin_info =
+          vk::render_pass_begin_info_template;
+      render_pass_begin_info.renderPass = pheromone_render_pass;
+      render_pass_begin_info.framebuffer = framebuffers[0];
+      render_pass_begin_info.renderArea.offset = {0, 0};
+      render_pass_begin_info.renderArea.extent = swapchain->GetExtent();
+      render_pass_begin_info.clearValueCount = 1;
+      render_pass_begin_info.pClearValues = &clear_value;
+
+      vkCmdBeginRenderPass(command_buffer.GetHandle(), &render_pass_begin_info,
+                           VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+
+      vk::SecondaryRecordInfo record_info;
+      record_info.render_pass = pheromone_render_pass;
+      record_info.framebuffer = framebuffers[0];
+      arena.RecordSecondary(command_buffer, record_info, jobs);
+
+      vkCmdEndRenderPass(command_buffer.GetHandle());
+      command_buffer.End();
+
+      arena.EndFrame(0);
+    }
+
+    float frame_time = chrono::duration<float, milli>(
+                           chrono::high_resolution_clock::now() - start)
+                           .count() /
+                       benchmark_frames;
+
+    INFO("recording {0} layers on {1} threads: {2} ms per frame", jobs.size(),
+         thread_count, frame_time);
+  }
 }
 
-void VulkanApplication::Draw() {}
+void VulkanApplication::WaitForFrame(Frame &frame) {
+  chrono::high_resolution_clock::time_point wait_start =
+      chrono::high_resolution_clock::now();
+
+  device->GetTimeline(graphics_queue).Wait(frame.timeline_value);
+
+  float wait_time = chrono::duration<float, milli>(
+                        chrono::high_resolution_clock::now() - wait_start)
+                        .count();
+
+  FrameStatistics &statistics = frame_statistics;
+  statistics.last_gpu_wait = wait_time;
+  statistics.max_gpu_wait = max(statistics.max_gpu_wait, wait_time);
+  statistics.average_gpu_wait =
+      statistics.frame_count == 0
+          ? wait_time
+          : statistics.average_gpu_wait +
+                (wait_time - statistics.average_gpu_wait) *
+                    statistics_smoothing;
+  statistics.frame_count++;
+}
+
+void VulkanApplication::Render(uint32_t next_image_index) {
+  Frame &frame = frames[current_frame];
+
+  RecordFrame(frame, next_image_index);
+
+  vk::GpuTimeline &timeline = device->GetTimeline(graphics_queue);
+  frame_allocator->EndFrame(timeline.GetNextValue());
+  command_arena->EndFrame(timeline.GetNextValue());
+
+  vk::TimelineSubmitInfo submit_info;
+  submit_info.command_buffers.push_back(frame.command_buffer->GetHandle());
+  submit_info.binary_waits.push_back(frame.image_available->GetHandle());
+  submit_info.binary_wait_stages.push_back(
+      VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+  submit_info.binary_signals.push_back(frame.render_finished->GetHandle());
+
+  frame.timeline_value = timeline.Submit(submit_info);
+}
+
+void VulkanApplication::RecordFrame(Frame &frame, uint32_t next_image_index) {
+  chrono::high_resolution_clock::time_point record_start =
+      chrono::high_resolution_clock::now();
+
+  frame_allocator->BeginFrame(current_frame);
+  command_arena->BeginFrame(current_frame);
+  // pipelines replaced by shader reload, renderers pick new ones up below
+  pipeline_warmup->Collect(device->GetTimeline(graphics_queue));
+
+  // pool of the arena was reset in bulk, so buffer needs no reset
+  frame.command_buffer =
+      &command_arena->Allocate(0, vk::CommandBufferLevel::primary);
+  vk::CommandBuffer &command_buffer = *frame.command_buffer;
+  command_buffer.Begin();
+
+  surface_image_index = next_image_index;
+  render_graph->SetImportedImage(surface_resource,
+                                 swapchain->GetImages()[next_image_index],
+                                 vk::acquired_access);
+  render_graph->Execute(command_buffer);
+
+  command_buffer.End();
+
+  if (!first_frame_recorded) {
+    first_frame_recorded = true;
+
+    // warm start creates pipelines from cached data without compilation
+    float startup_time =
+        chrono::duration<float, milli>(chrono::high_resolution_clock::now() -
+                                       prepare_start)
+            .count();
+    INFO("first frame recorded {0} ms after start, {1} start", startup_time,
+         device->GetPipelineCache().IsWarm() ? "warm" : "cold");
+  }
 
-void VulkanApplication::Render(uint32_t next_image_index) {}
+  float record_time = chrono::duration<float, milli>(
+                          chrono::high_resolution_clock::now() - record_start)
+                          .count();
 
-void VulkanApplication::Present(uint32_t next_image_index) {}
+  FrameStatistics &statistics = frame_statistics;
+  statistics.last_record_time = record_time;
+  statistics.average_record_time =
+      statistics.average_record_time +
+      (record_time - statistics.average_record_time) * statistics_smoothing;
+}
+
+void VulkanApplication::Present(uint32_t next_image_index) {
+  Frame &frame = frames[current_frame];
+  VkSwapchainKHR swapchain_handle = swapchain->GetHandle();
+
+  VkPresentInfoKHR present_info = vk::present_info_template;
+  present_info.waitSemaphoreCount = 1;
+  present_info.pWaitSemaphores = &frame.render_finished->GetHandle();
+  present_info.swapchainCount = 1;
+  present_info.pSwapchains = &swapchain_handle;
+  present_info.pImageIndices = &next_image_index;
+  present_info.pResults = nullptr;
+
+  VkResult result = vkQueuePresentKHR(graphics_queue.GetHandle(), &present_info);
+  if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) {
+    ChangeSurface();
+    return;
+  }
+
+  if (result) {
+    throw vk::PresentFailedException();
+  }
+}
 
 void VulkanApplication::CreateFramebuffers() {
   VkFramebufferCreateInfo create_info = vk::framebuffer_create_info_template;
@@ -211,8 +743,27 @@ void VulkanApplication::CreateDevice() {
   graphics_queue_request.flags = VK_QUEUE_GRAPHICS_BIT;
   graphics_queue_request.queue = &graphics_queue;
 
+  // uploads run next to rendering on a copy engine when device has one
+  vk::DeviceCreateInfo::QueueRequest transfer_queue_request;
+  transfer_queue_request.flags = VK_QUEUE_TRANSFER_BIT;
+  transfer_queue_request.avoided_flags =
+      VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT;
+  transfer_queue_request.queue = &transfer_queue;
+
+  vk::DeviceCreateInfo::QueueRequest compute_queue_request;
+  compute_queue_request.flags = VK_QUEUE_COMPUTE_BIT;
+  compute_queue_request.avoided_flags = VK_QUEUE_GRAPHICS_BIT;
+  compute_queue_request.queue = &compute_queue;
+
   vk::DeviceCreateInfo create_info;
   create_info.queue_requests.push_back(graphics_queue_request);
+  create_info.queue_requests.push_back(transfer_queue_request);
+  create_info.queue_requests.push_back(compute_queue_request);
+  create_info.optional_extensions.push_back(
+      VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+  create_info.optional_extensions.push_back(
+      VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME);
+  create_info.pipeline_cache_path = pipeline_cache_path;
 
   device = unique_ptr<vk::Device>(new vk::Device(physical_device, create_info));
 }
@@ -2,18 +2,46 @@
 #include "logs.hpp"
 #include "window.hpp"
 #include <chrono>
+#include <functional>
 #include <memory>
 
 #include <stb_image.h>
 
 #include "vk/vulkan.hpp"
+#include "imgui_renderer.hpp"
 #include "texture_renderer.hpp"
 
 using namespace std;
 
+struct FrameStatistics {
+  uint64_t frame_count = 0;
+  // time cpu spent blocked on previous frames of a slot, in milliseconds
+  float last_gpu_wait = 0;
+  float average_gpu_wait = 0;
+  float max_gpu_wait = 0;
+  // time cpu spent recording frame command buffers, in milliseconds
+  float last_record_time = 0;
+  float average_record_time = 0;
+  uint32_t record_threads = 0;
+};
+
 class VulkanApplication {
 private:
-  VkFence fence;
+  // resources of one frame slot, reused after graphics timeline reached
+  // value of its last submit
+  struct Frame {
+    // allocated from command arena every frame
+    vk::CommandBuffer *command_buffer;
+    unique_ptr<vk::Semaphore> image_available;
+    unique_ptr<vk::Semaphore> render_finished;
+    uint64_t timeline_value;
+  };
+
+  uint32_t frames_in_flight;
+  vector<Frame> frames;
+  uint32_t current_frame = 0;
+
+  FrameStatistics frame_statistics;
 
   unique_ptr<vk::Instance> instance;
   unique_ptr<vk::Device> device;
@@ -23,27 +51,82 @@ private:
   unique_ptr<vk::Swapchain> swapchain;
 
   vk::Queue graphics_queue;
+  vk::Queue transfer_queue;
+  vk::Queue compute_queue;
 
-  unique_ptr<vk::Texture> car_texture;
+  vk::TextureHandle car_texture;
 
   unique_ptr<vk::Image> pheromone_map_image;
   unique_ptr<vk::ImageView> pheromone_map_view;
 
+  // compiles pipelines of all renderers at once after they are created
+  unique_ptr<vk::PipelineWarmup> pipeline_warmup;
+  // null when shaders directory can not be watched
+  unique_ptr<vk::ShaderWatcher> shader_watcher;
   unique_ptr<TextureRenderer> texture_renderer;
+  // car sprite, recorded every frame as surface layer
+  unique_ptr<TextureRenderer> car_renderer;
+  vk::ImageView *car_view = nullptr;
+  // draws ui built by last ImGui::Render over the surface
+  unique_ptr<ImguiRenderer> imgui_renderer;
+
+  unique_ptr<vk::FrameAllocator> frame_allocator;
+  unique_ptr<vk::Defragmenter> defragmenter;
+  unique_ptr<vk::UploadManager> upload_manager;
+  unique_ptr<vk::TextureLoader> texture_loader;
+
+  unique_ptr<vk::JobSystem> job_system;
+  unique_ptr<vk::CommandArena> command_arena;
+  // recorded in parallel into secondary command buffers of surface pass
+  vector<function<void(vk::CommandBuffer &)>> surface_layers;
+
+  unique_ptr<vk::RenderGraph> render_graph;
+  vk::RenderResource surface_resource;
+  vk::RenderResource pheromone_map_resource;
+  // swapchain image recorded by current frame
+  uint32_t surface_image_index = 0;
   
   VkRenderPass pheromone_render_pass;
+  // same attachment as pheromone pass, so it uses the same framebuffers
+  VkRenderPass ui_render_pass;
   
   bool surface_changed = false;
 
-  static constexpr glm::ivec2 map_size = {100, 100};
+  // startup is logged once first frame got its pipelines from warmup
+  chrono::high_resolution_clock::time_point prepare_start;
+  bool first_frame_recorded = false;
+
+  // changing them compiles new pipeline variants, old ones stay cached
+  static constexpr SimulationConstants simulation_constants = {
+      .map_size = {100, 100},
+      .workgroup_size = 16,
+      .diffusion_radius = 1,
+      .agent_type_count = 1,
+  };
+  static constexpr uint32_t default_frames_in_flight = 2;
+  static constexpr float statistics_smoothing = 0.05;
+  static constexpr VkDeviceSize frame_allocator_size = 4 * 1024 * 1024;
+  static constexpr VkDeviceSize defragmentation_bytes_per_frame =
+      8 * 1024 * 1024;
+  static constexpr VkDeviceSize upload_ring_size = 32 * 1024 * 1024;
+  static constexpr const char *pipeline_cache_path = "pipeline_cache.bin";
+  static constexpr const char *shaders_directory = "shaders";
+  // copies of every surface layer recorded per benchmark frame
+  static constexpr uint32_t benchmark_layer_copies = 256;
+  static constexpr uint32_t benchmark_frames = 100;
+  static constexpr uint32_t benchmark_max_threads = 16;
   
   void CreateFramebuffers();
   void CreateSyncObjects();
+  void CreateFrames();
 
+  void WaitForFrame(Frame &frame);
   void Render(uint32_t next_image_index);
+  void RecordFrame(Frame &frame, uint32_t next_image_index);
   void Present(uint32_t next_image_index);
 
   void CleanupSyncObjects();
+  void CleanupFrames();
   void CleanupFramebuffers();
 
   void CreateInstance(uint32_t glfw_extensions_count,
@@ -52,9 +135,22 @@ private:
 
   void CreatePheromoneMap();
   
+  VkRenderPass CreateSurfaceRenderPass(VkAttachmentLoadOp load_op);
   void CreateTextureRenderPass();
+  void CreateUiRenderPass();
 
+  void CreatePipelineWarmup();
+  void CreateShaderWatcher();
   void CreateTextureRenderer();
+  void CreateCarRenderer();
+  void CreateImguiRenderer();
+
+  void CreateCommandArena();
+  void CreateFrameAllocator();
+  void CreateDefragmenter();
+  void CreateUploadManager();
+  void CreateTextureLoader();
+  void CreateRenderGraph();
   
   void ChangeSurface();
 
@@ -66,10 +162,30 @@ protected:
 
   bool IsSurfaceChanged();
 
+  vk::MemoryStatistics &GetMemoryStatistics();
+  const FrameStatistics &GetFrameStatistics();
+  const vk::RenderGraphStatistics &GetRenderGraphStatistics();
+  uint32_t GetFramesInFlight();
+  // specialization of simulation kernels
+  const SimulationConstants &GetSimulationConstants();
+  // failed compiles of changed shaders, empty without hot reload
+  vector<vk::ShaderError> GetShaderErrors();
+  uint32_t GetShaderReloadCount();
+
+  // layer draws are recorded in render pass of the surface, each on a job
+  // system thread
+  void AddSurfaceLayer(function<void(vk::CommandBuffer &)> record);
+
   void Draw();
 
+  // records surface layers on 1 to 16 threads without submitting them and
+  // logs time per frame for each thread count
+  void BenchmarkRecording();
+
 public:
-  VulkanApplication();
+  // 0 record threads uses every hardware thread
+  VulkanApplication(uint32_t frames_in_flight = default_frames_in_flight,
+                    uint32_t record_threads = 0);
   VulkanApplication(VulkanApplication &) = delete;
   VulkanApplication &operator=(VulkanApplication &) = delete;
   ~VulkanApplication();